@@ -1,9 +1,13 @@
 /* See license.txt for license information. */
 #include "mywisp.h"
-#if (ACTIVE_SENSOR == SENSOR_ACCEL)
+#if ACCEL_PERIOD
 
 #include "dlwisp41.h"
 #include "accel_sensor.h"
+#include "adc_seq.h"
+#include "pack.h"
+#include "payload.h"
+#include "settle.h"
 
 #if DEBUG_BAD_SAMPLES
 short lastx = 0xffff, lasty = 0xffff, lastz = 0xffff;
@@ -11,21 +15,12 @@ short x = 0xffff, y = 0xffff, z = 0xffff;
 short diff = 0;
 #endif
 
-void init_sensor()
-{
-        return;
-}
+#if REPORT_ON_CHANGE
+static unsigned short accel_ref[ACCEL_DATA_WORDS] = { PAYLOAD_REF_NONE };
+#endif
 
-#if 1
-void read_sensor(unsigned char volatile *target)
-{  
-        unsigned short enough_power;
-  
-        if(!is_power_good())
-          sleep(); 
-        
-        P1OUT &= ~RX_EN_PIN;   // turn off comparator
-     
+static void accel_start()
+{
         // slow down clock
         BCSCTL1 = XT2OFF + RSEL3; 
         DCOCTL = DCO2 + DCO1 + DCO0;
@@ -34,7 +29,25 @@ void read_sensor(unsigned char volatile *target)
         ADC10AE0 |= (X_INCH + Y_INCH + Z_INCH);
         SET_ACCEL_ENABLE_DIR;
         TURN_ON_ACCEL_ENABLE;
-        
+}
+
+#if 1
+static unsigned char accel_collect(unsigned char volatile *target)
+{  
+#if CHECK_FOR_GOOD_VOLTAGE
+        unsigned short enough_power;
+#endif
+  
+#if ADAPTIVE_SETTLE
+        P1IE = 0;
+        P2IE = 0;
+#if CHECK_FOR_GOOD_VOLTAGE
+        enough_power = is_power_good();
+#endif
+        // sleep until the outputs stop moving, 10 ms at most
+        settle_sensor(ACCEL_DATA_WORDS,
+                      ADC10DIV_4 + ADC10SSEL_0 + SHS_0 + X_INCH, 46);
+#else
         // set up watchdog interval timer to sleep during settle time
         WDTCTL = WDT_MDLY_0_5;
         IE1 |= WDTIE;
@@ -58,6 +71,7 @@ void read_sensor(unsigned char volatile *target)
           //DEBUG_PIN5_LOW;
         }
         IE1 &= ~WDTIE;
+#endif // ADAPTIVE_SETTLE
 
 #if CHECK_FOR_GOOD_VOLTAGE
         // make sure there's enough voltage to generate good samples. samples
@@ -78,40 +92,24 @@ void read_sensor(unsigned char volatile *target)
         }
 #endif
         
-        // grab data
-        for (int i = (DATA_LENGTH_IN_WORDS-1); i >= 0; i--)
-        {
-        
-          ADC10CTL0 &= ~ENC; // make sure this is off otherwise settings are locked.
-          ADC10CTL0 = SREF_0 + ADC10SHT_3 + ADC10ON + ADC10IE;
-          if (i == 2)
-            // sample Z channel first, because it is the most noisy
-            ADC10CTL1 = ADC10DIV_4 + ADC10SSEL_0 + SHS_0 + CONSEQ_0 + Z_INCH;
-          else if (i == 1)
-            ADC10CTL1 = ADC10DIV_4 + ADC10SSEL_0 + SHS_0 + CONSEQ_0 + Y_INCH;
-          else
-            ADC10CTL1 = ADC10DIV_4 + ADC10SSEL_0 + SHS_0 + CONSEQ_0 + X_INCH;
-          ADC10CTL0 |= ENC;
-          ADC10CTL0 |= ADC10SC;
-          LPM4;
-          
-          unsigned int k;
-          if ( i == 0 ) k = 0;
-          else if ( i == 1 ) k = 2;
-          else k = 4;
-          
-          // grab sample and write it to ram
-          *(target + k + 1 ) = (ADC10MEM & 0xff);
-          *(target + k) = (ADC10MEM & 0x0300) >> 8;
-          
+        // grab data: one sequence converts X (A2), Y (A1) and Z (A0), and the
+        // DTC drops them into samples[] in that order
+        unsigned short samples[ACCEL_DATA_WORDS];
+        adc_seq_read(samples, ACCEL_DATA_WORDS, SREF_0 + ADC10SHT_3,
+                     ADC10DIV_4 + ADC10SSEL_0 + SHS_0 + X_INCH);
+
+#if REPORT_ON_CHANGE
+        unsigned char changed = payload_changed(accel_ref, samples,
+                                                ACCEL_DATA_WORDS);
+        if ( changed )
+#endif
+        pack_samples(target, samples, ACCEL_DATA_WORDS);
+
 #if DEBUG_BAD_SAMPLES
-          if ( i == 0 ) x = ADC10MEM;
-          else if ( i == 1 ) y = ADC10MEM;
-          else z = ADC10MEM;
+        x = samples[0];
+        y = samples[1];
+        z = samples[2];
 #endif
-            
-          k += 2;
-        }
         
 #if DEBUG_BAD_SAMPLES
 //#define THRES 50 // about 5% ... never fires
@@ -148,20 +146,19 @@ void read_sensor(unsigned char volatile *target)
         ADC10CTL1 = 0;       // turn adc off
         ADC10CTL0 = 0;       // turn adc off
          
-        //return 1;
+#if REPORT_ON_CHANGE
+        return changed;
+#else
+        return 1;
+#endif
 }
 #endif
 
 #if 0
-void read_sensor(unsigned char volatile *target) 
+static unsigned char accel_collect(unsigned char volatile *target) 
 {
         static short cntr = 0;
         
-        if(!is_power_good())
-          sleep(); 
-        
-        P1OUT &= ~RX_EN_PIN;   // turn off comparator
-        
         // set up watchdog interval timer to sleep during settle time
         WDTCTL = WDT_MDLY_0_5;
         IE1 |= WDTIE;
@@ -210,25 +207,21 @@ void read_sensor(unsigned char volatile *target)
         
         
         
-        //return 1;
+        return 1;
 }
 #endif
 
-// used to sleep while taking adc, this wakes us
-#pragma vector=ADC10_VECTOR
-__interrupt void ADC10_ISR (void)
-{
-      ADC10CTL0 &= ~ENC; // make sure this is off otherwise settings are locked.
-      ADC10CTL0 &= ~(ADC10IFG | ADC10IE);
-      LPM4_EXIT;
-      return;
-}
+const sensor_driver accel_driver = {
+  ACCEL_TYPE_ID, ACCEL_DATA_BYTES, 0, accel_start, accel_collect
+};
 
+#if !ADAPTIVE_SETTLE // settle.c has the watchdog interrupt then
 #pragma vector=WDT_VECTOR
 __interrupt void wdt_ISR( void )
 {
       LPM4_EXIT;
       return;
 }
+#endif
 
-#endif // (ACTIVE_SENSOR == SENSOR_ACCEL)
+#endif // ACCEL_PERIOD
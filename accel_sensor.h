@@ -5,7 +5,7 @@
 
 // these bit definitions are specific to WISP 4.1 DL
 
-#define SENSOR_DATA_TYPE_ID       0x0D
+#define ACCEL_TYPE_ID             0x0D
 
 #define ACCEL_ENABLE_BIT          BIT5   // 1.5
 #define SET_ACCEL_ENABLE_DIR      P1DIR |= ACCEL_ENABLE_BIT
@@ -17,8 +17,27 @@
 #define Y_INCH                    INCH_1  // A1
 #define Z_INCH                    INCH_0  // A0
 
-#define DATA_LENGTH_IN_WORDS      3
-#define DATA_LENGTH_IN_BYTES      (DATA_LENGTH_IN_WORDS*2)
+#define ACCEL_DATA_WORDS          3
+#define ACCEL_DATA_BYTES          PACKED_BYTES(ACCEL_DATA_WORDS)
+
+extern const sensor_driver accel_driver;
+
+#if (ACTIVE_SENSOR == SENSOR_ACCEL)
+#define SENSOR_DATA_TYPE_ID       ACCEL_TYPE_ID
+
+// BACKGROUND_SAMPLING settings (see sampler.h)
+#define SENSOR_POWER_ON \
+  do { SET_ACCEL_ENABLE_DIR; TURN_ON_ACCEL_ENABLE; } while (0)
+#define SENSOR_POWER_OFF \
+  do { CLEAR_ACCEL_ENABLE_DIR; TURN_OFF_ACCEL_ENABLE; } while (0)
+#define SAMPLE_CHANNELS           3
+#define SAMPLE_SEQ_INCH           X_INCH
+#define SAMPLE_SEQ_LEN            3
+#define SAMPLE_SLOT_LIST          0, 1, 2
+#define SAMPLE_ADC10AE            (ACCEL_X | ACCEL_Y | ACCEL_Z)
+#define SAMPLE_ADC10CTL0          (SREF_0 + ADC10SHT_3)
+#define SAMPLE_ADC10CTL1          (ADC10DIV_4 + ADC10SSEL_0)
+#endif
 
 #define CHECK_FOR_GOOD_VOLTAGE    0
 #define DEBUG_BAD_SAMPLES         0
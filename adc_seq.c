@@ -0,0 +1,147 @@
+/* See license.txt for license information. */
+
+#include "dlwisp41.h"
+#include "mywisp.h"
+#include "adc_seq.h"
+#include "i2c.h"
+
+volatile unsigned char adc_seq_busy = 0;
+static volatile unsigned char adc_seq_wake = 0; // someone is asleep waiting
+
+// adc_seq_sum(): where the sums go, the two DTC blocks, and how far along
+static unsigned short *adc_seq_sums;
+static unsigned short *adc_seq_blocks;
+static unsigned char adc_seq_n;
+static unsigned char adc_seq_skip;
+static unsigned char adc_seq_blocks_in;
+static unsigned char adc_seq_blocks_left;
+
+// Arm a DTC transfer of words results per block and start converting.
+// dtc0 is 0 for one block, one shot, or ADC10TB + ADC10CT for two blocks
+// filled in turn until the ADC is turned off.
+static void adc_seq_arm(unsigned short *dest, unsigned char words,
+                        unsigned char dtc0, unsigned short ctl0,
+                        unsigned short ctl1)
+{
+  ADC10CTL0 &= ~ENC; // make sure this is off otherwise settings are locked.
+  ADC10CTL0 = ctl0 + MSC + ADC10ON + ADC10IE;
+  ADC10CTL1 = ctl1;
+
+  // Writing ADC10SA arms the DTC.
+  ADC10DTC0 = dtc0;
+  ADC10DTC1 = words;
+  ADC10SA = (unsigned short)dest;
+
+  adc_seq_busy = 1;
+  ADC10CTL0 |= ENC + ADC10SC;
+}
+
+// Sleep until the block is in. GIE stays off between checking adc_seq_busy
+// and going to sleep, so the interrupt can't slip in between and leave us
+// asleep for good. The DTC restarts MCLK by itself for each transfer, but
+// the clocks anything else runs off have to stay up, as in
+// setup_to_receive(): SMCLK for a queued I2C transfer, ACLK for the sample
+// clocks, the scheduler and DCO calibration.
+static void adc_seq_wait()
+{
+  while ( adc_seq_busy )
+  {
+    if ( I2C_BUSY )
+      _BIS_SR(LPM0_bits + GIE);
+    else
+#if ACLK_WHILE_LISTENING
+      _BIS_SR(LPM3_bits + GIE);
+#else
+      _BIS_SR(LPM4_bits + GIE);
+#endif
+    _BIC_SR(GIE);
+  }
+  _BIS_SR(GIE);
+}
+
+void adc_seq_start(unsigned short *dest, unsigned char n,
+                   unsigned short ctl0, unsigned short ctl1)
+{
+  adc_seq_arm(dest, n, 0, ctl0, ctl1 + CONSEQ_1);
+}
+
+void adc_seq_read(unsigned short *dest, unsigned char n,
+                  unsigned short ctl0, unsigned short ctl1)
+{
+  _BIC_SR(GIE);
+  adc_seq_wake = 1;
+  adc_seq_arm(dest, n, 0, ctl0, ctl1 + CONSEQ_1);
+  adc_seq_wait();
+}
+
+void adc_seq_sum(unsigned short *sum, unsigned short *blocks, unsigned char n,
+                 unsigned char skip, unsigned char count,
+                 unsigned short ctl0, unsigned short ctl1)
+{
+  adc_seq_sums = sum;
+  adc_seq_blocks = blocks;
+  adc_seq_n = n;
+  adc_seq_skip = skip;
+  adc_seq_blocks_in = 0;
+  adc_seq_blocks_left = skip + count;
+
+  // repeat-sequence mode runs until the interrupt turns the ADC off
+  _BIC_SR(GIE);
+  adc_seq_wake = 1;
+  adc_seq_arm(blocks, n * ADC_SEQ_SUM_PASSES, ADC10TB + ADC10CT, ctl0,
+              ctl1 + CONSEQ_3);
+  adc_seq_wait();
+}
+
+void adc_seq_abort()
+{
+  // a sequence stops at its end once ENC is cleared, a few conversions at
+  // most. Polled, since the caller may have GIE off.
+  ADC10CTL0 &= ~ENC;
+  while (ADC10CTL1 & ADC10BUSY);
+  ADC10CTL0 = 0;     // turn adc off, clears ADC10IFG and ADC10IE too
+  ADC10DTC1 = 0;     // and the DTC with it
+  adc_seq_busy = 0;
+  adc_seq_wake = 0;
+}
+
+#if !ECG_HW_CLOCK // ecg_clock.c has the ADC10 to itself then
+
+// end of a DTC block: the whole sequence is in memory, or for
+// adc_seq_sum() another ADC_SEQ_SUM_PASSES of them
+#pragma vector=ADC10_VECTOR
+__interrupt void ADC10_ISR (void)
+{
+  if ( ADC10DTC0 & ADC10CT )
+  {
+    // The blocks alternate, the first one first. The DTC is filling the
+    // other one now, so this has to be read before that's full.
+    unsigned short *b = adc_seq_blocks, *end, *s = adc_seq_sums;
+
+    if ( adc_seq_blocks_in & 1 )
+      b += adc_seq_n * ADC_SEQ_SUM_PASSES;
+    end = b + adc_seq_n * ADC_SEQ_SUM_PASSES;
+    if ( adc_seq_blocks_in >= adc_seq_skip )
+      while ( b < end )
+      {
+        *s++ += *b++;
+        if ( s == adc_seq_sums + adc_seq_n )
+          s = adc_seq_sums;
+      }
+    adc_seq_blocks_in++;
+    if ( --adc_seq_blocks_left )
+      return;
+  }
+
+  ADC10CTL0 &= ~ENC; // make sure this is off otherwise settings are locked.
+  ADC10CTL0 = 0;     // turn adc off, clears ADC10IFG and ADC10IE too
+  adc_seq_busy = 0;
+
+  if ( adc_seq_wake )
+  {
+    adc_seq_wake = 0;
+    LPM4_EXIT;
+  }
+}
+
+#endif // !ECG_HW_CLOCK
@@ -0,0 +1,54 @@
+/* See license.txt for license information. */
+
+#ifndef ADC_SEQ_H
+#define ADC_SEQ_H
+
+/*
+ * Multi-channel ADC10 conversions with the Data Transfer Controller.
+ *
+ * One CONSEQ_1 sequence converts the channel given in ctl1 and every channel
+ * below it, down to A0, back to back. The DTC writes the results straight
+ * into dest, one word per channel, highest channel first. The CPU only hears
+ * about it once, from the ADC10 interrupt at the end of the block, which also
+ * turns the ADC off again.
+ *
+ *   ctl0: reference and sample-and-hold time (SREF_x + ADC10SHT_x [+ REFON])
+ *   ctl1: top channel, clock and trigger (INCH_x + ADC10DIVx + ADC10SSEL_x +
+ *         SHS_x); CONSEQ_1 is added here
+ *   n:    number of channels in the sequence, i.e. top channel + 1
+ */
+
+extern volatile unsigned char adc_seq_busy;
+
+// Start a sequence and return right away. adc_seq_busy drops when the
+// results are in dest.
+void adc_seq_start(unsigned short *dest, unsigned char n,
+                   unsigned short ctl0, unsigned short ctl1);
+
+// Start a sequence and sleep until it's done, in LPM4 unless something
+// needs a clock kept running (see adc_seq.c).
+void adc_seq_read(unsigned short *dest, unsigned char n,
+                  unsigned short ctl0, unsigned short ctl1);
+
+// Run the sequence over and over (repeat-sequence mode) and add it up per
+// channel into sum[0..n-1], which the caller zeroes, sleeping as
+// adc_seq_read() does until it's done. The DTC fills two blocks of ADC_SEQ_SUM_PASSES sequences in
+// turn, and the interrupt adds up each one as it fills: the first skip
+// blocks are dropped, the next count summed, and the ADC turned off.
+// blocks is room for the two, 2 * ADC_SEQ_SUM_PASSES * n words, so a long
+// run doesn't need a buffer for all of it.
+//
+// The interrupt has until the other block fills to read one, i.e.
+// ADC_SEQ_SUM_PASSES sequences: ~76 us for three channels at ADC10SHT_1
+// and ADC10OSC / 3.
+#define ADC_SEQ_SUM_PASSES        2
+
+void adc_seq_sum(unsigned short *sum, unsigned short *blocks, unsigned char n,
+                 unsigned char skip, unsigned char count,
+                 unsigned short ctl0, unsigned short ctl1);
+
+// Stop whatever is converting, without the interrupt (GIE may be off), and
+// turn the ADC off. Whatever the DTC got to stays in dest.
+void adc_seq_abort();
+
+#endif // ADC_SEQ_H
@@ -0,0 +1,149 @@
+/* See license.txt for license information. */
+
+#include "dlwisp41.h"
+#include "rfid.h"
+#include "mywisp.h"
+#include "archive.h"
+#include "user_bank.h"
+
+#if ARCHIVE_SAMPLES
+
+// slot holds nothing we can use
+#define ARCHIVE_NONE              0xFFFF
+
+unsigned short archive_next = 0;
+unsigned char archive_count = 0;
+
+// CRC-16 over everything but the CRC itself. A torn page keeps some of the
+// bytes it was meant to get, and a rotate and xor let too many of those
+// through. The record number goes over the CRC for a moment, so the bytes
+// are in a row for crc16_ccitt().
+static unsigned short archive_check(unsigned char *r)
+{
+  unsigned char c2 = r[2], c3 = r[3];
+  unsigned short crc;
+
+  r[2] = r[0];
+  r[3] = r[1];
+  crc = crc16_ccitt(r + 2, ARCHIVE_RECORD_BYTES - 2);
+  r[2] = c2;
+  r[3] = c3;
+  return crc;
+}
+
+// Record number in slot, or ARCHIVE_NONE. record gets the whole record.
+static unsigned short archive_read(unsigned char slot, unsigned char *record)
+{
+  unsigned short seq;
+
+  if ( !read_eeprom(slot * ARCHIVE_RECORD_BYTES, record,
+                    ARCHIVE_RECORD_BYTES) ||
+       archive_check(record) != ((record[2] << 8) | record[3]) )
+    return ARCHIVE_NONE;
+
+  seq = (record[0] << 8) | record[1];
+  if ( seq >= ARCHIVE_SEQ_MOD || seq % ARCHIVE_SLOTS != slot )
+    return ARCHIVE_NONE;
+  return seq;
+}
+
+void archive_init()
+{
+  unsigned char r[ARCHIVE_RECORD_BYTES];
+  unsigned short base, seq;
+  unsigned char lo, hi, mid;
+
+  base = archive_read(0, r);
+  if ( base == ARCHIVE_NONE )
+  {
+    // empty, or slot 0 was being written on the way round
+    seq = archive_read(ARCHIVE_SLOTS-1, r);
+    if ( seq == ARCHIVE_NONE )
+    {
+      archive_next = 0;
+      archive_count = 0;
+    }
+    else
+    {
+      archive_next = ( seq + 1 == ARCHIVE_SEQ_MOD ) ? 0 : seq + 1;
+      archive_count = ARCHIVE_SLOTS - 1;
+    }
+    eeprom_append_at(0);
+    return;
+  }
+
+  // slot lo is in this lap, slot hi isn't
+  lo = 0;
+  hi = ARCHIVE_SLOTS;
+  while ( hi - lo > 1 )
+  {
+    mid = (lo + hi) / 2;
+    if ( archive_read(mid, r) == base + mid )
+      lo = mid;
+    else
+      hi = mid;
+  }
+
+  archive_next = base + lo + 1;
+  if ( archive_next == ARCHIVE_SEQ_MOD )
+    archive_next = 0;
+
+  // If the last slot has the last lap's record, we've been round before
+  // and the slots after the head are full too, but for a torn one at hi.
+  archive_count = lo + 1;
+  if ( hi < ARCHIVE_SLOTS )
+  {
+    seq = (base ? base : ARCHIVE_SEQ_MOD) - ARCHIVE_SLOTS;
+    if ( archive_read(ARCHIVE_SLOTS-1, r) == seq + ARCHIVE_SLOTS-1 )
+    {
+      archive_count = ARCHIVE_SLOTS;
+      if ( hi < ARCHIVE_SLOTS-1 && archive_read(hi, r) != seq + hi )
+        archive_count--;
+    }
+  }
+
+  eeprom_append_at(hi * ARCHIVE_RECORD_BYTES);
+}
+
+unsigned char archive_put(const unsigned char volatile *payload,
+                          unsigned char length)
+{
+  unsigned char r[ARCHIVE_RECORD_BYTES];
+  unsigned short crc;
+  unsigned char i;
+
+  r[0] = __swap_bytes(archive_next);
+  r[1] = archive_next;
+  for ( i = 0; i < ARCHIVE_DATA_BYTES; i++ )
+    r[4 + i] = ( i < length ) ? payload[i] : 0;
+  crc = archive_check(r);
+  r[2] = __swap_bytes(crc);
+  r[3] = crc;
+
+  user_bank_forget((archive_next % ARCHIVE_SLOTS) * ARCHIVE_RECORD_BYTES);
+  if ( ++archive_next == ARCHIVE_SEQ_MOD )
+    archive_next = 0;
+  if ( archive_count < ARCHIVE_SLOTS )
+    archive_count++;
+
+  // slot and page are one and the same, so the appender is already there
+  return eeprom_append(r, ARCHIVE_RECORD_BYTES);
+}
+
+unsigned char archive_get(unsigned char k, unsigned char *record)
+{
+  unsigned short seq;
+  unsigned char back;
+
+  if ( k >= archive_count )
+    return 0;
+
+  back = archive_count - k;
+  seq = archive_next - back;
+  if ( archive_next < back )
+    seq += ARCHIVE_SEQ_MOD;
+
+  return archive_read(seq % ARCHIVE_SLOTS, record) == seq;
+}
+
+#endif // ARCHIVE_SAMPLES
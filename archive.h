@@ -0,0 +1,72 @@
+/* See license.txt for license information. */
+
+#ifndef ARCHIVE_H
+#define ARCHIVE_H
+
+/*
+ * Sample archive on the external EEPROM (ARCHIVE_SAMPLES in mywisp.h).
+ *
+ * Every fresh sensor payload is also appended to a log on the EEPROM, so
+ * readings taken while no reader listens can be fetched later. The log is
+ * a ring of fixed-size records, one EEPROM page each:
+ *
+ *   bytes 0-1   record number, MSB first, mod ARCHIVE_SEQ_MOD
+ *   bytes 2-3   CRC-16 (crc16_ccitt()) of bytes 0-1 and 4-15, MSB first
+ *   bytes 4-15  the payload as sent (payload.h), zero-padded
+ *
+ * Record n always goes to slot n % ARCHIVE_SLOTS. The head goes round the
+ * whole chip, so every page takes the same share of the writes.
+ *
+ * Recovery: after a cold start archive_init() finds the head again from
+ * the record numbers alone. Slots 0 up to the head hold consecutive numbers
+ * from this lap, and the slots after it hold the last lap's (or nothing),
+ * so a binary search over the slots finds the break in log2(ARCHIVE_SLOTS)
+ * reads. A record torn by a power loss fails its CRC; should one pass by
+ * chance, it can only be the newest one, so the record before it becomes
+ * the head (host/bench/archive_bench.c tries it over the whole
+ * record-number range). After a fast resume the RAM state is still good
+ * and there's nothing to find.
+ *
+ * Writes go through eeprom_append(), a page at a time, queued behind the
+ * protocol (i2c.h). Readers get the records out of the User bank
+ * (user_bank.h).
+ */
+
+#include "mywisp.h"
+#include "eeprom.h"
+#include "payload.h"
+
+#if ARCHIVE_SAMPLES
+
+#if !READ_SENSOR
+#error "ARCHIVE_SAMPLES needs one of the sensor applications"
+#endif
+
+#define ARCHIVE_RECORD_BYTES      EEPROM_PAGE_BYTES
+#define ARCHIVE_SLOTS             (EEPROM_BYTES / ARCHIVE_RECORD_BYTES)
+#define ARCHIVE_DATA_BYTES        (ARCHIVE_RECORD_BYTES - 4)
+
+// a whole number of laps below 0xFFFF, which an erased slot reads as
+#define ARCHIVE_SEQ_MOD           ((0xFFFFu / ARCHIVE_SLOTS) * ARCHIVE_SLOTS)
+
+#if (PAYLOAD_BYTES > ARCHIVE_DATA_BYTES)
+#error "sensor payload too big for an archive record"
+#endif
+
+extern unsigned short archive_next;   // number the next record gets
+extern unsigned char archive_count;   // records held, up to ARCHIVE_SLOTS
+
+// At boot, after init_eeprom(), unless RAM survived (fast resume).
+void archive_init();
+
+// Append a payload. Returns 0 if an earlier page didn't make it.
+unsigned char archive_put(const unsigned char volatile *payload,
+                          unsigned char length);
+
+// Read back record k, 0 being the oldest held, into record. Returns 0 if k
+// is out of range or the record doesn't check out.
+unsigned char archive_get(unsigned char k, unsigned char *record);
+
+#endif // ARCHIVE_SAMPLES
+
+#endif // ARCHIVE_H
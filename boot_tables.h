@@ -0,0 +1,134 @@
+/* See license.txt for license information. */
+
+#ifndef BOOT_TABLES_H
+#define BOOT_TABLES_H
+
+/*
+ * Reply buffers, CRCs and the RN16 table, worked out at compile time from the
+ * constants in mywisp.h. They used to be computed in main() on every power-up,
+ * which cost us over a thousand cycles between power-good and the first
+ * setup_to_receive(). Everything here is an integer constant expression, so it
+ * ends up in the initialized-data image in flash and costs nothing at boot.
+ *
+ * If you change the reply layout, change it here -- rfid.c just uses these.
+ */
+
+// Expands m with the comma-separated list in args, e.g.
+// BOOT_APPLY(ACK_REPLY_EPC, (EPC)) calls ACK_REPLY_EPC with the 12 EPC bytes.
+#define BOOT_APPLY(m, args)       m args
+
+////////////////////////////////////////////////////////////////////////////////
+// Static reply bytes
+////////////////////////////////////////////////////////////////////////////////
+
+// RN16 we backscatter when slotting is disabled
+#define QUERY_REPLY_RN16          0x00, 0x03
+#define QUERY_REPLY_RN16_HI       0x00
+#define QUERY_REPLY_RN16_LO       0x03
+
+// ackReply preamble: PC word for a 96-bit EPC
+#define ACK_REPLY_PC              0x30, 0x00
+#define ACK_REPLY_PC_HI           0x30
+#define ACK_REPLY_PC_LO           0x00
+
+// In DATA_IN_EPC modes the first EPC byte carries the sensor type, so put
+// it in the initializer instead of patching it in at boot.
+#if DATA_IN_EPC
+#define ACK_REPLY_EPC_0(e0)       SENSOR_DATA_TYPE_ID
+#else
+#define ACK_REPLY_EPC_0(e0)       (e0)
+#endif
+
+#define ACK_REPLY_EPC(e0, e1, e2, e3, e4, e5, e6, e7, e8, e9, e10, e11) \
+  ACK_REPLY_EPC_0(e0), e1, e2, e3, e4, e5, e6, e7, e8, e9, e10, e11
+
+////////////////////////////////////////////////////////////////////////////////
+// Compile-time CRC-16/CCITT
+////////////////////////////////////////////////////////////////////////////////
+//
+// Same CRC as crc16_ccitt() in hw41_D41.c (preset 0xFFFF, poly 0x1021,
+// inverted result), but in its byte-at-a-time form:
+//
+//    x = (crc >> 8) ^ b;  x ^= x >> 4;
+//    crc = (crc << 8) ^ (x << 12) ^ (x << 5) ^ x;
+//
+// Nesting that as macros blows up exponentially, so every intermediate value
+// is its own enumerator instead. The CRC is kept as separate high and low
+// bytes because an enumerator has to fit in a (16-bit, signed) int.
+#define CRC16_X(h, b)             ((((h) ^ (b)) ^ (((h) ^ (b)) >> 4)) & 0xFF)
+#define CRC16_HI(l, x)            (((l) ^ ((x) << 4) ^ ((x) >> 3)) & 0xFF)
+#define CRC16_LO(x)               ((((x) << 5) ^ (x)) & 0xFF)
+
+// Feed byte b into CRC state p, producing state n.
+#define CRC16_STEP(n, p, b) \
+  n##_X = CRC16_X(p##_H, (b)), \
+  n##_H = CRC16_HI(p##_L, n##_X), \
+  n##_L = CRC16_LO(n##_X)
+
+// queryReply = RN16, CRC
+enum {
+  QR_CRC_0_H = 0xFF, QR_CRC_0_L = 0xFF,
+  CRC16_STEP(QR_CRC_1, QR_CRC_0, QUERY_REPLY_RN16_HI),
+  CRC16_STEP(QR_CRC_2, QR_CRC_1, QUERY_REPLY_RN16_LO)
+};
+
+#define QUERY_REPLY_CRC           (QR_CRC_2_H ^ 0xFF), (QR_CRC_2_L ^ 0xFF)
+
+// ackReply = PC, EPC, CRC
+#define ACK_CRC_STEPS(e0, e1, e2, e3, e4, e5, e6, e7, e8, e9, e10, e11) \
+  CRC16_STEP(ACK_CRC_3, ACK_CRC_2, ACK_REPLY_EPC_0(e0)), \
+  CRC16_STEP(ACK_CRC_4, ACK_CRC_3, e1), \
+  CRC16_STEP(ACK_CRC_5, ACK_CRC_4, e2), \
+  CRC16_STEP(ACK_CRC_6, ACK_CRC_5, e3), \
+  CRC16_STEP(ACK_CRC_7, ACK_CRC_6, e4), \
+  CRC16_STEP(ACK_CRC_8, ACK_CRC_7, e5), \
+  CRC16_STEP(ACK_CRC_9, ACK_CRC_8, e6), \
+  CRC16_STEP(ACK_CRC_10, ACK_CRC_9, e7), \
+  CRC16_STEP(ACK_CRC_11, ACK_CRC_10, e8), \
+  CRC16_STEP(ACK_CRC_12, ACK_CRC_11, e9), \
+  CRC16_STEP(ACK_CRC_13, ACK_CRC_12, e10), \
+  CRC16_STEP(ACK_CRC_14, ACK_CRC_13, e11)
+
+enum {
+  ACK_CRC_0_H = 0xFF, ACK_CRC_0_L = 0xFF,
+  CRC16_STEP(ACK_CRC_1, ACK_CRC_0, ACK_REPLY_PC_HI),
+  CRC16_STEP(ACK_CRC_2, ACK_CRC_1, ACK_REPLY_PC_LO),
+  BOOT_APPLY(ACK_CRC_STEPS, (EPC))
+};
+
+// In DATA_IN_EPC modes the CRC is filled in along with the first sample,
+// so the tag doesn't answer an ACK with an EPC full of zeros.
+#if DATA_IN_EPC
+#define ACK_REPLY_CRC             0x00, 0x00
+#else
+#define ACK_REPLY_CRC             (ACK_CRC_14_H ^ 0xFF), (ACK_CRC_14_L ^ 0xFF)
+#endif
+
+////////////////////////////////////////////////////////////////////////////////
+// Initial RN16 table (ENABLE_SLOTS)
+////////////////////////////////////////////////////////////////////////////////
+//
+// For each Q in 0..15: rn16 = first EPC word ^ Q, clocked once through the
+// LFSR and scaled to 2^Q-1. Q <= 8 stores the low byte at RN16[Q]; Q > 8
+// stores the high and low bytes at RN16[2Q-9] and RN16[2Q-8].
+#define RN16_SEED(e0, e1, q)      (((((unsigned long)(e0)) << 8) | (e1)) ^ (q))
+#define RN16_LFSR(v, q) \
+  (((((v) << 1) | ((((v) >> 15) ^ ((v) >> 13) ^ ((v) >> 9) ^ ((v) >> 8)) & 1)) \
+    & 0xFFFF) >> (15 - (q)))
+#define RN16_Q(e0, e1, q)         RN16_LFSR(RN16_SEED(e0, e1, q), q)
+#define RN16_LO(e0, e1, q)        ((unsigned char)(RN16_Q(e0, e1, q) & 0xFF))
+#define RN16_HI(e0, e1, q)        ((unsigned char)(RN16_Q(e0, e1, q) >> 8))
+
+#define RN16_TABLE(e0, e1, e2, e3, e4, e5, e6, e7, e8, e9, e10, e11) \
+  RN16_LO(e0, e1, 0), RN16_LO(e0, e1, 1), RN16_LO(e0, e1, 2), \
+  RN16_LO(e0, e1, 3), RN16_LO(e0, e1, 4), RN16_LO(e0, e1, 5), \
+  RN16_LO(e0, e1, 6), RN16_LO(e0, e1, 7), RN16_LO(e0, e1, 8), \
+  RN16_HI(e0, e1, 9),  RN16_LO(e0, e1, 9), \
+  RN16_HI(e0, e1, 10), RN16_LO(e0, e1, 10), \
+  RN16_HI(e0, e1, 11), RN16_LO(e0, e1, 11), \
+  RN16_HI(e0, e1, 12), RN16_LO(e0, e1, 12), \
+  RN16_HI(e0, e1, 13), RN16_LO(e0, e1, 13), \
+  RN16_HI(e0, e1, 14), RN16_LO(e0, e1, 14), \
+  RN16_HI(e0, e1, 15), RN16_LO(e0, e1, 15)
+
+#endif // BOOT_TABLES_H
@@ -0,0 +1,257 @@
+/* See license.txt for license information. */
+
+#include "dlwisp41.h"
+#include "rfid.h"
+#include "mywisp.h"
+#include "sensors.h"
+#include "checkpoint.h"
+#if SCHEDULED_SAMPLING
+#include "sched.h"
+#endif
+
+#if CHECKPOINT_STATE
+
+// info flash reads this way when erased
+#define CP_ERASED                 0xFFFF
+
+// Flash is read through volatile pointers, so the check after programming
+// reads back what's really there and not what was just stored.
+#define CP_SEGMENT(s)             ((volatile unsigned short *) \
+  (CHECKPOINT_BASE + (s) * CHECKPOINT_SEGMENT_WORDS * 2))
+#define CP_RECORD(s, k)           (CP_SEGMENT(s) + (k) * CHECKPOINT_WORDS)
+
+// A word into flash, with the controller set to program or erase. The host
+// benchmark puts its model of the controller here.
+#ifndef CP_FLASH_WRITE
+#define CP_FLASH_WRITE(w, v)      (*(w) = (v))
+#endif
+
+// What CHECKPOINT_HOLDOFF counts: seconds awake, or without the scheduler's
+// clock, sleeps
+#if SCHEDULED_SAMPLING
+#define CP_NOW                    sched_seconds
+#else
+#define CP_NOW                    cp_sleeps
+#endif
+
+// what in record word 3 isn't timeToSample
+#if READ_SENSOR
+#define CP_SEQ_MASK               0xFF00
+#else
+#define CP_SEQ_MASK               0
+#endif
+
+unsigned short checkpoint_lost = 0;
+
+// Where the log stands: records go into segment cp_seg at cp_slot, up to
+// CHECKPOINT_PER_SEGMENT. Not valid until checkpoint_init() has run, which
+// after a fast resume it still is.
+static unsigned char cp_ready = 0;
+static unsigned char cp_seg;
+static unsigned char cp_slot;
+static unsigned short cp_number;
+static volatile unsigned short *cp_last = 0;  // newest record
+static unsigned short cp_saved_at;        // CP_NOW when it was written
+#if !SCHEDULED_SAMPLING
+static unsigned short cp_sleeps;
+#endif
+
+// CRC-16 over the rest: a torn record keeps some bits of the words it was
+// meant to get, and a rotate and xor let too many of those through
+static unsigned short cp_check(const volatile unsigned short *r)
+{
+  return crc16_ccitt((volatile unsigned char *)r, 2 * (CHECKPOINT_WORDS - 1));
+}
+
+static unsigned char cp_good(const volatile unsigned short *r)
+{
+  return r[0] != CP_ERASED && r[CHECKPOINT_WORDS-1] == cp_check(r);
+}
+
+static unsigned char cp_blank(const volatile unsigned short *w,
+                              unsigned char n)
+{
+  while ( n-- )
+  {
+    if ( *w++ != CP_ERASED )
+      return 0;
+  }
+  return 1;
+}
+
+static void cp_gather(unsigned short *s)
+{
+  s[0] = read_counter;
+  s[1] = sensor_counter;
+#if READ_SENSOR
+  s[2] = (payload_seq << 8) | timeToSample;
+  {
+    unsigned char i;
+
+    for ( i = 0; i < CHECKPOINT_INDEXES; i++ )
+      s[3 + i] = sensor_index[i];
+  }
+#else
+  s[2] = timeToSample;
+#endif
+}
+
+static void cp_scatter(const volatile unsigned short *s)
+{
+  read_counter = s[0];
+  sensor_counter = s[1];
+  timeToSample = s[2];
+#if READ_SENSOR
+  payload_seq = s[2] >> 8;
+  {
+    unsigned char i;
+
+    for ( i = 0; i < CHECKPOINT_INDEXES; i++ )
+      sensor_index[i] = s[3 + i];
+  }
+#endif
+}
+
+// Whether record r says anything the newest one doesn't, leaving out the
+// counters (read_counter, sensor_counter, timeToSample) unless counters.
+static unsigned char cp_changed(const unsigned short *r, unsigned char counters)
+{
+  unsigned short d;
+  unsigned char i;
+
+  for ( i = 1; i < CHECKPOINT_WORDS - 1; i++ )
+  {
+    d = r[i] ^ cp_last[i];
+    if ( !counters && i <= 3 )
+      d &= ( i == 3 ) ? CP_SEQ_MASK : 0;
+    if ( d )
+      return 1;
+  }
+  return 0;
+}
+
+void checkpoint_init()
+{
+  volatile unsigned short *r;
+  unsigned char s, k;
+
+  // the newest, going by number (they're all within a lap of the log)
+  cp_last = 0;
+  for ( s = 0; s < CHECKPOINT_SEGMENTS; s++ )
+  {
+    for ( k = 0; k < CHECKPOINT_PER_SEGMENT; k++ )
+    {
+      r = CP_RECORD(s, k);
+      if ( cp_good(r) && ( !cp_last || (short)(r[0] - cp_last[0]) > 0 ) )
+      {
+        cp_last = r;
+        cp_seg = s;
+        cp_slot = k;
+      }
+    }
+  }
+
+  cp_ready = 1;
+  cp_saved_at = CP_NOW;
+  if ( !cp_last )
+  {
+    // start at segment D, once checkpoint_tidy() has it erased
+    cp_seg = CHECKPOINT_SEGMENTS - 1;
+    cp_slot = CHECKPOINT_PER_SEGMENT;
+    cp_number = 0;
+    return;
+  }
+
+  // on past it, and past a torn one after it
+  do
+    cp_slot++;
+  while ( cp_slot < CHECKPOINT_PER_SEGMENT &&
+          !cp_blank(CP_RECORD(cp_seg, cp_slot), CHECKPOINT_WORDS) );
+
+  cp_number = cp_last[0] + 1;
+  cp_scatter(cp_last + 1);
+}
+
+void checkpoint_save()
+{
+  unsigned short r[CHECKPOINT_WORDS];
+  volatile unsigned short *to;
+  unsigned char i, s;
+
+#if !SCHEDULED_SAMPLING
+  cp_sleeps++;
+#endif
+  if ( !cp_ready )
+    return;                               // nothing to save yet
+
+  // Nothing new, or only the counters have moved on and the newest record
+  // is recent: they'd wear the flash out for little. After a power loss they
+  // go back a little, but payload_seq and the sample indexes don't.
+  cp_gather(r + 1);
+  if ( cp_last && ( !cp_changed(r, 1) ||
+                    ( (unsigned short)(CP_NOW - cp_saved_at) <
+                        CHECKPOINT_HOLDOFF && !cp_changed(r, 0) ) ) )
+    return;
+
+  if ( cp_slot == CHECKPOINT_PER_SEGMENT )
+  {
+    // on to the next segment, if it's been erased
+    s = ( cp_seg + 1 ) % CHECKPOINT_SEGMENTS;
+    if ( !cp_blank(CP_SEGMENT(s), CHECKPOINT_SEGMENT_WORDS) )
+    {
+      checkpoint_lost++;
+      return;
+    }
+    cp_seg = s;
+    cp_slot = 0;
+  }
+
+  if ( cp_number == CP_ERASED )
+    cp_number = 0;
+  r[0] = cp_number++;
+  r[CHECKPOINT_WORDS-1] = cp_check(r);
+
+  to = CP_RECORD(cp_seg, cp_slot++);
+  _BIC_SR(GIE);
+  FCTL2 = CHECKPOINT_FCTL2;
+  FCTL3 = FWKEY;                          // unlock (A stays locked)
+  FCTL1 = FWKEY + WRT;
+  for ( i = 0; i < CHECKPOINT_WORDS; i++ )
+    CP_FLASH_WRITE(&to[i], r[i]);         // the CPU waits out each word
+  FCTL1 = FWKEY;
+  FCTL3 = FWKEY + LOCK;
+  _BIS_SR(GIE);
+
+  if ( cp_good(to) )
+  {
+    cp_last = to;
+    cp_saved_at = CP_NOW;
+  }
+  else
+    checkpoint_lost++;
+}
+
+// Erase the segment after the one being filled, so it's ready when that
+// one fills up. It only holds older checkpoints.
+void checkpoint_tidy()
+{
+  unsigned char s;
+
+  if ( !cp_ready )
+    return;
+
+  s = ( cp_seg + 1 ) % CHECKPOINT_SEGMENTS;
+  if ( cp_blank(CP_SEGMENT(s), CHECKPOINT_SEGMENT_WORDS) )
+    return;
+
+  _BIC_SR(GIE);
+  FCTL2 = CHECKPOINT_FCTL2;
+  FCTL3 = FWKEY;
+  FCTL1 = FWKEY + ERASE;
+  CP_FLASH_WRITE(CP_SEGMENT(s), 0);       // dummy write starts the erase
+  FCTL1 = FWKEY;
+  FCTL3 = FWKEY + LOCK;
+  _BIS_SR(GIE);
+}
+
+#endif // CHECKPOINT_STATE
@@ -0,0 +1,99 @@
+/* See license.txt for license information. */
+
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+/*
+ * Checkpoints in information flash (CHECKPOINT_STATE in mywisp.h).
+ *
+ * Fast resume keeps RAM over a brownout, but once the cap has drained all
+ * the way the counters start over, and so do the payload sequence numbers
+ * the reader goes by. So each time the tag goes to sleep for want of power
+ * (sleep()), it writes what it would lose to info flash first, and after a
+ * cold start it picks up from there. A checkpoint holds:
+ *
+ *   read_counter, sensor_counter, timeToSample
+ *   payload_seq and each sensor's sample index (sensors.c)
+ *
+ * which is what the reader needs to carry on the same stream. The payload
+ * itself isn't kept, so records stay small and a segment erase lasts many
+ * checkpoints: a reading that hadn't gone out yet is lost, and shows up as
+ * a gap in the indexes.
+ *
+ * The log: segments D, C and B (0x1000-0x10BF; A holds the calibration
+ * constants) take fixed-size records, CHECKPOINT_WORDS each:
+ *
+ *   word 0      checkpoint number, +1 each time, never 0xFFFF
+ *   words 1-    the state above
+ *   last word   CRC-16 of the others (crc16_ccitt()), written last
+ *
+ * A checkpoint is only written if something has changed since the last,
+ * to the next free record; if all that has changed is the counters, only
+ * once the last is CHECKPOINT_HOLDOFF old (mywisp.h). The segments are used
+ * in turn; the one after the one being filled is erased ahead of time, once
+ * there's power again, so the write before sleep() never has to wait for an
+ * erase. The newest record that checks out wins at boot. A record torn by
+ * the power going can only be the newest, and fails its check word.
+ *
+ * Cost: the flash timing generator runs at MCLK/10, so a word takes 300
+ * MCLK cycles to program (30 timing generator cycles) with the CPU held,
+ * and a segment erase 48190. At 3 MHz that's 100 us a word and 16 ms an
+ * erase, at about 1 mA on top of the CPU (datasheet typical): a 6-word
+ * record (one sensor) is 0.6 ms and ~2.4 uJ at 2.2 V, an erase ~64 uJ. host/bench/checkpoint_bench.c runs this file against a model of
+ * the flash controller, power failing mid-write included.
+ *
+ * Notes:
+ *  - Flash only programs from 2.2 V up. If the supervisor lets power-good
+ *    go below that, the checkpoint may not take; the check word catches it
+ *    and the one before is used.
+ *  - A segment lasts 10^4 erases at least (10^5 typical). The bench's tag,
+ *    up 1-20 s at a wake and taking a reading every fourth, writes ~120
+ *    records an hour (~340 without the holdoff) at five a segment, ~24
+ *    erases; its busiest segment lasts 53 days awake at least, 530
+ *    typical.
+ *  - The streaming modes' sample rings and batches aren't kept: their
+ *    clocks start over at every wake anyway (sampler.h, ecg_clock.h).
+ *  - After a fast resume RAM is still good and nothing is restored.
+ */
+
+#include "mywisp.h"
+#include "payload.h"
+
+#if CHECKPOINT_STATE
+
+#define CHECKPOINT_SEGMENTS       3
+#ifndef CHECKPOINT_BASE
+#define CHECKPOINT_BASE           0x1000          // segment D
+#endif
+#define CHECKPOINT_SEGMENT_WORDS  32
+
+// flash timing generator: MCLK/10, in the 257-476 kHz it has to be in
+#define CHECKPOINT_FCTL2          (FWKEY + FSSEL_1 + FN3 + FN0)
+
+#if READ_SENSOR
+#define CHECKPOINT_INDEXES        SENSORS_IN_IMAGE
+#else
+#define CHECKPOINT_INDEXES        0
+#endif
+
+#define CHECKPOINT_STATE_WORDS    (3 + CHECKPOINT_INDEXES)
+#define CHECKPOINT_WORDS          (CHECKPOINT_STATE_WORDS + 2)
+#define CHECKPOINT_PER_SEGMENT    (CHECKPOINT_SEGMENT_WORDS / CHECKPOINT_WORDS)
+
+#if (CHECKPOINT_PER_SEGMENT < 1)
+#error "checkpoint too big for an info flash segment"
+#endif
+
+extern unsigned short checkpoint_lost;   // not written: no room, or failed
+
+// After a cold start, once the sensors are set up: find the newest
+// checkpoint and restore it, if there is one.
+void checkpoint_init();
+
+// sleep() calls these: before it sleeps, and once power is good again.
+void checkpoint_save();
+void checkpoint_tidy();
+
+#endif // CHECKPOINT_STATE
+
+#endif // CHECKPOINT_H
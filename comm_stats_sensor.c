@@ -0,0 +1,36 @@
+/* See license.txt for license information. */
+#include "mywisp.h"
+#if COMM_STATS_PERIOD
+
+#include "dlwisp41.h"
+#include "rfid.h"
+#include "comm_stats_sensor.h"
+
+// Port1_ISR counts into the first two from assembly, by address
+unsigned short comm_stats[COMM_STATS_PAGES * COMM_STATS_PER_PAGE];
+
+static unsigned char comm_stats_page = 0;
+
+static unsigned char comm_stats_collect(unsigned char volatile *target)
+{
+  unsigned short *c = &comm_stats[comm_stats_page * COMM_STATS_PER_PAGE];
+  unsigned char i;
+
+  *target++ = comm_stats_page;
+  for ( i = 0; i < COMM_STATS_PER_PAGE; i++ )
+  {
+    *target++ = __swap_bytes(c[i]);
+    *target++ = c[i];
+  }
+
+  if ( ++comm_stats_page == COMM_STATS_PAGES )
+    comm_stats_page = 0;
+
+  return 1;
+}
+
+const sensor_driver comm_stats_driver = {
+  COMM_STATS_TYPE_ID, COMM_STATS_DATA_BYTES, 0, 0, comm_stats_collect
+};
+
+#endif // COMM_STATS_PERIOD
@@ -0,0 +1,63 @@
+/* See license.txt for license information. */
+
+#ifndef COMM_STATS_SENSOR_H
+#define COMM_STATS_SENSOR_H
+
+/*
+ * Link statistics (SENSOR_COMM_STATS). The receive path and the command
+ * handlers count what they see with COMM_COUNT(), one increment of a RAM
+ * word each, and the sensor reports the counters a page at a time:
+ *
+ *   byte 0     page, 0 to COMM_STATS_PAGES-1; the next reading sends the
+ *              next one
+ *   bytes 1-   COMM_STATS_PER_PAGE counters from COMM_STATS_PER_PAGE*page
+ *              on, MSB first: two in the EPC, three in a Read
+ *
+ * The counters run mod 2^16 from the last cold start and survive a fast
+ * resume; the reader takes differences. Compare delimiters with the
+ * commands and timeouts to see where a slow tag loses its rounds: bad
+ * delimiters (noise, or a reader too far off), commands cut off by a TAR
+ * timeout, or commands it didn't recognise (dropped).
+ */
+
+#define COMM_STATS_TYPE_ID        0x0A
+
+// counters, in the order they're reported
+#define COMM_DELIMITERS           0   // Port1_ISR: delimiter found
+#define COMM_BAD_DELIMITERS       1   // Port1_ISR: delimiterNotFound
+#define COMM_TIMEOUTS             2   // main loop: TAR ran out mid-command
+#define COMM_DROPPED              3   // bits >= MAX_NUM_x, no match
+#define COMM_REPLIES              4   // sendToReader()
+#define COMM_QUERY                5
+#define COMM_QUERYREP             6
+#define COMM_QUERYADJUST          7
+#define COMM_ACK                  8
+#define COMM_REQ_RN               9
+#define COMM_SELECT               10
+#define COMM_READ                 11
+#define COMM_NAK                  12
+#define COMM_STATS_COUNT          13
+
+#if DATA_IN_EPC
+#define COMM_STATS_PER_PAGE       2
+#else
+#define COMM_STATS_PER_PAGE       3
+#endif
+#define COMM_STATS_PAGES          ((COMM_STATS_COUNT + COMM_STATS_PER_PAGE-1) \
+                                   / COMM_STATS_PER_PAGE)
+#define COMM_STATS_DATA_BYTES     (1 + 2*COMM_STATS_PER_PAGE)
+
+// the last page is padded out with zeros
+extern unsigned short comm_stats[COMM_STATS_PAGES * COMM_STATS_PER_PAGE];
+
+extern const sensor_driver comm_stats_driver;
+
+#if COMM_STATS_PERIOD
+#define COMM_COUNT(c)             (comm_stats[c]++)
+#endif
+
+#if (ACTIVE_SENSOR == SENSOR_COMM_STATS)
+#define SENSOR_DATA_TYPE_ID       COMM_STATS_TYPE_ID
+#endif
+
+#endif // COMM_STATS_SENSOR_H
@@ -0,0 +1,229 @@
+/* See license.txt for license information. */
+
+#include "dlwisp41.h"
+#include "mywisp.h"
+#include "dco.h"
+
+#if DCO_CALIBRATION
+
+// A setting: RSEL in the high byte, DCOCTL in the low. 0 is ~100 kHz, never
+// a link clock, so it marks a cell not measured yet.
+#define DCO_NONE                  0
+#define DCO_SETTING(bcsctl1, dcoctl) \
+  ((unsigned short)((((bcsctl1) & 0x0F) << 8) | (dcoctl)))
+#define DCO_APPLY(s) \
+  do { BCSCTL1 = XT2OFF + ((s) >> 8); DCOCTL = (unsigned char)(s); } while (0)
+
+#define DCO_SEND                  0
+#define DCO_RECEIVE               1
+
+unsigned char dco_send_bcsctl1 = FIXED_SEND_BCSCTL1;
+unsigned char dco_send_dcoctl = FIXED_SEND_DCOCTL;
+unsigned char dco_receive_bcsctl1 = FIXED_RECEIVE_BCSCTL1;
+unsigned char dco_receive_dcoctl = FIXED_RECEIVE_DCOCTL;
+
+unsigned short dco_send_counts = DCO_COUNTS(DCO_SEND_HZ);
+unsigned short dco_receive_counts = DCO_COUNTS(DCO_RECEIVE_HZ);
+unsigned short dco_tunes = 0;
+
+static unsigned short dco_table[DCO_BINS][2];
+static unsigned char dco_ticks = 0;
+
+static const unsigned short dco_vcap_edges[DCO_VCAP_BINS - 1] = {
+  VCAP_COUNTS(2400), VCAP_COUNTS(2800)
+};
+static const unsigned short dco_temp_edges[DCO_TEMP_BINS - 1] = {
+  DCO_TEMP_COUNTS(15), DCO_TEMP_COUNTS(28), DCO_TEMP_COUNTS(36)
+};
+
+void dco_init()
+{
+  ACLK_SETUP;
+}
+
+static unsigned short dco_temp_read()
+{
+  unsigned short t;
+
+  ADC10CTL0 &= ~ENC; // make sure this is off otherwise settings are locked.
+  ADC10CTL1 = INCH_10 + ADC10DIV_3;
+  ADC10CTL0 = SREF_1 + ADC10SHT_3 + REFON + ADC10ON;
+  for (int k = 0; k < 50; k++);
+
+  ADC10CTL0 |= ENC + ADC10SC;
+  while (ADC10CTL1 & ADC10BUSY);
+  t = ADC10MEM;
+
+  ADC10CTL0 &= ~ENC;
+  ADC10CTL1 = 0;       // turn adc off
+  ADC10CTL0 = 0;       // turn adc off
+
+  return t;
+}
+
+// The table cell for the conditions now.
+static unsigned char dco_bin()
+{
+  unsigned short v = vcap_read();
+  unsigned short t = dco_temp_read();
+  unsigned char i, b = 0;
+
+  for ( i = 0; i < DCO_VCAP_BINS - 1; i++ )
+    b += ( v >= dco_vcap_edges[i] );
+  b *= DCO_TEMP_BINS;
+  for ( i = 0; i < DCO_TEMP_BINS - 1; i++ )
+    b += ( t >= dco_temp_edges[i] );
+  return b;
+}
+
+// DCO cycles in DCO_MEASURE_PERIODS crystal periods, at the setting in
+// BCSCTL1/DCOCTL; 0 if ACLK has stopped. The count can't wrap at any DCO
+// setting, so an overflow means there were no edges.
+static unsigned short dco_measure()
+{
+  unsigned short first = 0, last = 0;
+  unsigned char n;
+
+  _BIC_SR(GIE);
+  TACTL = TASSEL1 + MC1 + TACLR;          // SMCLK, continuous
+  TACCTL2 = CM0 + CCIS0 + SCS + CAP;      // rising edges of ACLK
+  for ( n = 0; n <= DCO_MEASURE_PERIODS && !( TACTL & TAIFG ); n++ )
+  {
+    TACCTL2 &= ~CCIFG;
+    while ( !( TACCTL2 & CCIFG ) && !( TACTL & TAIFG ) );
+    last = TACCR2;
+    if ( n == 0 )
+      first = last;
+  }
+  if ( TACTL & TAIFG )
+    last = first;
+  TACCTL2 = 0;
+  TACTL = 0;
+  _BIS_SR(GIE);
+
+  return last - first;
+}
+
+static unsigned short dco_measure_at(unsigned short s)
+{
+  DCO_APPLY(s);
+  return dco_measure();
+}
+
+// One modulation step up or down. At DCO 7 MOD does nothing, so from there
+// it goes on to the next RSEL instead, at the DCO step that comes out about
+// the same (RSEL steps are ~1.35x, DCO steps ~1.08x). s at either end of the
+// range comes back as it is.
+static unsigned short dco_step(unsigned short s, unsigned char up)
+{
+  if ( up )
+  {
+    if ( (unsigned char)s < DCO2 + DCO1 + DCO0 )
+      return s + 1;
+    return ( ( s >> 8 ) < 0x0F ) ? s + 0x100 - ( DCO2 + DCO1 + DCO0 ) +
+                                   ( DCO1 + DCO0 ) : s;
+  }
+  if ( (unsigned char)s )
+    return s - 1;
+  return ( s >> 8 ) ? s - 0x100 + DCO2 : s;
+}
+
+// Step from s towards target until it steps over it. Returns the setting
+// that came closest, or DCO_NONE if there was no crystal to measure against.
+static unsigned short dco_tune(unsigned short s, unsigned short target)
+{
+  unsigned short best = DCO_NONE, best_off = 0xFFFF;
+  unsigned short counts, off, next;
+  unsigned char i, up = 0;
+
+  for ( i = 0; i < DCO_TUNE_STEPS; i++ )
+  {
+    counts = dco_measure_at(s);
+    if ( !counts )
+      return DCO_NONE;
+    off = ( counts > target ) ? counts - target : target - counts;
+    if ( off < best_off )
+    {
+      best_off = off;
+      best = s;
+    }
+    if ( off == 0 || ( i && up != ( counts < target ) ) )
+      break;                              // on it, or just stepped over it
+    up = ( counts < target );
+    next = dco_step(s, up);
+    if ( next == s )
+      break;                              // as far as it goes
+    s = next;
+  }
+  return best;
+}
+
+// Tune one of a cell's settings, starting from what it had, or from now
+// if it had nothing.
+static void dco_retune(unsigned short *setting, unsigned short now,
+                       unsigned short target)
+{
+  unsigned short s = dco_tune(( *setting != DCO_NONE ) ? *setting : now,
+                              target);
+
+  if ( s != DCO_NONE )
+    *setting = s;
+}
+
+// Within 1/128 of target
+static unsigned char dco_near(unsigned short counts, unsigned short target)
+{
+  unsigned short off = ( counts > target ) ? counts - target :
+                                             target - counts;
+
+  return counts && off <= ( target >> 7 );
+}
+
+void dco_track()
+{
+  unsigned short *cell;
+
+  if ( ++dco_ticks < DCO_TRACK_EVERY )
+    return;
+  dco_ticks = 0;
+
+  cell = dco_table[dco_bin()];
+  if ( !( BCSCTL3 & LFXT1OF ) )
+  {
+    P1IE = 0;                             // deaf until setup_to_receive()
+
+    // no targets given: hold what the hand-tuned settings give
+    if ( !dco_send_counts )
+      dco_send_counts = dco_measure_at(DCO_SETTING(FIXED_SEND_BCSCTL1,
+                                                   FIXED_SEND_DCOCTL));
+    if ( !dco_receive_counts )
+      dco_receive_counts = dco_measure_at(DCO_SETTING(FIXED_RECEIVE_BCSCTL1,
+                                                      FIXED_RECEIVE_DCOCTL));
+
+    if ( dco_send_counts && dco_receive_counts &&
+         ( cell[DCO_RECEIVE] == DCO_NONE ||
+           !dco_near(dco_measure_at(cell[DCO_RECEIVE]),
+                     dco_receive_counts) ) )
+    {
+      // new, or drifted off
+      dco_retune(&cell[DCO_SEND],
+                 DCO_SETTING(dco_send_bcsctl1, dco_send_dcoctl),
+                 dco_send_counts);
+      dco_retune(&cell[DCO_RECEIVE],
+                 DCO_SETTING(dco_receive_bcsctl1, dco_receive_dcoctl),
+                 dco_receive_counts);
+      dco_tunes++;
+    }
+  }
+
+  if ( cell[DCO_SEND] != DCO_NONE && cell[DCO_RECEIVE] != DCO_NONE )
+  {
+    dco_send_bcsctl1 = XT2OFF + ( cell[DCO_SEND] >> 8 );
+    dco_send_dcoctl = (unsigned char)cell[DCO_SEND];
+    dco_receive_bcsctl1 = XT2OFF + ( cell[DCO_RECEIVE] >> 8 );
+    dco_receive_dcoctl = (unsigned char)cell[DCO_RECEIVE];
+  }
+  RECEIVE_CLOCK;
+}
+
+#endif // DCO_CALIBRATION
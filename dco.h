@@ -0,0 +1,104 @@
+/* See license.txt for license information. */
+
+#ifndef DCO_H
+#define DCO_H
+
+/*
+ * DCO calibration (DCO_CALIBRATION in mywisp.h).
+ *
+ * SEND_CLOCK and RECEIVE_CLOCK run the DCO at hand-tuned RSEL/DCO settings,
+ * and what those give moves with supply voltage and temperature (about
+ * -0.1 %/C and a few % per volt, datasheet typical). The reply loop is
+ * cycle-counted, so the backscatter link frequency moves with it, and so
+ * does every Timer_A constant in the receive code. Here the settings come
+ * from a table instead, measured against the 32 kHz crystal:
+ *
+ *   Vcap        below 2.4 V, below 2.8 V, above
+ *   temperature below 15 C, below 28 C, below 36 C, above
+ *
+ * each cell holding a send and a receive setting, once it's been measured.
+ *
+ * Measuring: Timer0_A counts SMCLK (the DCO) from one rising ACLK edge to
+ * the DCO_MEASURE_PERIODS'th after it, captured on CCR2 (CCI2B is ACLK).
+ * That's 244 us and ~730 counts at 3 MHz, finer than the 0.25% or so of a
+ * modulation step.
+ *
+ * Tuning: from a starting setting, step DCOCTL one modulation step at a
+ * time towards the target, into the next RSEL at either end, until it steps
+ * over it, and keep whichever side came closer. At most DCO_TUNE_STEPS.
+ *
+ * dco_track() runs in the main loop's timeout branch, just before
+ * setup_to_receive(). Every DCO_TRACK_EVERY timeouts it reads Vcap and the
+ * temperature sensor and switches to the settings for that cell. A cell
+ * measured before gets one check of the receive clock, and both settings
+ * are tuned again if it's more than 1/128 off; a new one is tuned starting
+ * from the settings in use, which were good for the conditions just before.
+ *
+ * Cost: the two ADC readings take ~0.4 ms. A check is one measurement, a
+ * tuning a few between neighbouring cells and a couple of dozen the first
+ * time; at 244 us a measurement that's 1 to ~12 ms, with the receiver off
+ * (the Port1 interrupt is disabled until setup_to_receive()).
+ *
+ * Notes:
+ *  - The crystal takes a few hundred ms to start, after a reset and after
+ *    sleep()'s LPM4. Until LFXT1OF clears, the tag keeps whatever settings
+ *    it has, and new cells aren't measured.
+ *  - With DCO_SEND_HZ/DCO_RECEIVE_HZ at 0 the target is what the hand-tuned
+ *    settings measure the first time, so it's only as good as the
+ *    conditions then. The table and targets survive a fast resume but not a
+ *    cold start.
+ *  - The factory CALBC1/CALDCO constants aren't used: they're for 1, 8, 12
+ *    and 16 MHz at 3 V and 25 C, none of them a link clock, and they can't
+ *    follow drift anyway.
+ *  - Timer0_A is borrowed between commands only; Timer1_A isn't touched.
+ */
+
+#include "mywisp.h"
+
+#if DCO_CALIBRATION
+
+#if !ACLK_FROM_CRYSTAL
+#error "DCO_CALIBRATION needs the 32 kHz crystal (ACLK_FROM_CRYSTAL)"
+#endif
+
+#if BACKGROUND_SAMPLING || ECG_HW_CLOCK || RR_INTERVALS_IN_ID
+#error "DCO_CALIBRATION can't share the ADC10 with the streaming modes"
+#endif
+
+#define DCO_MEASURE_PERIODS       8
+#define DCO_TUNE_STEPS            48
+
+// DCO cycles per measurement at hz
+#define DCO_COUNTS(hz)            ((unsigned short)(((hz) * \
+                                   (unsigned long)DCO_MEASURE_PERIODS) / \
+                                   XTAL_ACLK_HZ))
+
+#define DCO_VCAP_BINS             3
+#define DCO_TEMP_BINS             4
+#define DCO_BINS                  (DCO_VCAP_BINS * DCO_TEMP_BINS)
+
+// internal temperature sensor reading at c degrees, with the 1.5 V
+// reference (datasheet typical: 3.55 mV/C, 986 mV at 0 C)
+#define DCO_TEMP_COUNTS(c)        ((unsigned short)(((986L + 355L * (c) / \
+                                   100) * 1023) / 1500))
+
+// what SEND_CLOCK and RECEIVE_CLOCK set (see mywisp.h)
+extern unsigned char dco_send_bcsctl1;
+extern unsigned char dco_send_dcoctl;
+extern unsigned char dco_receive_bcsctl1;
+extern unsigned char dco_receive_dcoctl;
+
+extern unsigned short dco_send_counts;    // targets, DCO_COUNTS() units
+extern unsigned short dco_receive_counts;
+extern unsigned short dco_tunes;          // times a cell was (re)tuned
+
+// Every boot, fast resume or not: start the crystal.
+void dco_init();
+
+// In a gap between reader commands. Leaves RECEIVE_CLOCK running and
+// Timer0_A stopped.
+void dco_track();
+
+#endif // DCO_CALIBRATION
+
+#endif // DCO_H
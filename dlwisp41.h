@@ -52,6 +52,12 @@
 #define INCH_VSENSE_IN   INCH_6
 #define INCH_TEMP_EXT_IN INCH_7
 
+// Vcap that reads full scale on VSENSE_IN with the 1.5 V reference (the
+// divider halves it)
+#define VSENSE_FULL_SCALE_MV 3000
+#define VCAP_COUNTS(mv)      ((unsigned short)(((mv) * 1023L) / \
+                                               VSENSE_FULL_SCALE_MV))
+
 //#define INCH_2_4 INCH_4   // not accessible
 // #define INCH_3_5 INCH_5  // ??
 
@@ -62,16 +68,31 @@
   P2DIR = DEBUG_2_3 | CRYSTAL_OUT; \
   P3DIR = CLK_A | VSENSE_POWER | TX_A | RX_A;
 
+// The link's DCO settings, as tuned by hand. With DCO_CALIBRATION they're
+// only the starting point (see dco.h); mywisp.h picks SEND_BCSCTL1 etc.
+#define FIXED_SEND_BCSCTL1      (XT2OFF + RSEL3 + RSEL0)
+#define FIXED_SEND_DCOCTL       (DCO2 + DCO1)
+#define FIXED_RECEIVE_BCSCTL1   (XT2OFF + RSEL3 + RSEL1 + RSEL0)
+#define FIXED_RECEIVE_DCOCTL    0
+
 #define SEND_CLOCK  \
-  BCSCTL1 = XT2OFF + RSEL3 + RSEL0 ; \
-    DCOCTL = DCO2 + DCO1 ;
+  BCSCTL1 = SEND_BCSCTL1 ; \
+    DCOCTL = SEND_DCOCTL ;
   //BCSCTL1 = XT2OFF + RSEL3 + RSEL1 ; \
   //DCOCTL = 0;
 #define RECEIVE_CLOCK \
-  BCSCTL1 = XT2OFF + RSEL3 + RSEL1 + RSEL0; \
-  DCOCTL = 0; \
+  BCSCTL1 = RECEIVE_BCSCTL1; \
+  DCOCTL = RECEIVE_DCOCTL; \
   BCSCTL2 = 0; // Rext = ON
 
+// ACLK sources. LFXT1 needs the crystal pins handed over to the oscillator.
+#define XTAL_ACLK_HZ    32768
+#define XTAL_ACLK_SETUP \
+  do { P2SEL |= CRYSTAL_IN | CRYSTAL_OUT; BCSCTL3 = XCAP_3; } while (0)
+#define VLO_ACLK_HZ     12000
+#define VLO_ACLK_SETUP  \
+  do { BCSCTL3 = LFXT1S_2; } while (0)
+
 #define STATE_READY               0
 #define STATE_ARBITRATE           1
 #define STATE_REPLY               2
@@ -98,10 +119,10 @@ int bitCompare(unsigned char *, unsigned short, unsigned char *,
 void setup_to_receive();
 void sleep();
 unsigned short is_power_good();
+unsigned short vcap_read();
 #if ENABLE_SLOTS
-void lfsr();
 void loadRN16(), mixupRN16();
 #endif // ENABLE_SLOTS
-void crc16_ccitt_readReply(unsigned int);
+void crc16_ccitt_readReply(volatile unsigned char *, unsigned int);
 
 #endif // DLWISP41_H
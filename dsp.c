@@ -0,0 +1,79 @@
+/* See license.txt for license information. */
+
+#include "dlwisp41.h"
+#include "mywisp.h"
+#include "dsp.h"
+#include "ecg_clock.h"
+
+#if ECG_FILTER
+
+void dsp_cic_reset(dsp_cic *f)
+{
+  f->i1 = f->i2 = 0;
+  f->c1 = f->c2 = 0;
+  f->phase = 0;
+}
+
+void dsp_bandpass_reset(dsp_bp *f)
+{
+  f->hp.sum = 0;
+  f->lp1.y = f->lp2.y = 0;
+}
+
+unsigned char dsp_cic_put(dsp_cic *f, unsigned short x, unsigned short *out)
+{
+  // Integrators run at the input rate and are allowed to wrap; the combs
+  // take the wrap back out as long as the true output fits 16 bits.
+  f->i1 += x;
+#if DSP_CIC_ORDER == 2
+  f->i2 += f->i1;
+#endif
+
+  if ( ++f->phase < DSP_CIC_R )
+    return 0;
+  f->phase = 0;
+
+#if DSP_CIC_ORDER == 2
+  unsigned short c = f->i2 - f->c1;
+  f->c1 = f->i2;
+  *out = (unsigned short)(c - f->c2) >> (2*DSP_CIC_SHIFT);
+  f->c2 = c;
+#else
+  *out = (unsigned short)(f->i1 - f->c1) >> DSP_CIC_SHIFT;
+  f->c1 = f->i1;
+#endif
+  return 1;
+}
+
+short dsp_highpass(dsp_hp *f, unsigned short x)
+{
+  // sum += x - sum / 2^k, rounded
+  if ( f->sum == 0 )
+    f->sum = x << DSP_BASELINE_SHIFT;
+  else
+    f->sum += x - ((f->sum + (1 << (DSP_BASELINE_SHIFT - 1)))
+                   >> DSP_BASELINE_SHIFT);
+
+  // x - baseline, both in Q4
+  return (short)(x << 4) -
+         (short)((f->sum + (1 << (DSP_BASELINE_SHIFT - 5)))
+                 >> (DSP_BASELINE_SHIFT - 4));
+}
+
+short dsp_lowpass(dsp_lp *f, short x)
+{
+  short v = x - f->y;
+
+  f->y += DSP_MUL_ROUND(v, DSP_LP_COEF(DSP_FS_HZ, DSP_LP_CUTOFF));
+  return f->y;
+}
+
+short dsp_bandpass(dsp_bp *f, unsigned short x)
+{
+  short y = dsp_highpass(&f->hp, x);
+
+  y = dsp_lowpass(&f->lp1, y);
+  return dsp_lowpass(&f->lp2, y);
+}
+
+#endif // ECG_FILTER
@@ -0,0 +1,125 @@
+/* See license.txt for license information. */
+
+#ifndef DSP_H
+#define DSP_H
+
+/*
+ * Shift-and-add filters for tag-side signal conditioning. The F2132 has no
+ * hardware multiplier, so every coefficient is a compile-time constant and
+ * DSP_MUL() expands it into one shifted add per set bit; the compiler folds
+ * the rest away.
+ *
+ *   dsp_cic_put()      order-2 CIC decimator by DSP_CIC_R (order 1 is a plain
+ *                      moving average); 10-bit in, 10-bit out
+ *   dsp_highpass()     baseline-wander high-pass, ~DSP_BASELINE_HZ
+ *   dsp_lowpass()      one-pole low-pass at DSP_LP_CUTOFF
+ *   dsp_bandpass()     ECG band-pass: dsp_highpass() then dsp_lowpass() twice
+ *
+ * The low-pass is the backward-Euler one-pole
+ *
+ *   y[n] = y[n-1] + a (x[n] - y[n-1]),    a = w / (1 + w),  w = 2 pi fc / fs
+ *
+ * with a worked out from DSP_FS_HZ by the preprocessor. The high-pass takes
+ * x minus a running baseline b[n] = b[n-1] + (x[n] - b[n-1]) / 2^k, kept as
+ * 2^k * b so the subtraction is exact. A general coefficient would leave a
+ * truncation error in a pole this close to 1 that it amplifies by 1/(1-pole),
+ * i.e. a standing offset of tens of counts.
+ *
+ * The filters take 10-bit ADC counts and return signed Q4 (counts times 16),
+ * which keeps truncation well under an ADC LSB and still fits a short.
+ *
+ * Built with ECG_FILTER (mywisp.h), which runs the ECG_HW_CLOCK samples
+ * through dsp_cic_put() and dsp_bandpass(); see ecg_clock.h.
+ * host/bench/dsp_bench.c compares them with a double-precision model.
+ */
+
+#include "mywisp.h"
+
+#if ECG_FILTER && !ECG_HW_CLOCK
+#error "ECG_FILTER needs ECG_HW_CLOCK"
+#endif
+
+// Rate the one-pole sections run at, after any decimation. With ECG_FILTER
+// that's the ECG sample rate (ecg_clock.h, which dsp.c includes).
+#ifndef DSP_FS_HZ
+#if ECG_FILTER
+#define DSP_FS_HZ                 ECG_CLOCK_HZ
+#else
+#define DSP_FS_HZ                 250
+#endif
+#endif
+
+// baseline corner fs / (2 pi 2^k): 0.56 Hz at 226 Hz, 0.62 Hz at 250 Hz
+#define DSP_BASELINE_SHIFT        6
+#define DSP_LP_CUTOFF             400   // tenths of a Hz
+
+#define DSP_CIC_SHIFT             3     // R = 8; 10 + 2*3 bits fits 16
+#define DSP_CIC_R                 (1 << DSP_CIC_SHIFT)
+#define DSP_CIC_ORDER             2     // 1 or 2
+
+#define DSP_Q                     14    // coefficient fraction bits
+
+// fs / (2 pi fc) in Q8, fc in tenths of a Hz (2 pi ~ 710/113)
+#define DSP_RC_Q8(fs, fc10)       ((1130L * (fs) << 8) / (710L * (fc10)))
+#define DSP_LP_COEF(fs, fc10) \
+  ((1L << (DSP_Q + 8)) / ((1L << 8) + DSP_RC_Q8(fs, fc10)))
+
+// x * c / 2^DSP_Q for a constant 0 <= c <= 2^DSP_Q, as shifts and adds
+#define DSP_MUL(x, c) ( \
+  (((c) & 0x4000) ? (x)         : 0) + (((c) & 0x2000) ? (x) >> 1  : 0) + \
+  (((c) & 0x1000) ? (x) >> 2    : 0) + (((c) & 0x0800) ? (x) >> 3  : 0) + \
+  (((c) & 0x0400) ? (x) >> 4    : 0) + (((c) & 0x0200) ? (x) >> 5  : 0) + \
+  (((c) & 0x0100) ? (x) >> 6    : 0) + (((c) & 0x0080) ? (x) >> 7  : 0) + \
+  (((c) & 0x0040) ? (x) >> 8    : 0) + (((c) & 0x0020) ? (x) >> 9  : 0) + \
+  (((c) & 0x0010) ? (x) >> 10   : 0) + (((c) & 0x0008) ? (x) >> 11 : 0) + \
+  (((c) & 0x0004) ? (x) >> 12   : 0) + (((c) & 0x0002) ? (x) >> 13 : 0) + \
+  (((c) & 0x0001) ? (x) >> 14   : 0))
+
+// Each shifted term rounds down, so DSP_MUL() comes out low by about half an
+// LSB per set bit. In a feedback loop that turns into a standing offset;
+// DSP_MUL_ROUND() adds it back.
+#define DSP_BITS(c) ( \
+  (((c) >> 14) & 1) + (((c) >> 13) & 1) + (((c) >> 12) & 1) + \
+  (((c) >> 11) & 1) + (((c) >> 10) & 1) + (((c) >> 9) & 1) + \
+  (((c) >> 8) & 1) + (((c) >> 7) & 1) + (((c) >> 6) & 1) + \
+  (((c) >> 5) & 1) + (((c) >> 4) & 1) + (((c) >> 3) & 1) + \
+  (((c) >> 2) & 1) + (((c) >> 1) & 1) + ((c) & 1))
+#define DSP_MUL_ROUND(x, c)       (DSP_MUL(x, c) + (DSP_BITS(c) >> 1))
+
+typedef struct {
+  unsigned short i1, i2;        // integrators (wrap on purpose)
+  unsigned short c1, c2;        // comb delays
+  unsigned char phase;
+} dsp_cic;
+
+typedef struct {
+  unsigned short sum;           // 2^DSP_BASELINE_SHIFT * baseline
+} dsp_hp;
+
+typedef struct {
+  short y;
+} dsp_lp;
+
+typedef struct {
+  dsp_hp hp;
+  dsp_lp lp1, lp2;
+} dsp_bp;
+
+// Zero the state. A high-pass with zeroed state starts the baseline at the
+// next sample.
+void dsp_cic_reset(dsp_cic *f);
+void dsp_bandpass_reset(dsp_bp *f);
+
+// Feed one sample; returns 1 and writes *out every DSP_CIC_R samples.
+unsigned char dsp_cic_put(dsp_cic *f, unsigned short x, unsigned short *out);
+
+// 10-bit ADC sample in, signed Q4 out
+short dsp_highpass(dsp_hp *f, unsigned short x);
+
+// signed Q4 in and out
+short dsp_lowpass(dsp_lp *f, short x);
+
+// 10-bit ADC sample in, band-passed signed Q4 out
+short dsp_bandpass(dsp_bp *f, unsigned short x);
+
+#endif // DSP_H
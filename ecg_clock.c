@@ -0,0 +1,171 @@
+/* See license.txt for license information. */
+
+#include "dlwisp41.h"
+#include "mywisp.h"
+#include "ecg_clock.h"
+#include "pack.h"
+
+#if ECG_HW_CLOCK
+
+// two DTC blocks, back to back
+static unsigned short ecg_batch[2][ECG_CLOCK_BLOCK];
+
+volatile unsigned short ecg_blocks = 0;
+unsigned short ecg_blocks_sent = 0;
+
+#if ECG_FILTER
+static volatile unsigned short ecg_raw_blocks = 0;
+static dsp_cic ecg_cic;
+static dsp_bp ecg_bp;
+#endif
+
+void ecg_clock_start()
+{
+  ACLK_SETUP;
+
+  SENSOR_POWER_ON;
+  ADC10AE0 |= ECG_CLOCK_ADC10AE;
+
+  ecg_blocks = 0;
+  ecg_blocks_sent = 0;
+#if ECG_FILTER
+  ecg_raw_blocks = 0;
+  dsp_cic_reset(&ecg_cic);
+  dsp_bandpass_reset(&ecg_bp);
+#endif
+
+  ADC10CTL0 &= ~ENC; // make sure this is off otherwise settings are locked.
+  ADC10CTL0 = SREF_0 + ECG_CLOCK_SHT + ADC10ON + ADC10IE;
+  ADC10CTL1 = ECG_CLOCK_INCH + SHS_0 + ECG_CLOCK_ADC10DIV + ADC10SSEL_0 +
+              CONSEQ_2;
+
+  // two-block continuous transfer: block 1, block 2, block 1, ... forever.
+  // Writing ADC10SA arms the DTC.
+  ADC10DTC0 = ADC10TB + ADC10CT;
+  ADC10DTC1 = ECG_CLOCK_BLOCK;
+  ADC10SA = (unsigned short)&ecg_batch[0][0];
+
+  // armed; each tick starts one conversion
+  ADC10CTL0 |= ENC;
+
+  TA1CTL = 0;
+  TA1CCR0 = ECG_CLOCK_TICKS - 1;
+  TA1CCTL0 = CCIE;
+  TA1CTL = TASSEL_1 + MC_1 + TACLR;  // ACLK, up mode
+}
+
+void ecg_clock_stop()
+{
+  TA1CTL = 0;
+  TA1CCTL0 = 0;
+
+  ADC10CTL0 &= ~ENC;
+  while (ADC10CTL1 & ADC10BUSY);    // repeat mode stops after this conversion
+  ADC10CTL1 = 0;       // turn adc off
+  ADC10CTL0 = 0;       // turn adc off
+  ADC10DTC0 = 0;
+
+  SENSOR_POWER_OFF;
+  ADC10AE0 &= ~ECG_CLOCK_ADC10AE;
+}
+
+// Copy the newest finished batch into target and return the index of its
+// first sample. Batches that finished before it and were never sent are
+// skipped; the index tells the reader.
+unsigned short ecg_clock_read(unsigned char volatile *target)
+{
+  unsigned short block = ecg_blocks - 1;
+  unsigned short *batch = ecg_batch[block & 1];
+
+#if ECG_COMPRESS
+  ecg_encode(target, ECG_DATA_BYTES, batch, ECG_BATCH_SAMPLES);
+#else
+  pack_samples(target, batch, ECG_BATCH_SAMPLES);
+#endif
+
+  ecg_blocks_sent = block + 1;
+  return block * ECG_BATCH_SAMPLES;
+}
+
+// Hand out finished blocks one at a time, oldest first, for code that has to
+// see every sample. Returns 0 when there's nothing new. If more than one block
+// has finished since the last call, all but the newest are already being
+// written over, so they're skipped.
+unsigned short *ecg_clock_take(unsigned short *index)
+{
+  unsigned short blocks = ecg_blocks;
+
+  if ( blocks == ecg_blocks_sent )
+    return 0;
+  if ( (unsigned short)(blocks - ecg_blocks_sent) > 1 )
+    ecg_blocks_sent = blocks - 1;
+
+  unsigned short block = ecg_blocks_sent++;
+  *index = block * ECG_BATCH_SAMPLES;
+  return ecg_batch[block & 1];
+}
+
+#if ECG_FILTER
+// signed Q4 around 0 to 10-bit counts around mid-scale
+static unsigned short ecg_counts(short y)
+{
+  y = ((y + 8) >> 4) + 512;
+  if ( y < 0 )
+    return 0;
+  return ( y > 1023 ) ? 1023 : y;
+}
+
+// Filter the newest raw block the DTC has finished into the first
+// ECG_BATCH_SAMPLES words of the same block, and count it as a batch. A
+// block older than that is already being written over and is skipped.
+// Main loop only; the ADC10 interrupt has to stay short.
+void ecg_clock_filter()
+{
+  unsigned short raw = ecg_raw_blocks;
+  unsigned short block = ecg_blocks;
+  unsigned short *batch, x;
+  unsigned char i, n = 0;
+
+  if ( block == raw )
+    return;
+  if ( (unsigned short)(raw - block) > 1 )
+    block = raw - 1;
+
+  batch = ecg_batch[block & 1];
+  for ( i = 0; i < ECG_CLOCK_BLOCK; i++ )
+  {
+    // sample n goes in word n, once words up to R * n + R - 1 are read
+    if ( dsp_cic_put(&ecg_cic, batch[i], &x) )
+      batch[n++] = ecg_counts(dsp_bandpass(&ecg_bp, x));
+  }
+
+  ecg_blocks = block + 1;
+}
+#endif
+
+// Sample clock: one conversion. A few cycles, and doesn't wake the CPU.
+#pragma vector=TIMER1_A0_VECTOR
+__interrupt void ecg_clock_tick_ISR(void)
+{
+  ADC10CTL0 |= ADC10SC;
+}
+
+// A DTC block is full. Blocks alternate starting with block 1, so the count
+// alone says where each one is.
+#pragma vector=ADC10_VECTOR
+__interrupt void ecg_clock_ISR (void)
+{
+#if ECG_FILTER
+  // raw; the filters have to see every block, so wake the main loop for it
+  ecg_raw_blocks++;
+  LPM3_EXIT;
+#else
+  ecg_blocks++;
+#if RR_INTERVALS_IN_ID
+  // the detector has to see every block; wake the main loop for it
+  LPM3_EXIT;
+#endif
+#endif
+}
+
+#endif // ECG_HW_CLOCK
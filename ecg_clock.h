@@ -0,0 +1,108 @@
+/* See license.txt for license information. */
+
+#ifndef ECG_CLOCK_H
+#define ECG_CLOCK_H
+
+/*
+ * Hardware-timed ECG sampling (ECG_HW_CLOCK in mywisp.h).
+ *
+ * Timer1_A runs in up mode from ACLK and its CCR0 interrupt triggers one
+ * ADC10 conversion per period, ECG_CLOCK_TICKS ACLK cycles. The converter
+ * itself runs off ADC10OSC, in spec, with a short sample-and-hold, and the
+ * ADC10 stays in repeat-single-channel mode with ENC set, so the ISR only
+ * sets ADC10SC. The DTC writes the samples into two alternating blocks of
+ * ECG_BATCH_SAMPLES words; the ADC10 interrupt only counts finished blocks.
+ * Every sample has an index (samples since ecg_clock_start(), mod 2^16), so
+ * the reader can put it on a time axis and see any batches it missed.
+ *
+ * With ECG_FILTER the lead is converted DSP_CIC_R times per sample instead,
+ * and each DTC block holds a batch's worth of those. The ADC10 interrupt
+ * wakes the main loop, where ecg_clock_filter() decimates the block with
+ * dsp_cic_put(), band-passes it with dsp_bandpass() and writes the samples
+ * back over the start of the block; only then does the batch count as
+ * finished. Samples come out as 10-bit counts centred on 512.
+ *
+ * Reply payload (ecg_clock_read()), after the header (payload.h) that
+ * carries the index of the first sample:
+ *    ECG_BATCH_SAMPLES samples in the sample payload format (pack.h), or
+ *    with ECG_COMPRESS as many as fit, coded (ecg_codec.h)
+ *
+ * Notes:
+ *  - The ADC10's hardware triggers (SHS_1..3) are Timer0_A3's outputs, and
+ *    that's the RX/TX bit clock, reset on every edge. So the trigger is the
+ *    Timer1_A interrupt: a sample is taken the ISR's entry latency after the
+ *    tick, a few us from LPM3, or after a reply when sendToReader() holds
+ *    GIE off. The period never drifts, since the timer isn't touched; only
+ *    a sample's instant moves, by at most the longest reply.
+ *  - Timer1_A belongs to this module (the sampler and the scheduler can't
+ *    be built alongside it).
+ *  - A batch has to be picked up within ECG_BATCH_SAMPLES sample periods of
+ *    finishing, or the DTC writes over it and it's skipped. With ECG_FILTER
+ *    the same goes for filtering a block; the filters just carry on across
+ *    the gap.
+ *  - Sample rates are nominal on the VLO (see step 2(d) in mywisp.h).
+ */
+
+#include "mywisp.h"
+#include "ecg_codec.h"
+#include "dsp.h"
+
+#if ECG_HW_CLOCK
+
+#if (ACTIVE_SENSOR != SENSOR_ECG)
+#error "ECG_HW_CLOCK needs ACTIVE_SENSOR == SENSOR_ECG"
+#endif
+
+// the batch has to fit the EPC or readReply after the payload header (see
+// payload.h). Packed, that's up to 6 or 8 samples at 10 bits.
+#if ECG_COMPRESS && (ECG_BATCH_SAMPLES > ECG_CODEC_MAX_SAMPLES)
+#error "ECG_BATCH_SAMPLES is at most 15 with ECG_COMPRESS"
+#endif
+
+// two blocks of ECG_BATCH_SAMPLES * DSP_CIC_R words: 128 bytes at 4
+#if ECG_FILTER && (ECG_BATCH_SAMPLES > 4)
+#error "ECG_BATCH_SAMPLES is at most 4 with ECG_FILTER"
+#endif
+
+#if ECG_FILTER
+#define ECG_CLOCK_DECIMATE        DSP_CIC_R
+#else
+#define ECG_CLOCK_DECIMATE        1
+#endif
+#define ECG_CLOCK_BLOCK           (ECG_BATCH_SAMPLES * ECG_CLOCK_DECIMATE)
+
+// 32768 / 131 = 250.1 Hz on the crystal, 12000 / 48 = 250 Hz on the VLO.
+// With ECG_FILTER, conversions at 32768 / 16 or 12000 / 6, and 256 or 250 Hz
+// after decimation.
+#define ECG_CLOCK_RATE_HZ         250
+#define ECG_CLOCK_TICKS           (ACLK_HZ / (ECG_CLOCK_RATE_HZ * \
+                                              ECG_CLOCK_DECIMATE))
+#define ECG_CLOCK_HZ              (ACLK_HZ / (ECG_CLOCK_TICKS * \
+                                              ECG_CLOCK_DECIMATE))
+
+// ADC10OSC (~5 MHz) / 4, 16 cycles of sample-and-hold: ~13 us, then ~10 us
+// to convert
+#define ECG_CLOCK_ADC10DIV        ADC10DIV_3
+#define ECG_CLOCK_SHT             ADC10SHT_2
+
+#define ECG_CLOCK_INCH            INCH_DEBUG_2_3
+#define ECG_CLOCK_ADC10AE         DEBUG_2_3
+
+// blocks the DTC (and with ECG_FILTER the filters) have finished, and the
+// last one sent
+extern volatile unsigned short ecg_blocks;
+extern unsigned short ecg_blocks_sent;
+
+#define ecg_clock_pending()       (ecg_blocks != ecg_blocks_sent)
+
+void ecg_clock_start();
+void ecg_clock_stop();
+unsigned short ecg_clock_read(unsigned char volatile *target);
+unsigned short *ecg_clock_take(unsigned short *index);
+#if ECG_FILTER
+void ecg_clock_filter();
+#endif
+
+#endif // ECG_HW_CLOCK
+
+#endif // ECG_CLOCK_H
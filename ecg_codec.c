@@ -0,0 +1,104 @@
+/* See license.txt for license information. */
+
+#include "mywisp.h"
+#include "ecg_codec.h"
+
+#if ECG_COMPRESS
+
+// bit writer: bits go in at the bottom of acc, whole bytes come out the top
+static unsigned char volatile *out;
+static unsigned long acc;
+static unsigned char pending;
+
+static void put_bits(unsigned short value, unsigned char nbits)
+{
+  acc = (acc << nbits) | value;
+  pending += nbits;
+
+  while ( pending >= 8 )
+  {
+    pending -= 8;
+    *out++ = (unsigned char)(acc >> pending);
+  }
+}
+
+// residual of s[i] against its prediction, folded to unsigned
+static unsigned short residual(const unsigned short *s, unsigned char i)
+{
+  short p;
+
+  if ( ECG_CODEC_ORDER == 1 || i == 1 )
+    p = s[i-1];
+  else
+    p = (s[i-1] << 1) - s[i-2];
+
+  short r = (short)s[i] - p;
+  return ( r >= 0 ) ? ((unsigned short)r << 1) : (((unsigned short)~r << 1) | 1);
+}
+
+unsigned char ecg_encode(unsigned char volatile *target, unsigned char bytes,
+                         const unsigned short *samples, unsigned char n)
+{
+  unsigned short sum = 0;
+  unsigned char k = 0;
+  unsigned char i;
+
+  if ( n == 0 )
+    return 0;
+  if ( n > ECG_CODEC_MAX_SAMPLES )
+    n = ECG_CODEC_MAX_SAMPLES;
+
+  // k from the mean folded residual: the smallest k with mean < 2^(k+1).
+  // Residuals are under 2^12 and there are at most 14, so sum can't wrap.
+  for ( i = 1; i < n; i++ )
+    sum += residual(samples, i);
+  if ( n > 1 )
+    while ( k < ECG_RICE_MAX_K && ((unsigned short)(n - 1) << (k + 1)) <= sum )
+      k++;
+
+  out = target;
+  acc = 0;
+  pending = 0;
+
+  // header byte goes out now; the count is patched in at the end
+  put_bits((ECG_CODEC_ORDER - 1) << 3 | k, 8);
+  put_bits(samples[0] & 0x03ff, 10);
+
+  unsigned short room = ((unsigned short)bytes << 3) - 18;
+
+  for ( i = 1; i < n; i++ )
+  {
+    unsigned short u = residual(samples, i);
+    unsigned short q = u >> k;
+    unsigned char len;
+
+    if ( q < ECG_RICE_ESCAPE )
+      len = q + 1 + k;
+    else
+      len = ECG_RICE_ESCAPE + 10;
+
+    if ( len > room )
+      break;
+    room -= len;
+
+    if ( q < ECG_RICE_ESCAPE )
+    {
+      put_bits((1 << q) - 1, q);   // q ones (q < 10 so this fits)
+      put_bits(0, 1);
+      put_bits(u & ((1 << k) - 1), k);
+    }
+    else
+    {
+      put_bits((1 << ECG_RICE_ESCAPE) - 1, ECG_RICE_ESCAPE);
+      put_bits(samples[i] & 0x03ff, 10);
+    }
+  }
+
+  if ( pending )
+    *out = (unsigned char)(acc << (8 - pending));
+
+  target[0] |= i << 4;
+  return i;
+}
+
+#endif // ECG_COMPRESS
@@ -0,0 +1,49 @@
+/* See license.txt for license information. */
+
+#ifndef ECG_CODEC_H
+#define ECG_CODEC_H
+
+/*
+ * Lossless ECG block coder (ECG_COMPRESS in mywisp.h).
+ *
+ * Each 10-bit sample is predicted from the ones before it, and the residual
+ * is Rice coded with one parameter k per block. Only shifts, adds and
+ * compares; no multiplies, no tables.
+ *
+ *   order 1:  p = x[n-1]
+ *   order 2:  p = 2*x[n-1] - x[n-2]   (order 1 for the second sample)
+ *
+ * The residual r = x - p is folded to u = 2r (r >= 0) or -2r-1 (r < 0). With
+ * q = u >> k, a sample is sent as q one-bits, a zero and the low k bits of u;
+ * if q would be ECG_RICE_ESCAPE or more it's sent as ECG_RICE_ESCAPE one-bits
+ * and the raw 10-bit sample instead. Coding is lossless, so the decoder always
+ * predicts from the same samples the tag did.
+ *
+ * Coded block, MSB first, zero padded to a whole byte:
+ *   4 bits  number of samples coded
+ *   1 bit   order - 1
+ *   3 bits  k
+ *   10 bits first sample, raw
+ *   codes for the rest
+ *
+ * Samples are coded in order until the next one wouldn't fit in the payload,
+ * so a noisy block comes out shorter instead of overflowing.
+ * host/wisp_ecg_decode.c is the decoder.
+ */
+
+#include "mywisp.h"
+
+#if ECG_COMPRESS && !ECG_HW_CLOCK
+#error "ECG_COMPRESS needs ECG_HW_CLOCK"
+#endif
+
+#define ECG_RICE_ESCAPE           10
+#define ECG_RICE_MAX_K            7
+#define ECG_CODEC_MAX_SAMPLES     15
+
+// Code up to n samples into at most bytes bytes (3 or more) at target.
+// Returns the number of samples coded.
+unsigned char ecg_encode(unsigned char volatile *target, unsigned char bytes,
+                         const unsigned short *samples, unsigned char n);
+
+#endif // ECG_CODEC_H
@@ -2,32 +2,20 @@
 /* Revised on March 20th, 2014 by Michael Nolan. Adapted to ECG monitoring application (bigger B, faster sr, etc) */
 
 #include "mywisp.h"
-#if (ACTIVE_SENSOR == SENSOR_EEG_ARTEM)
+#if ECG_PERIOD
 
 #include "dlwisp41.h"
 #include "rfid.h"
-#include "ecg_sensor.h"
+#include "ecg_sensor_nolan.h"
+#include "adc_seq.h"
+#include "pack.h"
 
-unsigned char sensor_busy = 0;
-
-void init_sensor()
+static void ecg_start()
 {
-  return;
-}
-
-void read_sensor(unsigned char volatile *target)
-{
-
-  // turn off comparator
-  P1OUT &= ~RX_EN_PIN;
-
   // slow down clock
   BCSCTL1 = XT2OFF + RSEL1; // select internal resistor (still has effect when DCOR=1)
   DCOCTL = DCO1+DCO0; // set DCO step.
 
-  if(!is_power_good())
-    sleep();
-
   // Clear out any lingering voltage on the accelerometer outputs
   ADC10AE0 = 0;
 
@@ -45,50 +33,24 @@ void read_sensor(unsigned char volatile *target)
   P1DIR |= ACCEL_POWER;
   P1OUT |= ACCEL_POWER;
   ADC10AE0 |= ACCEL_X | ACCEL_Y | ACCEL_Z;
+}
 
+static unsigned char ecg_collect(unsigned char volatile *target)
+{
   // a little time for regulator to stabilize active mode current AND
   // filter caps to settle.
   for(int i = 0; i < 225; i++);
   RECEIVE_CLOCK;
 
-  // GRAB DATA
-  ADC10CTL0 &= ~ENC; // make sure this is off otherwise settings are locked.
-  ADC10CTL0 = SREF_0 + ADC10SHT_1 + ADC10ON;
-  ADC10CTL1 = ADC10DIV_3 + ADC10SSEL_0 + SHS_0 + CONSEQ_0 + INCH_DEBUG_2_3;
-  ADC10CTL0 |= ENC;
-  ADC10CTL0 |= ADC10SC;
-
-  while (ADC10CTL1 & ADC10BUSY);    // wait while ADC finished work
+  // GRAB DATA: one sequence converts A3 (ECG) down to A0. A2 comes along for
+  // the ride and is dropped (overwritten with A3 so the three we keep are
+  // contiguous).
+  unsigned short samples[4];
+  adc_seq_read(samples, 4, SREF_0 + ADC10SHT_1,
+               ADC10DIV_3 + ADC10SSEL_0 + SHS_0 + INCH_DEBUG_2_3);
 
-  ackReply[4] = (ADC10MEM & 0xff);
-  // grab msb bits and store it
-  ackReply[3] = (ADC10MEM & 0x0300) >> 8;
-
-  // GRAB DATA
-  ADC10CTL0 &= ~ENC; // make sure this is off otherwise settings are locked.
-  ADC10CTL0 = SREF_0 + ADC10SHT_1 + ADC10ON;
-  ADC10CTL1 = ADC10DIV_3 + ADC10SSEL_0 + SHS_0 + CONSEQ_0 + INCH_ACCEL_Y;
-  ADC10CTL0 |= ENC;
-  ADC10CTL0 |= ADC10SC;
-
-  while (ADC10CTL1 & ADC10BUSY);    // wait while ADC finished work
-
-  ackReply[6] = (ADC10MEM & 0xff);
-  // grab msb bits and store it
-  ackReply[5] = (ADC10MEM & 0x0300) >> 8;
-
-  // GRAB DATA
-  ADC10CTL0 &= ~ENC; // make sure this is off otherwise settings are locked.
-  ADC10CTL0 = SREF_0 + ADC10SHT_1 + ADC10ON;
-  ADC10CTL1 = ADC10DIV_3 + ADC10SSEL_0 + SHS_0 + CONSEQ_0 + INCH_ACCEL_Z;
-  ADC10CTL0 |= ENC;
-  ADC10CTL0 |= ADC10SC;
-
-  while (ADC10CTL1 & ADC10BUSY);    // wait while ADC finished work
-
-  ackReply[8] = (ADC10MEM & 0xff);
-  // grab msb bits and store it
-  ackReply[7] = (ADC10MEM & 0x0300) >> 8;
+  samples[1] = samples[0];
+  pack_samples(target, &samples[1], 3);
 
   // Power off sensor and adc
   P1DIR &= ~ACCEL_POWER;
@@ -96,15 +58,11 @@ void read_sensor(unsigned char volatile *target)
   ADC10CTL0 &= ~ENC;
   ADC10CTL1 = 0;       // turn adc off
   ADC10CTL0 = 0;       // turn adc off
-
-  // Store sensor read count
-  sensor_counter++;
-  ackReply[10] = (sensor_counter & 0x00ff);
-  // grab msb bits and store it
-  ackReply[9]  = (sensor_counter & 0xff00) >> 8;
-
-  // turn on comparator
-  P1OUT |= RX_EN_PIN;
+  return 1;
 }
 
-#endif // (ACTIVE_SENSOR == SENSOR_ACCEL_QUICK)
+const sensor_driver ecg_driver = {
+  ECG_TYPE_ID, ECG_READING_BYTES, 0, ecg_start, ecg_collect
+};
+
+#endif // ECG_PERIOD
@@ -6,15 +6,58 @@
 
 //  bit definitions specific to the WISP 4.1 DL
 
-#define SENSOR_DATA_TYPE_ID     0X0B
+#define ECG_TYPE_ID                 0x10
+#define ECG_RR_TYPE_ID              0x11    // RR report, see qrs.h
 
-#define ACCEL_ENABLE_BIT            BITS    //  1.5
+#define ACCEL_ENABLE_BIT            BIT5    //  1.5
 #define SET_ACCEL_ENABLE_DIR        P1DIR |= ACCEL_ENABLE_BIT
-#define CLEAR_ACCEL_ENABLE_DIR    PIDIR &= ~ACCEL_ENABLE_BIT
-#define TURN_ON_ACCEL_ENABLE  P1OUT |= ACCEL_ENABLE_BIT
-#define TURN_OFF_ACCEL_ENABLE    P1OUT &= ~ACCEL_ENABLE_BIT
+#define CLEAR_ACCEL_ENABLE_DIR      P1DIR &= ~ACCEL_ENABLE_BIT
+#define TURN_ON_ACCEL_ENABLE        P1OUT |= ACCEL_ENABLE_BIT
+#define TURN_OFF_ACCEL_ENABLE       P1OUT &= ~ACCEL_ENABLE_BIT
 
-#define DATA_LENGTH_IN_WORDS        3
-#define DATA_LENGTH_IN_BYTES        (DATA_LENGTH_IN_WORDS*2)
+// one ecg_driver reading: ECG, accel Y and accel Z
+#define ECG_READING_BYTES           PACKED_BYTES(3)
+
+#if RR_INTERVALS_IN_ID
+// two RR intervals (see qrs.h)
+#define ECG_DATA_BYTES              4
+#elif ECG_HW_CLOCK && ECG_COMPRESS
+// a coded batch filling the rest of the EPC or 5 words of the Read reply
+// (see ecg_codec.h)
+#if DATA_IN_EPC
+#define ECG_DATA_BYTES              EPC_DATA_BYTES
+#else
+#define ECG_DATA_BYTES              10
+#endif
+#elif ECG_HW_CLOCK
+// a batch of samples (see ecg_clock.h)
+#define ECG_DATA_BYTES              PACKED_BYTES(ECG_BATCH_SAMPLES)
+#else
+#define ECG_DATA_BYTES              ECG_READING_BYTES
+#endif
+
+extern const sensor_driver ecg_driver;
+
+#if (ACTIVE_SENSOR == SENSOR_ECG)
+#if RR_INTERVALS_IN_ID
+#define SENSOR_DATA_TYPE_ID         ECG_RR_TYPE_ID
+#else
+#define SENSOR_DATA_TYPE_ID         ECG_TYPE_ID
+#endif
+
+//  BACKGROUND_SAMPLING settings (see sampler.h). ECG lead on A3, plus the two
+//  channels ecg_driver also returns.
+#define SENSOR_POWER_ON \
+  do { SET_ACCEL_ENABLE_DIR; TURN_ON_ACCEL_ENABLE; } while (0)
+#define SENSOR_POWER_OFF \
+  do { CLEAR_ACCEL_ENABLE_DIR; TURN_OFF_ACCEL_ENABLE; } while (0)
+#define SAMPLE_CHANNELS             3
+#define SAMPLE_SEQ_INCH             INCH_DEBUG_2_3
+#define SAMPLE_SEQ_LEN              4
+#define SAMPLE_SLOT_LIST            0, 2, 3
+#define SAMPLE_ADC10AE              (DEBUG_2_3 | ACCEL_Y | ACCEL_Z)
+#define SAMPLE_ADC10CTL0            (SREF_0 + ADC10SHT_1)
+#define SAMPLE_ADC10CTL1            (ADC10DIV_3 + ADC10SSEL_0)
+#endif
 
 #endif  //  ECG_SENSOR_NOLAN_H
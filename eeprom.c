@@ -8,116 +8,212 @@
 
 #include "eeprom.h"
 
-extern unsigned char deviceaddress=0x50;
-extern unsigned char byteaddress=0x00;
-extern unsigned char block=0x00;
+#if I2C_IN_IMAGE
 
+// A write cycle may still be going on: the chip NACKs until it's done.
+static unsigned char eeprom_writing = 0;
+
+#if ARCHIVE_SAMPLES
+unsigned short eeprom_write_errors = 0;
+
+// eeprom_append() state: one page fills while the other is written
+static unsigned char eeprom_page[2][EEPROM_PAGE_BYTES];
+static unsigned char eeprom_fill = 0;         // the page being filled
+static unsigned char eeprom_first = 0;        // its first byte buffered
+static int eeprom_at = 0;                     // address of the next byte
+static i2c_request eeprom_out;                // the last page queued
+#endif
+
+void eeprom_request(i2c_request *r, int address, unsigned char *data,
+                    int length, unsigned char read)
+{
+  r->slave = EEPROM_SLAVE | ((address >> 8) & 0x03);
+  r->read = read;
+  r->head_len = 1;
+  r->head[0] = address;                 // word address within the block
+  r->data = data;
+  r->len = length;
+  r->done = 0;
+}
+
+// At every boot: the USCI doesn't survive a reset, and the chip may still be
+// busy with a write from before.
 void init_eeprom() {
-  P3SEL |= 0x06;							// Assign I2C pins to USCI_B0
-  UCB0CTL1 |= UCSWRST;						// Enable SW reset
-  UCB0CTL0 = UCMST + UCMODE_3 + UCSYNC;		// I2C master, synchronous mode
-  UCB0CTL1 = UCSSEL_2 + UCSWRST;			// Use SMCLK, keep SW reset
-  UCB0BR0 =12;								// fSCL = SMCLK/12 = ~100kHz
-  UCB0BR1 = 0;
-  UCB0CTL1 &= ~UCSWRST;						// Clear SW reset, resume operation
+  i2c_init();
+  eeprom_writing = 1;
+#if ARCHIVE_SAMPLES
+  eeprom_out.status = I2C_IDLE;       // lost with the reset, if it was queued
+#endif
 }
 
-unsigned char write_eeprom(int address, unsigned char *data, int length){
-  int i = 0;
-
-  UCB0I2CSA = 0x50 | ((address >> 8) & 0x03);		// Set slave address
-
-  UCB0CTL1 |= UCTR + UCTXSTT;         // I2C TX, start condition, transmit mode
-  while(!(IFG2 & UCB0TXIFG));			// Wait for the TXT flag to set
-  IFG2 &= ~UCB0TXIFG;					// Clear the TX buffer flag
-  UCB0TXBUF = byteaddress;			// Send the write address
-  while(UCB0CTL1 & UCTXSTT);			// Wait for the start condition to clear
-
-  if(UCB0STAT & UCNACKIFG)			// If a NACK is received
-  {
-    UCB0STAT &= ~UCNACKIFG;			// Clear the NACK
-    UCB0CTL1 |= UCTXSTP;			// Send STP
-    while(UCB0CTL1 & UCTXSTP);		// Wait for STP to clear
-    return 0;						// Return 0 (failure)
+// ACK polling: address the chip until it answers, i.e. until the last write
+// cycle is over. Each try is a current-address read, ~30 SCL clocks asleep
+// in LPM0.
+static unsigned char eeprom_ready()
+{
+  i2c_request r;
+  unsigned char dummy;
+  unsigned char n;
+
+  if(!eeprom_writing)
+    return 1;
+
+  for(n = 0; n < EEPROM_POLL_MAX; n++){
+    r.slave = EEPROM_SLAVE;
+    r.read = 1;
+    r.head_len = 0;
+    r.data = &dummy;
+    r.len = 1;
+    r.done = 0;
+    i2c_submit(&r);
+    if(i2c_wait(&r) == I2C_DONE){
+      eeprom_writing = 0;
+      return 1;
+    }
   }
 
-  for(i=0;i<length;i++){
-    while(!(IFG2 & UCB0TXIFG));		// Wait for the TX flag to set
-    IFG2 &= ~UCB0TXIFG;				// Clear the TX buffer flag
-    UCB0TXBUF = *data;				// Send a byte of data
-    data++;
+  return 0;
+}
+
+#if ARCHIVE_SAMPLES
+// Wait for the page eeprom_append() queued last, if any.
+static unsigned char eeprom_settle()
+{
+  if(eeprom_out.status == I2C_IDLE)
+    return 1;
+
+  if(i2c_wait(&eeprom_out) != I2C_DONE){
+    eeprom_out.status = I2C_IDLE;
+    eeprom_write_errors++;
+    return 0;
   }
-  while(!(IFG2 & UCB0TXIFG));			// Wait for the TX flag to set
-  UCB0CTL1 |= UCTXSTP;				// Send stop condition
-  while(UCB0CTL1 & UCTXSTP);			// Wait for the stop condition to clear
 
+  eeprom_out.status = I2C_IDLE;
+  return 1;
+}
+
+#else
+#define eeprom_settle()
+#endif
+
+// Page writes: the chip latches up to a page and programs it in one write
+// cycle, but wraps around within the page, so split there.
+unsigned char write_eeprom(int address, unsigned char *data, int length){
+  i2c_request r;
+  int n;
+
+  eeprom_settle();
 
-  delay_cycles(4000);					// Sleep 4k cycles
-  IFG2 &= ~UCB0TXIFG;					// Clear TX flag
+  while(length > 0){
+    n = EEPROM_PAGE_BYTES - (address & (EEPROM_PAGE_BYTES-1));
+    if(n > length)
+      n = length;
+
+    if(!eeprom_ready())
+      return 0;						// Return 0 (failure)
+
+    eeprom_request(&r, address, data, n, 0);
+    i2c_submit(&r);
+    if(i2c_wait(&r) != I2C_DONE)		// If a NACK is received
+      return 0;						// Return 0 (failure)
+    eeprom_writing = 1;
+
+    address += n;
+    data += n;
+    length -= n;
+  }
 
   return 1;							// Return 1 (success)
 }
 
+// Random read, then sequential: one address phase, and the EEPROM streams
+// the bytes out, ACKed all but the last. One transfer per block, since
+// the word address is only 8 bits.
 unsigned char read_eeprom(int address, unsigned char *data, int length){
-  int i=0;
+  i2c_request r;
+  int n;
 
-  UCB0I2CSA = 0x50 | ((address >> 8) & 0x03);		// Set slave address
+  eeprom_settle();
 
-  for(i=0;i<length;i++){
+  while(length > 0){
+    n = EEPROM_BLOCK_BYTES - (address & (EEPROM_BLOCK_BYTES-1));
+    if(n > length)
+      n = length;
 
-    UCB0CTL1 |= UCTR + UCTXSTT;		// I2C startion condition, transmit mode
-    while(!(IFG2 & UCB0TXIFG));		// Wait for TX flag to set
-    IFG2 &= ~UCB0TXIFG;				// Clear the TX buffer flag
-    UCB0TXBUF = byteaddress+i;		// Send the read address
-    while(UCB0CTL1 & UCTXSTT);		// Wait for start condition to clear
-
-    if(UCB0STAT & UCNACKIFG)			// If a NACK is received
-    {
-      UCB0STAT &= ~UCNACKIFG;			// Clear the NACK
-      UCB0CTL1 |= UCTXSTP;			// Send STP
-      while(UCB0CTL1 & UCTXSTP);		// Wait for STP to clear
+    if(!eeprom_ready())
       return 0;						// Return 0 (failure)
-    }
 
-    while(!(IFG2 & UCB0TXIFG));		// Wait for TX flag to set
-    IFG2 &= ~UCB0TXIFG;				// Clear the TX flag
+    eeprom_request(&r, address, data, n, 1);
+    i2c_submit(&r);
+    if(i2c_wait(&r) != I2C_DONE)		// If a NACK is received
+      return 0;						// Return 0 (failure)
 
-    UCB0CTL1 &= ~UCTR;				// I2C start condition, receive mode
-    IFG2 &= ~UCB0RXIFG;				// Clear the RX flag
-    IFG2 &= ~UCB0TXIFG;				// Clear the TX flag
-    UCB0CTL1 |= UCTXSTT;			// Send a start condition
-    while(UCB0CTL1 & UCTXSTT);		// Wait for the start to clear
-    UCB0CTL1 |= UCTXSTP;			// Send a stop condition
+    address += n;
+    data += n;
+    length -= n;
+  }
 
-    while(UCB0CTL1 & UCTXSTP);		// Wait for the stop condition to set
+  return 1;							// Return 1 (success)
+}
 
-    *data = UCB0RXBUF;				// Send byte of data
-    data++;
-    IFG2 &= ~UCB0RXIFG;				// Clear receive flag
+#if ARCHIVE_SAMPLES
+void eeprom_append_at(int address)
+{
+  eeprom_append_flush();
+  eeprom_at = address & (EEPROM_BYTES-1);
+  eeprom_first = eeprom_at & (EEPROM_PAGE_BYTES-1);
+}
 
-    delay_cycles(4000);				// Sleep 4k cycles
+// Queue the bytes buffered in this page and go on with the other buffer.
+// The chip is only polled once this page is due, so the last one's write
+// cycle has usually long finished.
+static unsigned char eeprom_page_out()
+{
+  int end = eeprom_at ? eeprom_at : EEPROM_BYTES;
+  int page = (end - 1) & ~(EEPROM_PAGE_BYTES-1);
+  unsigned char last = (end - 1) & (EEPROM_PAGE_BYTES-1);
+  unsigned char ok;
+
+  ok = eeprom_settle();
+  if(!eeprom_ready()){
+    eeprom_write_errors++;
+    ok = 0;
+  } else {
+    eeprom_request(&eeprom_out, page + eeprom_first,
+                   &eeprom_page[eeprom_fill][eeprom_first],
+                   last + 1 - eeprom_first, 0);
+    i2c_submit(&eeprom_out);
+    eeprom_writing = 1;
   }
 
-  return 1;							// Return 1 (success)
+  eeprom_fill ^= 1;
+  eeprom_first = eeprom_at & (EEPROM_PAGE_BYTES-1);
+  return ok;
 }
 
-// Enter LPM3 for <i>num_of_cycles</i> cycles, giving the EEPROM chip time to
-// complete operations. If we do not sleep long enough, the EEPROM will get into
-// a bad state recoverable only by power cycling.
-void delay_cycles(unsigned int num_of_cycles) {
-  TA1CCTL1 = CCIE;                       // TA1CCR1 interrupt enabled
-  TA1CCR1 = num_of_cycles;              // Cycles to count before triggering
-  TA1CTL = TASSEL_1 + MC_2 + TAIE;      // ACLCK, continuous, interrupt enabled
-  __bis_SR_register(LPM3_bits + GIE);   // Enter LPM3 with interrupt
+unsigned char eeprom_append(const unsigned char *data, int length)
+{
+  unsigned char ok = 1;
+
+  while(length-- > 0){
+    eeprom_page[eeprom_fill][eeprom_at & (EEPROM_PAGE_BYTES-1)] = *data++;
+    eeprom_at = (eeprom_at + 1) & (EEPROM_BYTES-1);
+    if((eeprom_at & (EEPROM_PAGE_BYTES-1)) == 0)
+      ok &= eeprom_page_out();
+  }
+
+  return ok;
 }
 
-//Timer1_A1 interrupt vector handler
-#pragma vector=TIMER1_A1_VECTOR
-__interrupt void Timer1_A1(void)
+unsigned char eeprom_append_flush()
 {
-  TA1CCTL1 = 0;             // Clear interrupt flag
-  TA1CTL = 0;               // Clear control register (disables interrupts)
-  TA1R = 0;                 // Reset overflow
-  TA1CCR1 = 0;              // Reset capture/compare register
-  LPM3_EXIT;                // Wake up
+  unsigned char ok = 1;
+
+  if((eeprom_at & (EEPROM_PAGE_BYTES-1)) != eeprom_first)
+    ok = eeprom_page_out();
+
+  return eeprom_settle() & ok;
 }
+#endif // ARCHIVE_SAMPLES
+
+#endif // I2C_IN_IMAGE
@@ -10,13 +10,47 @@
 
 #include <msp430x21x2.h>
 #include "dlwisp41.h"
+#include "mywisp.h"
+#include "i2c.h"
 
+// 24xx08: 1 kB in four 256-byte blocks, the block number in the low bits of
+// the slave address
+#define EEPROM_SLAVE              0x50
+#define EEPROM_BYTES              1024
+#define EEPROM_BLOCK_BYTES        256
+#define EEPROM_PAGE_BYTES         16
+
+// ACK polls to wait at most for a write cycle (5 ms max). One the chip
+// NACKs is ~11 SCL clocks, 110 us at 100 kHz and less with a faster SMCLK.
+#define EEPROM_POLL_MAX           128
+
+
+// Fill in r to read or write length bytes at address, one transfer. It
+// mustn't cross a block boundary.
+void eeprom_request(i2c_request *r, int address, unsigned char *data,
+                    int length, unsigned char read);
+
+// Transfers go through the I2C engine (i2c.h); these wait for theirs, asleep.
+// After a write the chip is busy programming for a while; whatever comes
+// next polls it for an ACK first instead of sleeping a fixed time.
+// host/bench/eeprom_bench.c runs them against a 24xx08 model.
 void init_eeprom();
 unsigned char write_eeprom(int address, unsigned char *data, int length);
 unsigned char read_eeprom(int address, unsigned char *data, int length);
 
-// Uses a timed LPM3 delay to wait for the EEPROM chip to complete operations.
-void delay_cycles(unsigned int num_of_cycles);
+#if ARCHIVE_SAMPLES
+extern unsigned short eeprom_write_errors;    // pages eeprom_append() lost
+
+// Page-buffered logging for the archive (archive.h), only built with it
+// since the page buffers cost RAM. Bytes collect in RAM and go out a page
+// at a time, one write cycle per page. A full page is queued and
+// eeprom_append() returns while it's written; it only waits if the next
+// page fills first. Addresses wrap at EEPROM_BYTES. Return 0 if a page
+// didn't make it.
+void eeprom_append_at(int address);
+unsigned char eeprom_append(const unsigned char *data, int length);
+unsigned char eeprom_append_flush();   // write a partial page, and wait
+#endif
 
 #endif // EEPROM_H
 
@@ -0,0 +1,100 @@
+/* See license.txt for license information. */
+
+#include "dlwisp41.h"
+#include "mywisp.h"
+#include "energy.h"
+
+#if ENERGY_POLICY
+
+unsigned char energy_replies = 0;
+unsigned short energy_reply_cost = 0;
+unsigned short energy_defers = 0;
+unsigned short energy_rests = 0;
+
+static unsigned short energy_last = 0;  // level at the last measurement
+
+unsigned short energy_level()
+{
+  unsigned short v = vcap_read();
+
+  return ENERGY_OF(v);
+}
+
+// Stop listening and sleep until the level is back up to need, or
+// ENERGY_REST_MAX intervals have gone by. Returns the level.
+static unsigned short energy_rest(unsigned long need)
+{
+  unsigned short e = 0;
+  unsigned char i;
+
+  P1OUT &= ~RX_EN_PIN;   // turn off comparator
+  P1IE = 0;
+
+  ACLK_SETUP;
+  WDTCTL = WDT_ADLY_16;
+  IE1 |= WDTIE;
+  for ( i = 0; i < ENERGY_REST_MAX; i++ )
+  {
+    _BIS_SR(LPM3_bits + GIE);
+    e = energy_level();
+    if ( e >= need )
+      break;
+  }
+  IE1 &= ~WDTIE;
+  WDTCTL = WDTPW + WDTHOLD;
+
+  return e;
+}
+
+unsigned char energy_allow(unsigned short cost)
+{
+  unsigned short e = energy_level();
+  unsigned long need;
+
+  // what went since the last measurement went on replies and listening
+  if ( energy_replies )
+  {
+    unsigned short per = (energy_last > e) ?
+                         (energy_last - e) / energy_replies : 0;
+    energy_reply_cost += (per >> 2) - (energy_reply_cost >> 2);
+    energy_replies = 0;
+  }
+
+  need = ENERGY_FLOOR +
+         (unsigned long)energy_reply_cost * ENERGY_REPLY_RESERVE;
+
+  if ( e < need )
+  {
+    energy_rests++;
+    e = energy_rest(need + cost);
+  }
+  energy_last = e;
+
+  if ( e >= need + cost )
+    return 1;
+
+  energy_defers++;
+  return 0;
+}
+
+void energy_spent(unsigned short *cost)
+{
+  unsigned short e = energy_level();
+  unsigned short used = (energy_last > e) ? energy_last - e : 0;
+
+  if ( *cost == 0 )
+    *cost = used;       // first reading: nothing to average with yet
+  else
+    *cost += (used >> 2) - (*cost >> 2);
+  energy_last = e;
+}
+
+#if !ADAPTIVE_SETTLE && !ACCEL_PERIOD // else settle.c or accel_sensor.c
+#pragma vector=WDT_VECTOR
+__interrupt void energy_wdt_ISR(void)
+{
+  LPM4_EXIT;
+}
+#endif
+
+#endif // ENERGY_POLICY
@@ -0,0 +1,68 @@
+/* See license.txt for license information. */
+
+#ifndef ENERGY_H
+#define ENERGY_H
+
+/*
+ * Energy-aware sampling (ENERGY_POLICY in mywisp.h).
+ *
+ * Before each sensor reading, energy_allow() measures the storage capacitor
+ * (vcap_read()) and decides:
+ *
+ *   sample  enough above ENERGY_VCAP_MIN_MV for the reading and for
+ *           ENERGY_REPLY_RESERVE replies to get it to the reader
+ *   defer   enough for the replies only: skip the reading and keep
+ *           answering with the payload we have; the sensor is tried again
+ *           at its next deadline, a period later
+ *   rest    not even that: stop listening and sleep in LPM3 on the watchdog
+ *           until the cap has charged up for the reading, then take it
+ *
+ * Levels are stored energy in arbitrary units, (counts/4)^2, so differences
+ * are energy spent. Costs are learned, not configured: each sensor's from
+ * the level before and after its reading, the reply cost from the drop
+ * between two plans divided by the replies sent in between (so it includes
+ * the listening, net of what was harvested meanwhile). Both are running
+ * averages.
+ *
+ * is_power_good() and sleep() still catch a supervisor dropout; this just
+ * tries to never get there in the middle of a reading.
+ */
+
+#include "mywisp.h"
+
+#if ENERGY_POLICY
+
+#if !READ_SENSOR
+#error "ENERGY_POLICY needs one of the sensor applications"
+#endif
+
+#if BACKGROUND_SAMPLING || ECG_HW_CLOCK || RR_INTERVALS_IN_ID
+#error "ENERGY_POLICY can't share the ADC10 with the streaming modes"
+#endif
+
+#define ENERGY_OF(counts)         (((counts) >> 2) * ((counts) >> 2))
+#define ENERGY_FLOOR              ENERGY_OF(VCAP_COUNTS(ENERGY_VCAP_MIN_MV))
+
+// watchdog intervals (WDT_ADLY_16: 16 ms on the crystal, ~43 ms on the VLO)
+// to rest at most before giving up on a reading
+#define ENERGY_REST_MAX           64
+
+extern unsigned char energy_replies;      // sendToReader() calls since
+                                          // the last measurement
+extern unsigned short energy_reply_cost;  // learned, per reply
+extern unsigned short energy_defers;      // readings put off
+extern unsigned short energy_rests;       // times we stopped listening
+
+// Measure Vcap. Returns the stored energy, in ENERGY_OF() units.
+unsigned short energy_level();
+
+// About to spend cost on a reading. Returns 1 to go ahead (possibly after a
+// rest), 0 to put it off.
+unsigned char energy_allow(unsigned short cost);
+
+// The reading is done: measure what it took and fold it into *cost.
+void energy_spent(unsigned short *cost);
+
+#endif // ENERGY_POLICY
+
+#endif // ENERGY_H
@@ -0,0 +1,44 @@
+/* See license.txt for license information. */
+#include "mywisp.h"
+#if HEALTH_PERIOD
+
+#include "dlwisp41.h"
+#include "rfid.h"
+#include "health_sensor.h"
+
+unsigned char health_reset_cause = 0;   // set in main()
+unsigned short health_sleeps = 0;       // counted in sleep()
+unsigned short health_wakes = 0;        // counted in Port2_ISR()
+unsigned short health_timeouts = 0;     // counted in main()
+
+static unsigned char health_next = 0;   // counter the next reading starts at
+
+static unsigned char health_collect(unsigned char volatile *target)
+{
+  unsigned short v = vcap_read();
+  unsigned short c[HEALTH_COUNTERS];
+  unsigned char i;
+
+  c[HEALTH_SLEEPS] = health_sleeps;
+  c[HEALTH_WAKES] = health_wakes;
+  c[HEALTH_TIMEOUTS] = health_timeouts;
+
+  *target++ = health_reset_cause;
+  *target++ = v >> 2;
+  *target++ = health_next | (HEALTH_PER_READING << 4);
+  for ( i = 0; i < HEALTH_PER_READING; i++ )
+  {
+    *target++ = __swap_bytes(c[health_next]);
+    *target++ = c[health_next];
+    if ( ++health_next == HEALTH_COUNTERS )
+      health_next = 0;
+  }
+
+  return 1;
+}
+
+const sensor_driver health_driver = {
+  HEALTH_TYPE_ID, HEALTH_DATA_BYTES, 0, 0, health_collect
+};
+
+#endif // HEALTH_PERIOD
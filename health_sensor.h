@@ -0,0 +1,68 @@
+/* See license.txt for license information. */
+
+#ifndef HEALTH_SENSOR_H
+#define HEALTH_SENSOR_H
+
+/*
+ * Tag health report (SENSOR_HEALTH). Goes out as a sensor payload of its own,
+ * every SENSOR_HEALTH_EVERY slots, so the reader can tell a tag that is
+ * starving for power from one that is losing the link:
+ *
+ *   byte 0     cause of the last reset (HEALTH_RESET_x)
+ *   byte 1     Vcap, top 8 bits of the VSENSE reading (full scale is
+ *              VSENSE_FULL_SCALE_MV)
+ *   byte 2     number of the first counter below, and HEALTH_PER_READING
+ *              in the top four bits; the next reading carries the ones
+ *              after it
+ *   bytes 3-   HEALTH_PER_READING counters, MSB first: one in the EPC,
+ *              all three in a Read
+ *
+ * The counters, in turn:
+ *
+ *   HEALTH_SLEEPS    times sleep() waited for power-good
+ *   HEALTH_WAKES     Port2_ISR wakeups (power-good again)
+ *   HEALTH_TIMEOUTS  main-loop timeouts, the ones the sample slots of 2(j)
+ *                    count. The one clock the tag has in every
+ *                    configuration: they come as often as the reader keeps
+ *                    us busy (and with every sample clock or scheduler
+ *                    wakeup, where there is one), and not at all with no
+ *                    reader about.
+ *
+ * They survive a fast resume and start over on a cold start. The timeouts
+ * wrap at 2^16, so a report should get through well before that many.
+ * host/wisp_health.c decodes it.
+ */
+
+#define HEALTH_TYPE_ID            0x13
+
+#define HEALTH_SLEEPS             0
+#define HEALTH_WAKES              1
+#define HEALTH_TIMEOUTS           2
+#define HEALTH_COUNTERS           3
+
+#if DATA_IN_EPC
+#define HEALTH_PER_READING        1
+#else
+#define HEALTH_PER_READING        HEALTH_COUNTERS
+#endif
+#define HEALTH_DATA_BYTES         (3 + 2*HEALTH_PER_READING)
+
+// the IFG1 flags, plus one of our own
+#define HEALTH_RESET_WDT          0x01  // watchdog or its password (WDTIFG)
+#define HEALTH_RESET_POR          0x04  // power-on or brownout (PORIFG)
+#define HEALTH_RESET_PIN          0x08  // RST pin (RSTIFG)
+#define HEALTH_RESET_NMI          0x10  // (NMIIFG)
+#define HEALTH_RESET_RESUMED      0x80  // RAM survived it (fast resume)
+
+extern unsigned char health_reset_cause;
+extern unsigned short health_sleeps;
+extern unsigned short health_wakes;
+extern unsigned short health_timeouts;
+
+extern const sensor_driver health_driver;
+
+#if (ACTIVE_SENSOR == SENSOR_HEALTH)
+#define SENSOR_DATA_TYPE_ID       HEALTH_TYPE_ID
+#endif
+
+#endif // HEALTH_SENSOR_H
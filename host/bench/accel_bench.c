@@ -0,0 +1,451 @@
+/* See license.txt for license information. */
+
+/*
+ * Noise, settling error and energy per reading, accel, quick accel and
+ * oversampled accel, with their own collect() code run against a model of
+ * the ADC10 and DTC, the watchdog interval timer and the accelerometer's
+ * outputs.
+ *
+ * ADC10 (host_sleep()): converts the channel in INCH and each one below it,
+ * once (CONSEQ_1) or over and over (CONSEQ_3) until it's turned off. Each
+ * conversion takes the ADC10SHTx sample-and-hold plus 13 clocks of ADC10OSC
+ * / (ADC10DIVx + 1). The DTC stores into one block, or two in turn with
+ * ADC10TB and ADC10CT, and ADC10_ISR() runs at the end of each. ADC10SA only
+ * holds 16 bits of an address on the host, so the model takes the rest
+ * from its own stack frame: the DTC buffers are the caller's locals.
+ *
+ * Watchdog (host_sleep() with the ADC10 stopped): an interval timer on
+ * SMCLK, running wdt_ISR() every WDTISx clocks. accel_start()'s DCO (RSEL
+ * 8, DCO 7) has no datasheet figure; it's taken as BENCH_WDT_SMCLK_HZ, which
+ * makes accel_collect()'s 46 intervals the "slightly less than 10 ms" its
+ * comment gives.
+ *
+ * Accelerometer (ADXL330, datasheet typicals): ratiometric, so 0.1 of
+ * supply per g is 102.4 counts/g whatever the supply. Each output is an RC
+ * low-pass at bw Hz, set by its filter capacitor, that rises from 0 V at
+ * power-on (start() pulls the pins low first) and carries 280 ug/rtHz (X,
+ * Y) or 350 ug/rtHz (Z) band-limited by the same RC. The ADC adds 0.5 LSB
+ * rms white noise before rounding. The tag is still, at 0 g, 0 g and 1 g.
+ *
+ * Energy, at 2.2 V: the accelerometer's 200 uA from power-on until the last
+ * conversion, the ADC10's 600 uA while converting, and the CPU at 270 uA per
+ * MHz, i.e. 0.27 nC a cycle, for the settle spin (225 turns, ~5 cycles
+ * each), the watchdog and ADC10 interrupts (hand counts of the compiled
+ * handlers), and LPM1 between watchdog interrupts, with the DCO up, at the
+ * datasheet's LPM0 current per MHz. The spin's length depends on the slowed
+ * DCO; ~0.2 MHz is taken. What they share besides (start(), packing the
+ * payload) isn't counted.
+ *
+ * Noise is the rms spread of the reported value over readings and bias its
+ * mean minus the settled output, both in 10-bit counts. The oversampled
+ * sums are also checked against the conversions the model handed out.
+ *
+ * Then the three conversions of a reading, one sequence through the DTC
+ * (adc_seq_read(), as the drivers do it) against one conversion a channel
+ * as the drivers did before adc_seq.c: quick accel polling ADC10BUSY at
+ * RECEIVE_CLOCK, accel sleeping in LPM4 for an interrupt per channel. Those
+ * two are kept here as the reference, on the same ADC10 model. CPU cycles
+ * are the MCLK cycles it's awake while the ADC10 converts plus the
+ * interrupts it takes.
+ *
+ *   accel_bench [readings]
+ */
+
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "msp430_host.h"
+#include "dlwisp41.h"
+#include "mywisp.h"
+#include "sensors.h"
+#include "accel_sensor.h"
+#include "quick_accel_sensor.h"
+#include "oversampled_accel_sensor.h"
+#include "adc_seq.h"
+#include "../wisp_unpack.h"
+#include "trace.h"
+
+#define BENCH_PI                  3.14159265358979323846
+
+#define BENCH_VCC                 2.2
+#define BENCH_ACCEL_UA            200.0
+#define BENCH_ADC_UA              600.0
+#define BENCH_NC_PER_CYCLE        0.27
+#define BENCH_ADC10OSC_HZ         5.0e6
+#define BENCH_SPIN_CYCLES         (225 * 5)
+#define BENCH_SPIN_HZ             0.2e6
+#define BENCH_RECEIVE_HZ          3.0e6
+#define BENCH_ISR_CYCLES          30    // one block, wakes the CPU
+#define BENCH_SUM_ISR_CYCLES      130   // adc_seq_sum() block, 6 words
+#define BENCH_WAKE_ISR_CYCLES     15    // accept, LPMx_EXIT, reti
+#define BENCH_WDT_SMCLK_HZ        2.4e6
+#define BENCH_LPM1_UA_PER_MHZ     56.0
+
+#define BENCH_COUNTS_PER_G        102.4
+#define BENCH_ADC_NOISE           0.5
+#define BENCH_MAX_CONVERSIONS     256
+
+void ADC10_ISR(void);
+void wdt_ISR(void);
+
+// the accelerometer outputs, as channels A0 (Z) to A2 (X)
+static const double accel_g[3] = { 1.0, 0.0, 0.0 };
+static const double accel_ug_rthz[3] = { 350.0, 280.0, 280.0 };
+
+static unsigned long long seed = 1;
+static double bw;                 // output filter corner, Hz
+static double now;                // us since power-on
+static double noise_t[3], noise[3];
+
+// the ADC10 and DTC
+static int adc_running;
+static unsigned adc_ch, adc_word, adc_block;
+static unsigned short *adc_dest;
+static double adc_us;
+static unsigned adc_isrs, adc_sum_isrs;
+static unsigned short conversions[BENCH_MAX_CONVERSIONS];
+static unsigned n_conversions;
+
+// the watchdog
+static unsigned wdt_isrs;
+static double lpm1_us;
+
+// Noise on channel ch at the time now: a first-order low-pass of white
+// noise, stepped exactly from the last time it was looked at.
+static double accel_noise(unsigned ch)
+{
+  double tau = 1e6 / (2 * BENCH_PI * bw);
+  double sigma = accel_ug_rthz[ch] * 1e-6 * sqrt(BENCH_PI / 2 * bw) *
+                 BENCH_COUNTS_PER_G;
+  double k = exp(-(now - noise_t[ch]) / tau);
+
+  noise[ch] = noise[ch] * k +
+              trace_noise(&seed, sigma * sqrt(1 - k * k));
+  noise_t[ch] = now;
+  return noise[ch];
+}
+
+static double accel_settled(unsigned ch)
+{
+  return TRACE_MID + accel_g[ch] * BENCH_COUNTS_PER_G;
+}
+
+static double accel_out(unsigned ch)
+{
+  double tau = 1e6 / (2 * BENCH_PI * bw);
+
+  return accel_settled(ch) * (1 - exp(-now / tau)) + accel_noise(ch);
+}
+
+// Power-on: outputs at 0 V, noise from its steady state.
+static void accel_power_on(void)
+{
+  double tau = 1e6 / (2 * BENCH_PI * bw);
+
+  now = 0;
+  for ( unsigned ch = 0; ch < 3; ch++ )
+  {
+    noise[ch] = 0;
+    noise_t[ch] = -100 * tau;
+    accel_noise(ch);
+  }
+  adc_us = 0;
+  adc_isrs = adc_sum_isrs = 0;
+  n_conversions = 0;
+  wdt_isrs = 0;
+  lpm1_us = 0;
+}
+
+// The buffer ADC10SA points into: the low 16 bits are the register, the
+// rest the nearest 64K window at or above this frame.
+static unsigned short *adc_map(void)
+{
+  unsigned short here;
+  uintptr_t base = (uintptr_t)&here;
+  uintptr_t p = (base & ~(uintptr_t)0xFFFF) | ADC10SA;
+
+  if ( p < base )
+    p += 0x10000;
+  return (unsigned short *)p;
+}
+
+static double adc_conversion_us(void)
+{
+  static const unsigned sht[4] = { 4, 8, 16, 64 };
+  unsigned div = ( ( ADC10CTL1 >> 5 ) & 7 ) + 1;
+
+  return ( sht[( ADC10CTL0 >> 11 ) & 3] + 13 ) * div * 1e6 /
+         BENCH_ADC10OSC_HZ;
+}
+
+// One conversion of the channel in INCH, as ADC10MEM would get it.
+static unsigned short adc_convert(unsigned ch)
+{
+  double us = adc_conversion_us();
+  unsigned short v;
+
+  now += us;
+  adc_us += us;
+  v = trace_adc(accel_out(ch) + trace_noise(&seed, BENCH_ADC_NOISE));
+  if ( n_conversions < BENCH_MAX_CONVERSIONS )
+    conversions[n_conversions++] = v;
+  return v;
+}
+
+// Convert until the end of a DTC block, then run the interrupt.
+static void adc_sleep(void)
+{
+  unsigned words = ADC10DTC1;
+  unsigned top = ADC10CTL1 >> 12;
+
+  if ( !( ADC10CTL0 & ADC10ON ) || !( ADC10CTL0 & ENC ) || !words )
+    host_fail("asleep with the ADC10 stopped");
+  if ( !adc_running )
+  {
+    adc_running = 1;
+    adc_ch = top;
+    adc_word = adc_block = 0;
+    adc_dest = adc_map();
+  }
+
+  do
+  {
+    adc_dest[adc_block * words + adc_word++] = adc_convert(adc_ch);
+    if ( adc_ch-- == 0 )
+    {
+      if ( ( ADC10CTL1 & CONSEQ_3 ) != CONSEQ_3 && adc_word < words )
+        host_fail("sequence ended before the DTC block");
+      adc_ch = top;
+    }
+  } while ( adc_word < words );
+
+  adc_word = 0;
+  if ( ( ADC10DTC0 & ( ADC10TB + ADC10CT ) ) == ADC10TB + ADC10CT )
+    adc_block ^= 1;
+  else if ( ADC10DTC0 )
+    host_fail("DTC mode %02x not modelled", ADC10DTC0);
+  if ( !( ADC10CTL0 & ADC10IE ) || !( host_sr & GIE ) )
+    host_fail("end of block with the interrupt off");
+
+  if ( ADC10DTC0 & ADC10CT )
+    adc_sum_isrs++;
+  else
+    adc_isrs++;
+  ADC10_ISR();
+  if ( !( ADC10CTL0 & ADC10ON ) )
+    adc_running = 0;
+}
+
+// Up to the next watchdog interval, then its interrupt.
+static void wdt_sleep(void)
+{
+  static const unsigned clocks[4] = { 32768, 8192, 512, 64 };
+
+  if ( ( WDTCTL & ( WDTHOLD | WDTTMSEL | WDTSSEL ) ) != WDTTMSEL )
+    host_fail("watchdog mode %04x not modelled", WDTCTL);
+  if ( !( host_sr & GIE ) || ( host_sr & LPM4_bits ) != LPM1_bits )
+    host_fail("waiting on the watchdog in mode %04x", host_sr);
+
+  now += clocks[WDTCTL & 3] * 1e6 / BENCH_WDT_SMCLK_HZ;
+  lpm1_us += clocks[WDTCTL & 3] * 1e6 / BENCH_WDT_SMCLK_HZ;
+  wdt_isrs++;
+  wdt_ISR();
+}
+
+static void bench_sleep(void)
+{
+  if ( ADC10CTL0 & ENC )
+    adc_sleep();
+  else if ( IE1 & WDTIE )
+    wdt_sleep();
+  else
+    host_fail("asleep with nothing to wake it");
+}
+
+typedef struct {
+  double sum[3], sum2[3];
+  double energy[3];               // accelerometer, ADC10, CPU, in uJ
+  double us, isrs;
+  unsigned n;
+} result;
+
+static double result_mean(const result *r, unsigned ch)
+{
+  return r->sum[ch] / r->n;
+}
+
+static double result_rms(const result *r, unsigned ch)
+{
+  double m = result_mean(r, ch);
+
+  return sqrt(r->sum2[ch] / r->n - m * m);
+}
+
+// One reading from d, into r. spin is whether it spins for its settle time
+// (the watchdog's are counted as they come).
+static void reading(const sensor_driver *d, unsigned char spin, result *r)
+{
+  unsigned char payload[8];
+  unsigned short w[3];
+  double v[3];
+  unsigned cycles;
+
+  accel_power_on();
+  d->start();
+  if ( spin )
+    now = BENCH_SPIN_CYCLES * 1e6 / BENCH_SPIN_HZ;
+  if ( !d->collect(payload) )
+    host_fail("no reading");
+  if ( !wisp_unpack(payload, d->bytes, d == &oversampled_accel_driver ?
+                    OVERSAMPLE_BITS : PACKED_SAMPLES * PACKED_SAMPLE_BITS,
+                    w, 3) )
+    host_fail("payload doesn't unpack");
+
+  for ( unsigned a = 0; a < 3; a++ )
+  {
+    if ( d == &oversampled_accel_driver )
+    {
+      // the model's conversions, after the dropped block: X, Y, Z, X, ...
+      unsigned long s = 0;
+
+      for ( unsigned i = 0; i < OVERSAMPLE_COUNT; i++ )
+        s += conversions[( ADC_SEQ_SUM_PASSES + i ) * 3 + a];
+      if ( w[a] != s >> ( OVERSAMPLE_LOG2 - OVERSAMPLE_LOG2 / 2 ) )
+        host_fail("axis %u: reported %u, conversions add up to %lu", a,
+                  w[a], s);
+      v[a] = w[a] / (double)( 1 << ( OVERSAMPLE_LOG2 / 2 ) );
+    }
+    else
+      v[a] = w[a];
+  }
+
+  for ( unsigned a = 0; a < 3; a++ )
+  {
+    double e = v[a] - accel_settled(2 - a);
+
+    r->sum[a] += e;
+    r->sum2[a] += e * e;
+  }
+  cycles = ( spin ? BENCH_SPIN_CYCLES : 0 ) + adc_isrs * BENCH_ISR_CYCLES +
+           adc_sum_isrs * BENCH_SUM_ISR_CYCLES +
+           wdt_isrs * BENCH_WAKE_ISR_CYCLES;
+  r->energy[0] += BENCH_VCC * BENCH_ACCEL_UA * now * 1e-6;
+  r->energy[1] += BENCH_VCC * BENCH_ADC_UA * adc_us * 1e-6;
+  r->energy[2] += BENCH_VCC * ( BENCH_NC_PER_CYCLE * cycles * 1e-3 +
+                                BENCH_LPM1_UA_PER_MHZ * BENCH_WDT_SMCLK_HZ *
+                                1e-6 * lpm1_us * 1e-6 );
+  r->us += now;
+  r->isrs += adc_isrs + adc_sum_isrs + wdt_isrs;
+  r->n++;
+}
+
+static void report(const char *name, const result *r)
+{
+  printf("  %-12s noise X %.2f Y %.2f Z %.2f  bias X %+6.2f Z %+6.2f  "
+         "%5.2f ms %4.1f isr  %.2f+%.2f+%.2f = %.2f uJ\n", name,
+         result_rms(r, 0), result_rms(r, 1), result_rms(r, 2),
+         result_mean(r, 0), result_mean(r, 2), r->us / r->n / 1000,
+         r->isrs / r->n, r->energy[0] / r->n, r->energy[1] / r->n,
+         r->energy[2] / r->n,
+         ( r->energy[0] + r->energy[1] + r->energy[2] ) / r->n);
+}
+
+// One conversion a channel, in the order given, as before adc_seq.c:
+// polling ADC10BUSY with MCLK at RECEIVE_CLOCK, or asleep in LPM4 until an
+// interrupt that only wakes the CPU.
+static void per_channel(const char *name, unsigned short ctl0,
+                        unsigned short ctl1, const unsigned short *inch,
+                        unsigned char polled)
+{
+  double cycles = 0;
+  unsigned isrs = 0;
+
+  accel_power_on();
+  for ( unsigned i = 0; i < 3; i++ )
+  {
+    ADC10CTL0 &= ~ENC;
+    ADC10CTL0 = ctl0 + ADC10ON + ( polled ? 0 : ADC10IE );
+    ADC10CTL1 = ctl1 + CONSEQ_0 + inch[i];
+    ADC10CTL0 |= ENC + ADC10SC;
+    ADC10MEM = adc_convert(inch[i] >> 12);
+    if ( polled )
+      cycles += adc_conversion_us() * 1e-6 * BENCH_RECEIVE_HZ;
+    else
+      isrs++;
+  }
+  ADC10CTL0 = 0;
+  ADC10CTL1 = 0;
+
+  cycles += isrs * BENCH_WAKE_ISR_CYCLES;
+  printf("  %-34s %6.1f us  %5.0f cycles  %u isr  %.3f uJ\n", name, adc_us,
+         cycles, isrs, BENCH_VCC * BENCH_NC_PER_CYCLE * cycles * 1e-3);
+}
+
+// The same three through adc_seq_read(), asleep until its interrupt.
+static void sequence(const char *name, unsigned short ctl0,
+                     unsigned short ctl1)
+{
+  unsigned short s[3];
+  double cycles;
+
+  accel_power_on();
+  adc_seq_read(s, 3, ctl0, ctl1 + INCH_ACCEL_X);
+  if ( n_conversions != 3 )
+    host_fail("%u conversions in a sequence of 3", n_conversions);
+  cycles = adc_isrs * BENCH_ISR_CYCLES;
+  printf("  %-34s %6.1f us  %5.0f cycles  %u isr  %.3f uJ\n", name, adc_us,
+         cycles, adc_isrs, BENCH_VCC * BENCH_NC_PER_CYCLE * cycles * 1e-3);
+}
+
+int main(int argc, char **argv)
+{
+  static const double bws[] = { 50, 160, 500 };  // 0.1, 0.033, 0.01 uF
+  static const result zero;
+  unsigned n = ( argc > 1 ) ? (unsigned)atoi(argv[1]) : 4000;
+
+  host_sleep = bench_sleep;
+  printf("accel_bench: %u readings each, settle spin %.1f ms, "
+         "%u + %u passes oversampled\n", n,
+         BENCH_SPIN_CYCLES * 1e3 / BENCH_SPIN_HZ, ADC_SEQ_SUM_PASSES,
+         OVERSAMPLE_COUNT);
+  printf("  sum interrupt %.0f us of the %.0f us a block takes\n",
+         BENCH_SUM_ISR_CYCLES * 1e6 / BENCH_RECEIVE_HZ,
+         ADC_SEQ_SUM_PASSES * 3 * ( 8 + 13 ) * 3 * 1e6 / BENCH_ADC10OSC_HZ);
+  printf("  noise rms and bias in counts; energy accel+adc+cpu\n");
+
+  for ( unsigned b = 0; b < sizeof bws / sizeof bws[0]; b++ )
+  {
+    result accel = zero, quick = zero, over = zero;
+
+    bw = bws[b];
+    printf(" output filter %.0f Hz\n", bw);
+    for ( unsigned i = 0; i < n; i++ )
+    {
+      reading(&accel_driver, 0, &accel);
+      reading(&quick_accel_driver, 1, &quick);
+      reading(&oversampled_accel_driver, 1, &over);
+    }
+    report("accel", &accel);
+    report("quick", &quick);
+    report("oversampled", &over);
+  }
+
+  {
+    static const unsigned short xyz[3] =
+      { INCH_ACCEL_X, INCH_ACCEL_Y, INCH_ACCEL_Z };
+    static const unsigned short zyx[3] =
+      { INCH_ACCEL_Z, INCH_ACCEL_Y, INCH_ACCEL_X };
+
+    printf(" three conversions, CPU cycles and energy while converting\n");
+    per_channel("quick, a channel at a time, polled", SREF_0 + ADC10SHT_1,
+                ADC10DIV_2 + ADC10SSEL_0 + SHS_0, xyz, 1);
+    sequence("quick, one DTC sequence", SREF_0 + ADC10SHT_1,
+             ADC10DIV_2 + ADC10SSEL_0 + SHS_0);
+    per_channel("accel, a channel at a time, LPM4", SREF_0 + ADC10SHT_3,
+                ADC10DIV_4 + ADC10SSEL_0 + SHS_0, zyx, 0);
+    sequence("accel, one DTC sequence", SREF_0 + ADC10SHT_3,
+             ADC10DIV_4 + ADC10SSEL_0 + SHS_0);
+  }
+  return 0;
+}
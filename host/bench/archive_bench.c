@@ -0,0 +1,265 @@
+/* See license.txt for license information. */
+
+/*
+ * The sample archive (archive.c, over eeprom.c and i2c.c) against the
+ * 24xx08 model in eeprom24.h.
+ *
+ * Throughput and endurance: records appended back to back, each one
+ * waiting out the write cycle before it, and then one a second. Bus time
+ * and write cycles per record, how evenly the pages wear, and how long the
+ * chip lasts at the datasheet's 1M cycles a page.
+ *
+ * Recovery: records appended over the whole record-number range, twice
+ * round ARCHIVE_SEQ_MOD, with a cold start (init_eeprom(), archive_init())
+ * after every one. One write in BENCH_TEAR_EVERY is torn by the power
+ * loss: its page keeps a random number of the new bytes, the rest of the
+ * old ones, and may have a half-programmed byte where they meet. After
+ * each recovery the head (archive_next) and the number of records held
+ * (archive_count) have to be what was really left on the chip, and every
+ * so often all the records held are read back, compared, and decoded again
+ * as the reader would (host/wisp_archive.c).
+ *
+ * A torn record that happens to pass its CRC can't be told from a good one;
+ * those are counted, not failed.
+ *
+ *   archive_bench
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "msp430_host.h"
+#include "dlwisp41.h"
+#include "mywisp.h"
+#include "archive.h"
+#include "eeprom24.h"
+#include "../wisp_archive.h"
+
+#define BENCH_SMCLK_HZ            1.2e6   // i2c_init()'s ~100 kHz SCL
+#define BENCH_THROUGHPUT_RECORDS  (16 * ARCHIVE_SLOTS)
+#define BENCH_LAPS                2
+#define BENCH_TEAR_EVERY          8
+#define BENCH_CHECK_EVERY         97
+#define BENCH_CYCLES_PER_PAGE     1.0e6
+
+#define BENCH_NONE                0xFFFFFFFFul
+
+static unsigned long long seed = 1;
+
+static unsigned bench_rand(unsigned n)
+{
+  seed = seed * 6364136223846793005ull + 1442695040888963407ull;
+  return (unsigned)( ( seed >> 33 ) % n );
+}
+
+// what record seq carries
+static void payload_for(unsigned short seq, unsigned char *p)
+{
+  for ( unsigned i = 0; i < ARCHIVE_DATA_BYTES; i++ )
+    p[i] = (unsigned char)( seq * 31 + i * 7 + ( seq >> 8 ) );
+}
+
+static void put(void)
+{
+  unsigned char p[ARCHIVE_DATA_BYTES];
+
+  payload_for(archive_next, p);
+  if ( !archive_put(p, ARCHIVE_DATA_BYTES) )
+    host_fail("archive_put() lost a page");
+}
+
+static void throughput(void)
+{
+  unsigned long min = ~0ul, max = 0, writes = 0;
+  double us, bus_us;
+  unsigned long long scl;
+
+  eeprom24_init(BENCH_SMCLK_HZ);
+  init_eeprom();
+  archive_init();
+
+  us = eeprom24_us;
+  for ( unsigned i = 0; i < BENCH_THROUGHPUT_RECORDS; i++ )
+    put();
+  eeprom_append_flush();
+  us = ( eeprom24_us - us ) / BENCH_THROUGHPUT_RECORDS;
+
+  // one a second: the write cycle is long over by the next one
+  bus_us = eeprom24_us;
+  scl = eeprom24_scl;
+  for ( unsigned i = 0; i < BENCH_THROUGHPUT_RECORDS; i++ )
+  {
+    eeprom24_idle(1e6);
+    put();
+    eeprom_append_flush();
+  }
+  bus_us = ( eeprom24_us - bus_us ) / BENCH_THROUGHPUT_RECORDS - 1e6;
+  scl = ( eeprom24_scl - scl ) / BENCH_THROUGHPUT_RECORDS;
+
+  for ( unsigned i = 0; i < EEPROM24_PAGES; i++ )
+  {
+    writes += eeprom24_page_writes[i];
+    if ( eeprom24_page_writes[i] < min )
+      min = eeprom24_page_writes[i];
+    if ( eeprom24_page_writes[i] > max )
+      max = eeprom24_page_writes[i];
+  }
+
+  printf("  back to back       %.2f ms a record, %.0f records/s\n",
+         us / 1000, 1e6 / us);
+  printf("  one a second       %.2f ms of bus a record (%llu SCL, "
+         "%llu cycles)\n", bus_us / 1000, scl, scl * UCB0BR0);
+  printf("  wear               %.2f write cycles a record, pages %lu to %lu\n",
+         (double)writes / ( 2 * BENCH_THROUGHPUT_RECORDS ), min, max);
+  printf("  endurance          %.0fM records, %.1f years at 1/s\n",
+         BENCH_CYCLES_PER_PAGE * EEPROM24_PAGES / 1e6,
+         BENCH_CYCLES_PER_PAGE * EEPROM24_PAGES / ( 365.25 * 86400 ));
+}
+
+// Read back everything archive_count says is held.
+static void check_records(const unsigned long *bad)
+{
+  unsigned char r[ARCHIVE_RECORD_BYTES], p[ARCHIVE_DATA_BYTES];
+  wisp_archive_record w;
+
+  for ( unsigned k = 0; k < archive_count; k++ )
+  {
+    unsigned back = archive_count - k;
+    unsigned short seq = ( archive_next >= back ) ?
+                         archive_next - back :
+                         archive_next + ARCHIVE_SEQ_MOD - back;
+
+    if ( !archive_get(k, r) )
+      host_fail("record %u of %u (%u) doesn't read back", k, archive_count,
+                seq);
+    payload_for(seq, p);
+    if ( bad[seq % ARCHIVE_SLOTS] != seq &&
+         memcmp(r + 4, p, ARCHIVE_DATA_BYTES) )
+      host_fail("record %u (%u) has the wrong payload", k, seq);
+    if ( wisp_archive_record_decode(r, seq % ARCHIVE_SLOTS, &w) ||
+         w.number != seq || w.payload != r + 4 )
+      host_fail("record %u (%u) doesn't decode on the reader", k, seq);
+  }
+}
+
+// Records numbered back from next that the chip still holds.
+static unsigned held_back(const unsigned long *good, unsigned short next)
+{
+  unsigned k;
+
+  for ( k = 0; k < ARCHIVE_SLOTS; k++ )
+  {
+    unsigned short seq = ( next > k ) ? next - k - 1 :
+                         next + ARCHIVE_SEQ_MOD - k - 1;
+
+    if ( good[seq % ARCHIVE_SLOTS] != seq )
+      break;
+  }
+  return k;
+}
+
+static void recovery(void)
+{
+  unsigned long total = (unsigned long)BENCH_LAPS * ARCHIVE_SEQ_MOD +
+                        3 * ARCHIVE_SLOTS;
+  unsigned long good[ARCHIVE_SLOTS], bad[ARCHIVE_SLOTS];
+  unsigned long last_seq[ARCHIVE_SLOTS];
+  unsigned char last[ARCHIVE_SLOTS][ARCHIVE_RECORD_BYTES];
+  unsigned long tears = 0, lost = 0, undetected = 0;
+  double us, us_sum = 0, us_max = 0;
+  unsigned long long scl, scl_max = 0;
+
+  // good[slot]: the record number the slot holds intact, if any. last[]
+  // and last_seq[]: the last record that was, which a tear can leave.
+  for ( unsigned i = 0; i < ARCHIVE_SLOTS; i++ )
+    good[i] = bad[i] = last_seq[i] = BENCH_NONE;
+
+  eeprom24_init(BENCH_SMCLK_HZ);
+  init_eeprom();
+  archive_init();
+
+  for ( unsigned long n = 0; n < total; n++ )
+  {
+    unsigned short seq = archive_next;
+    unsigned short next;
+    unsigned slot = seq % ARCHIVE_SLOTS;
+    unsigned char *page = &eeprom24_mem[slot * ARCHIVE_RECORD_BYTES];
+    unsigned char now[ARCHIVE_RECORD_BYTES];
+    unsigned held;
+
+    put();
+    eeprom_append_flush();
+    memcpy(now, page, ARCHIVE_RECORD_BYTES);
+    bad[slot] = BENCH_NONE;
+
+    if ( bench_rand(BENCH_TEAR_EVERY) == 0 )
+    {
+      unsigned keep = bench_rand(ARCHIVE_RECORD_BYTES + 1);
+
+      tears++;
+      eeprom24_tear(keep, bench_rand(2));
+    }
+    else
+      eeprom24_idle(EEPROM24_WRITE_US);
+
+    // what's on the chip now: the new record, what was there, or neither
+    if ( memcmp(page, now, ARCHIVE_RECORD_BYTES) == 0 )
+    {
+      good[slot] = last_seq[slot] = seq;
+      memcpy(last[slot], now, ARCHIVE_RECORD_BYTES);
+    }
+    else
+    {
+      lost++;
+      good[slot] = ( memcmp(page, last[slot], ARCHIVE_RECORD_BYTES) == 0 ) ?
+                   last_seq[slot] : BENCH_NONE;
+    }
+
+    us = eeprom24_us;
+    scl = eeprom24_scl;
+    init_eeprom();
+    archive_init();
+    us = eeprom24_us - us;
+    scl = eeprom24_scl - scl;
+    us_sum += us;
+    if ( us > us_max )
+      us_max = us;
+    if ( scl > scl_max )
+      scl_max = scl;
+
+    if ( good[slot] != seq &&
+         archive_next == ( seq + 1 ) % ARCHIVE_SEQ_MOD )
+    {
+      // the torn record passed its CRC
+      undetected++;
+      lost--;
+      good[slot] = bad[slot] = last_seq[slot] = seq;
+      memcpy(last[slot], page, ARCHIVE_RECORD_BYTES);
+    }
+    next = ( good[slot] == seq ) ? ( seq + 1 ) % ARCHIVE_SEQ_MOD : seq;
+    held = held_back(good, next);
+    if ( archive_next != next || archive_count != held )
+      host_fail("record %lu (%u): recovered head %u count %u, not %u %u", n,
+                seq, archive_next, archive_count, next, held);
+
+    if ( n % BENCH_CHECK_EVERY == 0 )
+      check_records(bad);
+  }
+
+  printf("  %lu records, %u laps of record numbers, a cold start after "
+         "each\n", total, BENCH_LAPS);
+  printf("  %lu torn: %lu records lost, %lu finished anyway, %lu passed "
+         "the CRC\n", tears, lost, tears - lost - undetected,
+         undetected);
+  printf("  recovery           %.1f ms mean, %.1f ms max (%llu SCL)\n",
+         us_sum / total / 1000, us_max / 1000, scl_max);
+}
+
+int main(void)
+{
+  printf("archive_bench: %u slots of %u bytes, record numbers mod %u, "
+         "SCL = SMCLK / 12\n", ARCHIVE_SLOTS, ARCHIVE_RECORD_BYTES,
+         ARCHIVE_SEQ_MOD);
+  throughput();
+  recovery();
+  return 0;
+}
@@ -0,0 +1,342 @@
+/* See license.txt for license information. */
+
+/*
+ * Checkpoints (checkpoint.c) against the info flash model in infoflash.h,
+ * which checks that only erased words are programmed and that every write
+ * goes in with the controller set up for it.
+ *
+ * Cost: one checkpoint and one segment erase, in MCLK cycles with the CPU
+ * held and in time at BENCH_MCLK_HZ, and the energy: the flash's supply
+ * current (datasheet typical) on top of the CPU's. The C around them, the
+ * record's CRC included, isn't counted.
+ *
+ * Then a long run of wakes and sleeps. Each wake the tag is up for a random
+ * number of seconds (by the scheduler's clock), the link counters move on,
+ * and one wake in BENCH_READING_EVERY it takes a reading (sensor_counter,
+ * payload_seq and a sample index). Then sleep() saves a
+ * checkpoint, and one sleep in BENCH_COLD_EVERY ends in a cold start.
+ *
+ *  - Rate: records written and erases per hour awake, and what they'd be
+ *    without CHECKPOINT_HOLDOFF, counting the saves it held off; how long
+ *    the busiest segment lasts.
+ *  - Power loss: the same again, but one save or erase in BENCH_CUT_EVERY
+ *    has the power fail in the middle of it, a cold start too. After every
+ *    cold start checkpoint_init() has to restore the state saved in the
+ *    newest record that's all there. No checkpoint may be lost with the
+ *    power on.
+ *
+ *   checkpoint_bench
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "msp430_host.h"
+#include "dlwisp41.h"
+#include "mywisp.h"
+#include "rfid.h"
+#include "sensors.h"
+#include "sched.h"
+#include "checkpoint.h"
+#include "infoflash.h"
+
+#define BENCH_MCLK_HZ             3.0e6
+#define BENCH_VCC                 2.2
+#define BENCH_NC_PER_CYCLE        0.27
+#define BENCH_FLASH_UA            1000.0  // I_PGM and I_ERASE, typical
+#define BENCH_ERASES_MIN          1.0e4   // a segment's endurance
+#define BENCH_ERASES_TYP          1.0e5
+
+#define BENCH_WAKES               200000
+#define BENCH_AWAKE_MAX_S         20
+#define BENCH_READING_EVERY       4
+#define BENCH_COLD_EVERY          3
+#define BENCH_CUT_EVERY           5
+
+#define BENCH_RECORDS             (CHECKPOINT_SEGMENTS * CHECKPOINT_PER_SEGMENT)
+
+// what the tag code around checkpoint.c would hold
+unsigned int read_counter;
+unsigned int sensor_counter;
+unsigned char timeToSample;
+unsigned char payload_seq;
+unsigned short sensor_index[SENSORS_IN_IMAGE];
+volatile unsigned short sched_seconds;
+
+typedef struct {
+  unsigned int read_counter, sensor_counter;
+  unsigned char time_to_sample, payload_seq;
+  unsigned short index[SENSORS_IN_IMAGE];
+} tag_state;
+
+// Each record slot: the save that last wrote it (0 for none), the state it
+// had then, and the words it was to get, whether or not they all took.
+static unsigned long written[BENCH_RECORDS];
+static tag_state saved[BENCH_RECORDS];
+static unsigned short meant[BENCH_RECORDS][CHECKPOINT_WORDS];
+
+// the state in the tag's newest record, as far as it knows
+static tag_state last;
+static unsigned char have_last;
+
+static unsigned long saves, records, held, cold_starts, restored;
+static unsigned long cut_saves, cut_erases;
+static unsigned long long seconds;
+
+// one save or erase in cut_every has the power fail in it; 0 for none
+static unsigned cut_every;
+
+static unsigned long long seed = 1;
+
+static unsigned bench_rand(unsigned n)
+{
+  seed = seed * 6364136223846793005ull + 1442695040888963407ull;
+  return (unsigned)( ( seed >> 33 ) % n );
+}
+
+static void get_state(tag_state *t)
+{
+  memset(t, 0, sizeof *t);
+  t->read_counter = read_counter;
+  t->sensor_counter = sensor_counter;
+  t->time_to_sample = timeToSample;
+#if READ_SENSOR
+  t->payload_seq = payload_seq;
+  memcpy(t->index, sensor_index, sizeof t->index);
+#endif
+}
+
+// RAM as a cold start leaves it
+static void forget(void)
+{
+  read_counter = sensor_counter = 0;
+  timeToSample = payload_seq = 0;
+  memset(sensor_index, 0, sizeof sensor_index);
+}
+
+// first word of record slot r
+static unsigned slot_at(unsigned r)
+{
+  return ( r / CHECKPOINT_PER_SEGMENT ) * INFOFLASH_SEGMENT_WORDS +
+         ( r % CHECKPOINT_PER_SEGMENT ) * CHECKPOINT_WORDS;
+}
+
+static void locked(const char *after)
+{
+  if ( !( FCTL3 & LOCK ) || ( FCTL1 & ( WRT | ERASE ) ) )
+    host_fail("flash left unlocked after %s", after);
+}
+
+static void tidy(unsigned char may_cut)
+{
+  unsigned long erases = infoflash_erases;
+
+  if ( may_cut && cut_every && bench_rand(cut_every) == 0 )
+    infoflash_cut(0, (unsigned short)bench_rand(0x10000));
+  checkpoint_tidy();
+  locked("checkpoint_tidy()");
+  if ( infoflash_was_cut() )
+    cut_erases++;
+  else if ( infoflash_erases - erases > 1 )
+    host_fail("checkpoint_tidy() erased %lu segments",
+              infoflash_erases - erases);
+}
+
+static void boot(void)
+{
+  unsigned long newest = 0;
+  tag_state want, got;
+
+  cold_starts++;
+  infoflash_power_up();
+  forget();
+  memset(&want, 0, sizeof want);
+  checkpoint_init();
+
+  // the newest record that's all there
+  for ( unsigned r = 0; r < BENCH_RECORDS; r++ )
+    if ( written[r] > newest &&
+         memcmp(&infoflash_mem[slot_at(r)], meant[r], sizeof meant[r]) == 0 )
+    {
+      newest = written[r];
+      want = saved[r];
+    }
+  get_state(&got);
+  if ( memcmp(&got, &want, sizeof got) )
+    host_fail("cold start %lu: restored counters %u %u seq %u, not %u %u %u",
+              cold_starts, got.read_counter, got.sensor_counter,
+              got.payload_seq, want.read_counter, want.sensor_counter,
+              want.payload_seq);
+  if ( newest )
+    restored++;
+  last = want;
+  have_last = newest != 0;
+
+  tidy(0);
+}
+
+// Move the state on, as a wake would.
+static void awake(void)
+{
+  unsigned s = 1 + bench_rand(BENCH_AWAKE_MAX_S);
+
+  seconds += s;
+  sched_seconds += s;
+  // 16 bits on the part
+  read_counter = ( read_counter + bench_rand(4 * s) ) & 0xFFFF;
+  timeToSample = (unsigned char)bench_rand(11);
+#if READ_SENSOR
+  if ( bench_rand(BENCH_READING_EVERY) == 0 )
+  {
+    sensor_counter = ( sensor_counter + 1 ) & 0xFFFF;
+    payload_seq++;
+    sensor_index[bench_rand(SENSORS_IN_IMAGE)]++;
+  }
+#endif
+}
+
+static void save(unsigned char may_cut)
+{
+  static unsigned short before[INFOFLASH_WORDS];
+  unsigned short lost = checkpoint_lost;
+  unsigned char wrote = 0;
+  tag_state now;
+
+  get_state(&now);
+  memcpy(before, infoflash_meant, sizeof before);
+  if ( may_cut && cut_every && bench_rand(cut_every) == 0 )
+    infoflash_cut(bench_rand(CHECKPOINT_WORDS), bench_rand(2) ?
+                  (unsigned short)bench_rand(0x10000) : 0);
+  checkpoint_save();
+  locked("checkpoint_save()");
+  saves++;
+
+  // which slot it went to
+  for ( unsigned r = 0; r < BENCH_RECORDS; r++ )
+  {
+    unsigned w = slot_at(r);
+
+    if ( memcmp(&infoflash_meant[w], &before[w], sizeof meant[r]) == 0 )
+      continue;
+    if ( wrote++ )
+      host_fail("checkpoint_save() wrote two records");
+    written[r] = saves;
+    saved[r] = now;
+    memcpy(meant[r], &infoflash_meant[w], sizeof meant[r]);
+  }
+
+  if ( wrote )
+  {
+    records++;
+    last = now;
+    have_last = 1;
+  }
+  else if ( have_last && memcmp(&now, &last, sizeof now) )
+    held++;
+  if ( infoflash_was_cut() )
+    cut_saves++;
+  else if ( checkpoint_lost != lost )
+    host_fail("save %lu: checkpoint lost with the power on", saves);
+}
+
+static double energy_uj(unsigned long long cycles, double us)
+{
+  return BENCH_VCC * ( cycles * BENCH_NC_PER_CYCLE * 1e-3 +
+                       BENCH_FLASH_UA * us * 1e-6 );
+}
+
+static void cost(void)
+{
+  unsigned long long c;
+  double us;
+
+  infoflash_init(BENCH_MCLK_HZ);
+  boot();
+  awake();
+  c = host_cycles;
+  us = infoflash_word_us;
+  save(0);
+  c = host_cycles - c;
+  us = infoflash_word_us - us;
+  printf("  checkpoint   %2u words  %6llu cycles  %6.2f ms  %6.2f uJ\n",
+         CHECKPOINT_WORDS, c, us / 1000, energy_uj(c, us));
+
+  // on until the segment after fills and has to be erased
+  while ( !infoflash_erases )
+  {
+    awake();
+    save(0);
+    c = host_cycles;
+    us = infoflash_erase_us;
+    tidy(0);
+  }
+  c = host_cycles - c;
+  us = infoflash_erase_us - us;
+  printf("  erase                   %6llu cycles  %6.2f ms  %6.2f uJ, "
+         "%u records a segment\n", c, us / 1000, energy_uj(c, us),
+         CHECKPOINT_PER_SEGMENT);
+}
+
+// BENCH_WAKES wakes, a cold start after one sleep in cold_every
+static void run(unsigned cold_every, unsigned cut)
+{
+  infoflash_init(BENCH_MCLK_HZ);
+  memset(written, 0, sizeof written);
+  saves = records = held = cold_starts = restored = 0;
+  cut_saves = cut_erases = 0;
+  seconds = 0;
+  cut_every = cut;
+  boot();
+
+  for ( unsigned long n = 0; n < BENCH_WAKES; n++ )
+  {
+    awake();
+    save(1);
+    if ( infoflash_was_cut() || bench_rand(cold_every) == 0 )
+      boot();
+    else
+      infoflash_power_up();               // nothing cut after all
+    tidy(1);
+    if ( infoflash_was_cut() )
+      boot();
+    else
+      infoflash_power_up();
+  }
+}
+
+static void rate(void)
+{
+  double hours;
+  unsigned long most = 0;
+
+  run(BENCH_COLD_EVERY, 0);
+  for ( unsigned i = 0; i < INFOFLASH_SEGMENTS; i++ )
+    if ( infoflash_segment_erases[i] > most )
+      most = infoflash_segment_erases[i];
+  hours = seconds / 3600.0;
+  printf("  %lu wakes, %.0f hours awake, a reading every %u\n",
+         (unsigned long)BENCH_WAKES, hours, BENCH_READING_EVERY);
+  printf("  rate         %.0f records and %.1f erases an hour; %.0f and %.1f "
+         "without the holdoff\n", records / hours, infoflash_erases / hours,
+         ( records + held ) / hours,
+         ( records + held ) / hours / CHECKPOINT_PER_SEGMENT);
+  printf("  endurance    busiest segment %.0f to %.0f days awake\n",
+         BENCH_ERASES_MIN * hours / most / 24,
+         BENCH_ERASES_TYP * hours / most / 24);
+}
+
+static void power_loss(void)
+{
+  run(BENCH_COLD_EVERY, BENCH_CUT_EVERY);
+  printf("  power loss   %lu cold starts, %lu in a save and %lu in an erase; "
+         "%lu restored\n", cold_starts, cut_saves, cut_erases, restored);
+}
+
+int main(void)
+{
+  printf("checkpoint_bench: %u-word records, MCLK %.1f MHz, holdoff %u s\n",
+         CHECKPOINT_WORDS, BENCH_MCLK_HZ / 1e6, CHECKPOINT_HOLDOFF);
+  cost();
+  rate();
+  power_loss();
+  return 0;
+}
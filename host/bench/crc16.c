@@ -0,0 +1,16 @@
+/* See license.txt for license information. */
+
+// as in hw41_D41.c
+unsigned short crc16_ccitt(volatile unsigned char *data, unsigned short n)
+{
+  unsigned short crc = 0xFFFF;
+
+  for ( unsigned i = 0; i < n; i++ )
+  {
+    crc ^= data[i] << 8;
+    for ( unsigned j = 0; j < 8; j++ )
+      crc = ( crc & 0x8000 ) ? (unsigned short)( ( crc << 1 ) ^ 0x1021 ) :
+                               (unsigned short)( crc << 1 );
+  }
+  return crc ^ 0xFFFF;
+}
@@ -0,0 +1,180 @@
+/* See license.txt for license information. */
+
+/*
+ * The ECG_FILTER chain (dsp.c) against a double-precision model of the same
+ * filters with exact coefficients, on a minute of the synthetic ECG in
+ * trace.h converted DSP_CIC_R times per sample, as ecg_clock.c does.
+ *
+ *  - numeric error: the fixed-point output minus the model's, both fed the
+ *    same ADC samples. That's truncation plus coefficient rounding.
+ *  - what's left of hum and noise: each path's output minus the model's
+ *    output for the clean signal, with one conversion per sample and with
+ *    the CIC over DSP_CIC_R of them.
+ *
+ * Errors are in ADC counts, from 2 s on (the high-pass settles in ~1 s).
+ * There are no cycle counts: those need the target or a model of the
+ * compiled code, and host time says nothing about either.
+ *
+ *   dsp_bench [seconds]
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "msp430_host.h"
+#include "dlwisp41.h"
+#include "mywisp.h"
+#include "dsp.h"
+#include "ecg_clock.h"
+#include "trace.h"
+
+#define BENCH_PI                  3.14159265358979323846
+#define BENCH_SETTLE_S            2.0
+
+typedef struct {
+  double box1[DSP_CIC_R], box2[DSP_CIC_R];
+  double sum1, sum2;
+  unsigned n;
+  double base;
+  int started;
+  double a, lp1, lp2;
+} model;
+
+static void model_init(model *m, double fs)
+{
+  double w = 2 * BENCH_PI * (DSP_LP_CUTOFF / 10.0) / fs;
+
+  for ( unsigned i = 0; i < DSP_CIC_R; i++ )
+    m->box1[i] = m->box2[i] = 0;
+  m->sum1 = m->sum2 = 0;
+  m->n = 0;
+  m->started = 0;
+  m->a = w / (1 + w);
+  m->lp1 = m->lp2 = 0;
+}
+
+// Order-2 CIC as two boxcars of DSP_CIC_R; 1 with *out every R inputs.
+static int model_cic(model *m, double x, double *out)
+{
+  unsigned k = m->n % DSP_CIC_R;
+
+  m->sum1 += x - m->box1[k];
+  m->box1[k] = x;
+#if DSP_CIC_ORDER == 2
+  m->sum2 += m->sum1 / DSP_CIC_R - m->box2[k];
+  m->box2[k] = m->sum1 / DSP_CIC_R;
+  *out = m->sum2 / DSP_CIC_R;
+#else
+  *out = m->sum1 / DSP_CIC_R;
+#endif
+  return ++m->n % DSP_CIC_R == 0;
+}
+
+// Band-pass, counts in and out
+static double model_bandpass(model *m, double x)
+{
+  if ( !m->started )
+  {
+    m->base = x;
+    m->started = 1;
+  }
+  else
+    m->base += (x - m->base) / (1 << DSP_BASELINE_SHIFT);
+  x -= m->base;
+  m->lp1 += m->a * (x - m->lp1);
+  m->lp2 += m->a * (m->lp1 - m->lp2);
+  return m->lp2;
+}
+
+typedef struct {
+  double sum, max;
+  long n;
+} stat;
+
+static void stat_add(stat *s, double e)
+{
+  s->sum += e * e;
+  if ( fabs(e) > s->max )
+    s->max = fabs(e);
+  s->n++;
+}
+
+static double stat_rms(const stat *s)
+{
+  return s->n ? sqrt(s->sum / s->n) : 0;
+}
+
+int main(int argc, char **argv)
+{
+  double seconds = ( argc > 1 ) ? atof(argv[1]) : 60;
+  double fs = ECG_CLOCK_HZ, fs_in = fs * DSP_CIC_R;
+  long n_in = (long)(seconds * fs_in);
+  unsigned long long seed = 1;
+  dsp_cic cic;
+  dsp_bp bp, bp1;
+  model fixed_in, clean, clean1;
+  stat cic_err = { 0 }, bp_err = { 0 }, left = { 0 }, left1 = { 0 };
+
+  dsp_cic_reset(&cic);
+  dsp_bandpass_reset(&bp);
+  dsp_bandpass_reset(&bp1);
+  model_init(&fixed_in, fs);
+  model_init(&clean, fs);
+  model_init(&clean1, fs);
+
+  for ( long i = 0; i < n_in; i++ )
+  {
+    double t = i / fs_in;
+    double signal = trace_ecg(t) + trace_wander(t);
+    unsigned short x = trace_adc(signal + trace_hum(t) +
+                                 trace_noise(&seed, 1.0));
+    unsigned short y;
+    double m, c, c_out;
+    short q = 0;
+    int settled = t >= BENCH_SETTLE_S;
+
+    int out = dsp_cic_put(&cic, x, &y);
+    if ( out )
+      q = dsp_bandpass(&bp, y);
+
+    model_cic(&fixed_in, x, &m);
+    model_cic(&clean, signal, &c);
+    if ( !out )
+      continue;
+
+    // the model's CIC fed the same samples; the fixed one truncates
+    if ( settled )
+      stat_add(&cic_err, y - floor(m));
+
+    // the same chain in doubles, from the same CIC output
+    double ref = model_bandpass(&fixed_in, y);
+    c_out = model_bandpass(&clean, c);
+    if ( settled )
+    {
+      stat_add(&bp_err, q / 16.0 - ref);
+      stat_add(&left, q / 16.0 - c_out);
+    }
+
+    // one conversion per sample: the last of each R, no CIC
+    short q1 = dsp_bandpass(&bp1, x);
+    double c1 = model_bandpass(&clean1, signal);
+    if ( settled )
+      stat_add(&left1, q1 / 16.0 - c1);
+  }
+
+  printf("dsp_bench: %.0f s of synthetic ECG, %.0f Hz in, %.0f Hz out "
+         "(DSP_CIC_R %d, order %d)\n", seconds, fs_in, fs, DSP_CIC_R,
+         DSP_CIC_ORDER);
+  printf("  low-pass coefficient %d / %d, exact %.5f\n",
+         (int)DSP_LP_COEF(DSP_FS_HZ, DSP_LP_CUTOFF), 1 << DSP_Q,
+         fixed_in.a);
+  printf("  CIC vs exact (floored) average    rms %.3f  max %.3f counts\n",
+         stat_rms(&cic_err), cic_err.max);
+  printf("  band-pass vs double model         rms %.3f  max %.3f counts\n",
+         stat_rms(&bp_err), bp_err.max);
+  printf("  hum and noise left, 1 conversion  rms %.3f counts\n",
+         stat_rms(&left1));
+  printf("  hum and noise left, %d + CIC       rms %.3f counts\n",
+         DSP_CIC_R, stat_rms(&left));
+  return 0;
+}
@@ -0,0 +1,146 @@
+/* See license.txt for license information. */
+
+/*
+ * ECG_COMPRESS round trip: ecg_encode() (ecg_codec.c, built as for the tag)
+ * into a payload, host/wisp_ecg_decode.c back out, on synthetic traces
+ * (trace.h) at 250 Hz and on any recorded ones given.
+ *
+ * Per trace, over batches of ECG_CODEC_MAX_SAMPLES:
+ *  - bytes a whole batch codes into, and that as bits per sample and a
+ *    ratio against 10-bit packed samples
+ *  - samples carried per reply: what ecg_clock_read() fits in the EPC after
+ *    the payload header (EPC_DATA_BYTES) and in a 10-byte Read, against
+ *    samples at two bytes each or packed at 10 bits
+ *  - every decoded sample checked against the source; any mismatch fails
+ *
+ * There are no cycle counts: those need the target or a model of the
+ * compiled code, and host time says nothing about either.
+ *
+ *   ecg_codec_bench [trace file ...]
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "msp430_host.h"
+#include "dlwisp41.h"
+#include "mywisp.h"
+#include "ecg_codec.h"
+#include "../wisp_ecg_decode.h"
+#include "trace.h"
+
+#define BENCH_RATE_HZ             250
+#define BENCH_SECONDS             120
+#define BENCH_MAX_SAMPLES         (BENCH_RATE_HZ * BENCH_SECONDS)
+#define BENCH_BATCH               ECG_CODEC_MAX_SAMPLES
+#define BENCH_EPC_BYTES           EPC_DATA_BYTES
+#define BENCH_READ_BYTES          10
+#define BENCH_BIG                 64
+
+static unsigned short trace[BENCH_MAX_SAMPLES];
+static long mismatches = 0;
+
+// Code one payload of bytes, decode it and check it. Returns samples coded.
+static unsigned char round_trip(const unsigned short *s, unsigned char n,
+                                unsigned char bytes)
+{
+  unsigned char payload[BENCH_BIG];
+  unsigned short back[ECG_CODEC_MAX_SAMPLES];
+  unsigned char coded;
+  int decoded;
+
+  memset(payload, 0, sizeof(payload));
+  coded = ecg_encode(payload, bytes, s, n);
+
+  decoded = wisp_ecg_decode(payload, bytes, back, ECG_CODEC_MAX_SAMPLES);
+  if ( decoded != coded || memcmp(back, s, coded * sizeof(back[0])) )
+    mismatches++;
+  return coded;
+}
+
+// The fewest whole bytes the batch codes into.
+static unsigned char batch_bytes(const unsigned short *s, unsigned char n)
+{
+  unsigned char bytes;
+
+  for ( bytes = 3; bytes < BENCH_BIG; bytes++ )
+    if ( round_trip(s, n, bytes) == n )
+      break;
+  return bytes;
+}
+
+static void run(const char *name, const unsigned short *s, long len)
+{
+  long batches = len / BENCH_BATCH;
+  double bytes = 0, epc = 0, read = 0;
+
+  for ( long b = 0; b < batches; b++ )
+  {
+    const unsigned short *batch = s + b * BENCH_BATCH;
+
+    bytes += batch_bytes(batch, BENCH_BATCH);
+    epc += round_trip(batch, BENCH_BATCH, BENCH_EPC_BYTES);
+    read += round_trip(batch, BENCH_BATCH, BENCH_READ_BYTES);
+  }
+  if ( !batches )
+  {
+    printf("  %-24s too short\n", name);
+    return;
+  }
+  bytes /= batches;
+  printf("  %-24s %6.2f %6.2f %5.2f  %5.2f   %5.2f\n", name, bytes,
+         bytes * 8 / BENCH_BATCH, BENCH_BATCH * 10 / (bytes * 8),
+         epc / batches, read / batches);
+}
+
+static void synthetic(const char *name, double noise, int hum)
+{
+  unsigned long long seed = 1;
+
+  for ( long i = 0; i < BENCH_MAX_SAMPLES; i++ )
+  {
+    double t = (double)i / BENCH_RATE_HZ;
+    double x = trace_ecg(t) + trace_wander(t);
+
+    if ( hum )
+      x += trace_hum(t);
+    if ( noise > 0 )
+      x += trace_noise(&seed, noise);
+    trace[i] = trace_adc(x);
+  }
+  run(name, trace, BENCH_MAX_SAMPLES);
+}
+
+int main(int argc, char **argv)
+{
+  printf("ecg_codec_bench: order %d, batches of %d\n", ECG_CODEC_ORDER,
+         BENCH_BATCH);
+  printf("  %-24s %6s %6s %5s  %5s   %5s\n", "", "bytes", "bits/",
+         "ratio", "per", "per");
+  printf("  %-24s %6s %6s %5s  %5s   %5s\n", "trace", "/batch",
+         "sample", "", "EPC", "Read");
+  printf("  %-24s %6s %6s %5s  %5d   %5d\n", "(2 bytes a sample)", "", "16",
+         "", BENCH_EPC_BYTES / 2, BENCH_READ_BYTES / 2);
+  printf("  %-24s %6s %6s %5s  %5d   %5d\n", "(packed, 10 bits)", "", "10",
+         "1.00", BENCH_EPC_BYTES * 8 / 10, BENCH_READ_BYTES * 8 / 10);
+
+  synthetic("synthetic, clean", 0, 0);
+  synthetic("synthetic, 1 LSB noise", 1.0, 0);
+  synthetic("synthetic, 2 LSB + hum", 2.0, 1);
+
+  for ( int i = 1; i < argc; i++ )
+  {
+    long n = trace_load(argv[i], trace, BENCH_MAX_SAMPLES);
+
+    if ( n < 0 )
+      host_fail("can't read %s", argv[i]);
+    run(argv[i], trace, n);
+  }
+
+  if ( mismatches )
+  {
+    printf("%ld payloads didn't decode to their samples\n", mismatches);
+    return 1;
+  }
+  printf("every payload decoded bit-exact\n");
+  return 0;
+}
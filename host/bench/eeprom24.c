@@ -0,0 +1,215 @@
+/* See license.txt for license information. */
+
+#include "msp430_host.h"
+#include "eeprom24.h"
+
+#define EEPROM24_SLAVE            0x50  // 0x50 to 0x53, one per block
+
+// the USCI's side of the bus
+#define BUS_IDLE                  0
+#define BUS_TX                    1     // address ACKed, master sending
+#define BUS_RX                    2     // address ACKed, master receiving
+
+void i2c_data_ISR(void);
+void i2c_state_ISR(void);
+
+unsigned char eeprom24_mem[EEPROM24_BYTES];
+
+double eeprom24_us;
+unsigned long long eeprom24_scl;
+unsigned long eeprom24_isrs;
+unsigned long eeprom24_nacks;
+unsigned long eeprom24_page_writes[EEPROM24_PAGES];
+
+static double smclk;
+static unsigned char bus;
+static unsigned char tx_full;           // UCB0TXBUF holds a byte to send
+
+// the chip
+static double busy_until;
+static unsigned short pointer;          // address pointer
+static unsigned short got;              // bytes received since the address
+static unsigned char latch[EEPROM24_PAGE_BYTES];
+static unsigned char latched[EEPROM24_PAGE_BYTES];
+static unsigned short last_page;        // programmed last, and what it had
+static unsigned char last_old[EEPROM24_PAGE_BYTES];
+
+static void clocks(unsigned n)
+{
+  unsigned br = UCB0BR0 | ( UCB0BR1 << 8 );
+
+  if ( !br )
+    host_fail("I2C with UCB0BR0 at 0");
+  eeprom24_scl += n;
+  eeprom24_us += n * br * 1e6 / smclk;
+  host_cycles += (unsigned long long)n * br;
+}
+
+static void interrupt(void (*isr)(void), unsigned char enabled)
+{
+  if ( !enabled || !( host_sr & GIE ) )
+    host_fail("USCI flag raised with its interrupt off: stuck");
+  eeprom24_isrs++;
+  isr();
+}
+
+// Program what the page latch holds.
+static void program(void)
+{
+  unsigned short page = pointer & ~( EEPROM24_PAGE_BYTES - 1 );
+  unsigned char any = 0;
+
+  last_page = page;
+  for ( unsigned i = 0; i < EEPROM24_PAGE_BYTES; i++ )
+    last_old[i] = eeprom24_mem[page + i];
+  for ( unsigned i = 0; i < EEPROM24_PAGE_BYTES; i++ )
+    if ( latched[i] )
+    {
+      eeprom24_mem[page + i] = latch[i];
+      latched[i] = 0;
+      any = 1;
+    }
+  if ( any )
+  {
+    eeprom24_page_writes[page / EEPROM24_PAGE_BYTES]++;
+    busy_until = eeprom24_us + EEPROM24_WRITE_US;
+  }
+}
+
+static void stop(void)
+{
+  clocks(1);
+  if ( bus == BUS_TX && got > 1 )
+    program();
+  bus = BUS_IDLE;
+  tx_full = 0;
+  UCB0CTL1 &= ~UCTXSTP;
+}
+
+// After the data handler, in transmit mode.
+static void sent(void)
+{
+  IFG2 &= ~UCB0TXIFG;
+  if ( UCB0CTL1 & UCTXSTP )
+    stop();
+  else if ( !( UCB0CTL1 & UCTXSTT ) )
+    tx_full = 1;
+}
+
+static void address(void)
+{
+  unsigned char slave = (unsigned char)UCB0I2CSA;
+
+  clocks(10);                           // (repeated) START, 8 bits, ACK
+  UCB0CTL1 &= ~UCTXSTT;
+  if ( ( slave & ~3 ) != EEPROM24_SLAVE || eeprom24_us < busy_until )
+  {
+    eeprom24_nacks++;
+    bus = BUS_IDLE;
+    UCB0STAT |= UCNACKIFG;
+    interrupt(i2c_state_ISR, UCB0I2CIE & UCNACKIE);
+    if ( UCB0CTL1 & UCTXSTP )
+      stop();
+    return;
+  }
+
+  if ( UCB0CTL1 & UCTR )
+  {
+    bus = BUS_TX;
+    got = 0;
+    pointer = ( pointer & 0xFF ) | ( ( slave & 3 ) << 8 );
+    IFG2 |= UCB0TXIFG;
+    interrupt(i2c_data_ISR, IE2 & UCB0TXIE);
+    sent();
+  }
+  else
+    bus = BUS_RX;
+}
+
+static void byte_out(void)
+{
+  unsigned char b = UCB0TXBUF;
+
+  clocks(9);
+  tx_full = 0;
+  if ( got++ == 0 )
+    pointer = ( pointer & 0x300 ) | b;
+  else
+  {
+    unsigned short page = pointer & ~( EEPROM24_PAGE_BYTES - 1 );
+    unsigned i = pointer & ( EEPROM24_PAGE_BYTES - 1 );
+
+    latch[i] = b;
+    latched[i] = 1;
+    pointer = page + ( ( i + 1 ) & ( EEPROM24_PAGE_BYTES - 1 ) );
+  }
+  IFG2 |= UCB0TXIFG;
+  interrupt(i2c_data_ISR, IE2 & UCB0TXIE);
+  sent();
+}
+
+static void byte_in(void)
+{
+  unsigned char last = ( UCB0CTL1 & UCTXSTP ) != 0;
+
+  clocks(9);
+  UCB0RXBUF = eeprom24_mem[pointer];
+  pointer = ( pointer + 1 ) & ( EEPROM24_BYTES - 1 );
+  if ( last )
+    stop();
+  IFG2 |= UCB0RXIFG;
+  interrupt(i2c_data_ISR, IE2 & UCB0RXIE);
+  IFG2 &= ~UCB0RXIFG;
+}
+
+static void step(void)
+{
+  if ( UCB0CTL1 & UCSWRST )
+    host_fail("I2C asleep with the USCI held in reset");
+  if ( UCB0CTL1 & UCTXSTT )
+    address();
+  else if ( bus == BUS_TX && tx_full )
+    byte_out();
+  else if ( bus == BUS_RX )
+    byte_in();
+  else
+    host_fail("asleep with the I2C bus idle");
+}
+
+void eeprom24_init(double smclk_hz)
+{
+  for ( unsigned i = 0; i < EEPROM24_BYTES; i++ )
+    eeprom24_mem[i] = 0xFF;
+  for ( unsigned i = 0; i < EEPROM24_PAGES; i++ )
+    eeprom24_page_writes[i] = 0;
+  for ( unsigned i = 0; i < EEPROM24_PAGE_BYTES; i++ )
+    latched[i] = 0;
+  smclk = smclk_hz;
+  eeprom24_us = 0;
+  eeprom24_scl = 0;
+  eeprom24_isrs = 0;
+  eeprom24_nacks = 0;
+  busy_until = 0;
+  pointer = 0;
+  bus = BUS_IDLE;
+  tx_full = 0;
+  host_sleep = step;
+}
+
+void eeprom24_idle(double us)
+{
+  eeprom24_us += us;
+}
+
+void eeprom24_tear(unsigned keep, unsigned char garbage)
+{
+  for ( unsigned i = keep; i < EEPROM24_PAGE_BYTES; i++ )
+  {
+    unsigned char *b = &eeprom24_mem[last_page + i];
+
+    // some of the bits on their way from the old value to the new
+    *b = ( i == keep && garbage ) ? ( *b ^ last_old[i] ^ 0xA5 ) :
+                                    last_old[i];
+  }
+  busy_until = 0;
+}
@@ -0,0 +1,61 @@
+/* See license.txt for license information. */
+
+#ifndef EEPROM24_H
+#define EEPROM24_H
+
+/*
+ * A 24xx08 on the USCI_B0 I2C master, for the benchmarks that run eeprom.c
+ * and i2c.c: eeprom24_init() makes it host_sleep(), so it runs whenever the
+ * tag code sleeps waiting on the bus.
+ *
+ * Each call moves the bus on by one step and runs the interrupt the USCI
+ * would raise then:
+ *
+ *   START + address  ACK: UCB0TXIFG (transmit) or go on to receive;
+ *                    NACK: UCNACKIFG. The chip NACKs its address while a
+ *                    write cycle is on, for EEPROM24_WRITE_US after the
+ *                    STOP that started it.
+ *   byte out         what the handler left in UCB0TXBUF, then UCB0TXIFG
+ *   byte in          into UCB0RXBUF, then UCB0RXIFG; NACKed and followed by
+ *                    a STOP if UCTXSTP was set while it came in
+ *   STOP             right after the handler sets UCTXSTP, which it clears
+ *
+ * The host can't see a register being read or written, so the handler's
+ * UCB0TXBUF write is taken to be whatever it didn't do instead (set UCTXSTP
+ * or UCTXSTT), and the flags it would clear by reading or writing a buffer
+ * are cleared after it returns.
+ *
+ * The chip: four 256-byte blocks, the block number in the low bits of the
+ * slave address, 16-byte pages. A write latches bytes into the page,
+ * wrapping within it, and programs them at the STOP. Reads go on from the
+ * address pointer, across blocks.
+ *
+ * Time is SCL clocks at SMCLK / UCB0BR0, SMCLK given to eeprom24_init();
+ * host_cycles gets SMCLK cycles for each one.
+ */
+
+#define EEPROM24_BYTES            1024
+#define EEPROM24_PAGE_BYTES       16
+#define EEPROM24_PAGES            (EEPROM24_BYTES / EEPROM24_PAGE_BYTES)
+#define EEPROM24_WRITE_US         5000.0  // t_WC, datasheet maximum
+
+extern unsigned char eeprom24_mem[EEPROM24_BYTES];
+
+extern double eeprom24_us;                      // time since init
+extern unsigned long long eeprom24_scl;         // SCL clocks
+extern unsigned long eeprom24_isrs;             // USCI interrupts
+extern unsigned long eeprom24_nacks;            // addresses NACKed (busy)
+extern unsigned long eeprom24_page_writes[EEPROM24_PAGES];  // write cycles
+
+// A blank (0xFF) chip, bus idle, counts zeroed.
+void eeprom24_init(double smclk_hz);
+
+// The CPU is busy elsewhere for us; a write cycle may finish meanwhile.
+void eeprom24_idle(double us);
+
+// Power fails during the last write cycle. Its page keeps the first keep
+// bytes it was getting and the rest of what it had, but for byte keep,
+// which is left half-programmed (garbage) if garbage is set.
+void eeprom24_tear(unsigned keep, unsigned char garbage);
+
+#endif // EEPROM24_H
@@ -0,0 +1,112 @@
+/* See license.txt for license information. */
+
+/*
+ * read_eeprom() and write_eeprom() (eeprom.c, on the interrupt-driven
+ * engine in i2c.c) against the 24xx08 model in eeprom24.h, all of it
+ * checked byte for byte against what was written:
+ *
+ *  - a 1 kB write, page by page, each page ACK-polling out the last one's
+ *    write cycle
+ *  - a 1 kB read, sequential: one address phase per 256-byte block
+ *  - a 256-byte log read, the same
+ *  - the same 1 kB read a byte at a time, one random read each, as
+ *    read_eeprom() used to go about it (without the 4000-cycle delay it
+ *    had after every byte)
+ *
+ * For each: SCL clocks per byte, SMCLK cycles of bus time per byte (SCL
+ * clocks times UCB0BR0, what the CPU spends asleep in LPM0 waiting), USCI
+ * interrupts per byte, and bytes per second with SMCLK at the 1.2 MHz
+ * i2c_init() assumes, i.e. SCL at ~100 kHz. The time the handlers take
+ * isn't counted; that's ~40 cycles an interrupt by hand.
+ *
+ *   eeprom_bench
+ */
+
+#include <stdio.h>
+#include "msp430_host.h"
+#include "dlwisp41.h"
+#include "mywisp.h"
+#include "eeprom.h"
+#include "eeprom24.h"
+
+#define BENCH_SMCLK_HZ            1.2e6
+
+typedef struct {
+  double us;
+  unsigned long long scl, cycles;
+  unsigned long isrs, nacks;
+} mark;
+
+static void mark_now(mark *m)
+{
+  m->us = eeprom24_us;
+  m->scl = eeprom24_scl;
+  m->cycles = host_cycles;
+  m->isrs = eeprom24_isrs;
+  m->nacks = eeprom24_nacks;
+}
+
+static void report(const char *name, const mark *m, unsigned bytes)
+{
+  mark e;
+  double s;
+
+  mark_now(&e);
+  s = ( e.us - m->us ) * 1e-6;
+  printf("  %-22s %5u B %8.1f ms  %6.1f SCL/B %7.1f cycles/B "
+         "%4.2f isr/B %3lu NACK  %6.0f B/s\n", name, bytes, s * 1e3,
+         (double)( e.scl - m->scl ) / bytes,
+         (double)( e.cycles - m->cycles ) / bytes,
+         (double)( e.isrs - m->isrs ) / bytes, e.nacks - m->nacks,
+         bytes / s);
+}
+
+static void check(const unsigned char *a, const unsigned char *b,
+                  unsigned n, const char *what)
+{
+  for ( unsigned i = 0; i < n; i++ )
+    if ( a[i] != b[i] )
+      host_fail("%s: byte %u is %02x, not %02x", what, i, a[i], b[i]);
+}
+
+int main(void)
+{
+  static unsigned char data[EEPROM_BYTES], back[EEPROM_BYTES];
+  mark m;
+
+  for ( unsigned i = 0; i < EEPROM_BYTES; i++ )
+    data[i] = (unsigned char)( i * 7 + ( i >> 8 ) );
+
+  eeprom24_init(BENCH_SMCLK_HZ);
+  init_eeprom();
+  printf("eeprom_bench: 24xx08 model, SCL = SMCLK / %u, %.0f ms write "
+         "cycles\n", UCB0BR0, EEPROM24_WRITE_US / 1000);
+
+  mark_now(&m);
+  if ( !write_eeprom(0, data, EEPROM_BYTES) )
+    host_fail("write_eeprom() failed");
+  report("write 1 kB", &m, EEPROM_BYTES);
+  check(eeprom24_mem, data, EEPROM_BYTES, "write");
+  eeprom24_idle(EEPROM24_WRITE_US);     // the last page's write cycle
+
+  mark_now(&m);
+  if ( !read_eeprom(0, back, EEPROM_BYTES) )
+    host_fail("read_eeprom() failed");
+  report("read 1 kB", &m, EEPROM_BYTES);
+  check(back, data, EEPROM_BYTES, "read");
+
+  mark_now(&m);
+  if ( !read_eeprom(0x200, back, 256) )
+    host_fail("read_eeprom() failed");
+  report("read 256 B log", &m, 256);
+  check(back, data + 0x200, 256, "read 256");
+
+  mark_now(&m);
+  for ( unsigned i = 0; i < EEPROM_BYTES; i++ )
+    if ( !read_eeprom(i, back + i, 1) )
+      host_fail("read_eeprom() of byte %u failed", i);
+  report("read 1 kB byte by byte", &m, EEPROM_BYTES);
+  check(back, data, EEPROM_BYTES, "byte reads");
+
+  return 0;
+}
@@ -0,0 +1,134 @@
+/* See license.txt for license information. */
+
+#include "msp430_host.h"
+#include "infoflash.h"
+
+#define FRKEY                     0x9600
+#define KEY_MASK                  0xFF00
+#define FN_MASK                   0x3F
+
+// the timing generator's range
+#define TG_MIN_HZ                 257e3
+#define TG_MAX_HZ                 476e3
+
+unsigned short infoflash_mem[INFOFLASH_WORDS];
+unsigned short infoflash_meant[INFOFLASH_WORDS];
+
+unsigned long infoflash_words;
+unsigned long infoflash_erases;
+unsigned long infoflash_segment_erases[INFOFLASH_SEGMENTS];
+double infoflash_word_us;
+double infoflash_erase_us;
+
+static double mclk;
+static unsigned long cut_in;            // writes to go, 0 for none
+static unsigned short cut_garbage;
+static unsigned char cut;               // power's gone
+
+static void key(volatile unsigned short *reg, const char *name)
+{
+  if ( ( *reg & KEY_MASK ) != FWKEY )
+    host_fail("flash write with %s %04x, last written without FWKEY", name,
+              *reg);
+}
+
+// MCLK cycles a timing generator cycle
+static unsigned timing(void)
+{
+  unsigned div = ( FCTL2 & FN_MASK ) + 1;
+
+  if ( ( FCTL2 & ( FSSEL_1 | FSSEL_2 ) ) == 0 )
+    host_fail("flash timing generator on ACLK, which isn't modelled");
+  if ( mclk / div < TG_MIN_HZ || mclk / div > TG_MAX_HZ )
+    host_fail("flash timing generator at %.0f kHz", mclk / div / 1000);
+  return div;
+}
+
+void infoflash_init(double mclk_hz)
+{
+  for ( unsigned i = 0; i < INFOFLASH_WORDS; i++ )
+    infoflash_mem[i] = infoflash_meant[i] = 0xFFFF;
+  for ( unsigned i = 0; i < INFOFLASH_SEGMENTS; i++ )
+    infoflash_segment_erases[i] = 0;
+  infoflash_words = infoflash_erases = 0;
+  infoflash_word_us = infoflash_erase_us = 0;
+  mclk = mclk_hz;
+  FCTL1 = FRKEY;
+  FCTL2 = FRKEY + FSSEL_1 + FN1;
+  FCTL3 = FRKEY + LOCK + LOCKA;
+  infoflash_power_up();
+}
+
+void infoflash_cut(unsigned long writes, unsigned short garbage)
+{
+  cut_in = writes + 1;
+  cut_garbage = garbage;
+}
+
+unsigned char infoflash_was_cut(void)
+{
+  return cut;
+}
+
+void infoflash_power_up(void)
+{
+  cut = 0;
+  cut_in = 0;
+}
+
+void infoflash_write(volatile unsigned short *w, unsigned short v)
+{
+  long i = (unsigned short *)w - infoflash_mem;
+  unsigned seg = (unsigned)i / INFOFLASH_SEGMENT_WORDS;
+  unsigned div;
+  unsigned short *s;
+  unsigned char torn = 0;
+
+  if ( i < 0 || i >= INFOFLASH_WORDS )
+    host_fail("flash write outside info flash");
+  s = &infoflash_meant[seg * INFOFLASH_SEGMENT_WORDS];
+  if ( ( FCTL1 & ~KEY_MASK ) == ERASE )
+    for ( unsigned k = 0; k < INFOFLASH_SEGMENT_WORDS; k++ )
+      s[k] = 0xFFFF;
+  else
+    infoflash_meant[i] = v;
+  if ( cut )
+    return;
+  if ( cut_in && --cut_in == 0 )
+    cut = torn = 1;
+
+  key(&FCTL1, "FCTL1");
+  key(&FCTL2, "FCTL2");
+  key(&FCTL3, "FCTL3");
+  if ( FCTL3 & LOCK )
+    host_fail("flash write with LOCK set");
+  if ( seg == INFOFLASH_SEGMENTS - 1 )
+    host_fail("write to segment A, the calibration constants");
+  div = timing();
+
+  switch ( FCTL1 & ~KEY_MASK )
+  {
+  case WRT:
+    if ( infoflash_mem[i] != 0xFFFF )
+      host_fail("word %ld programmed (%04x over %04x) without an erase", i, v,
+                infoflash_mem[i]);
+    infoflash_mem[i] = torn ? ( v | cut_garbage ) : v;
+    infoflash_words++;
+    infoflash_word_us += INFOFLASH_WORD_CYCLES * div * 1e6 / mclk;
+    host_cycles += INFOFLASH_WORD_CYCLES * div;
+    break;
+
+  case ERASE:
+    s = &infoflash_mem[seg * INFOFLASH_SEGMENT_WORDS];
+    for ( unsigned k = 0; k < INFOFLASH_SEGMENT_WORDS; k++ )
+      s[k] = torn ? ( s[k] | cut_garbage ) : 0xFFFF;
+    infoflash_erases++;
+    infoflash_segment_erases[seg]++;
+    infoflash_erase_us += INFOFLASH_ERASE_CYCLES * div * 1e6 / mclk;
+    host_cycles += INFOFLASH_ERASE_CYCLES * div;
+    break;
+
+  default:
+    host_fail("flash write with FCTL1 %04x", FCTL1);
+  }
+}
@@ -0,0 +1,56 @@
+/* See license.txt for license information. */
+
+#ifndef INFOFLASH_H
+#define INFOFLASH_H
+
+/*
+ * The F2132's information flash and flash controller, for the benchmarks
+ * that run checkpoint.c. It's built with CHECKPOINT_BASE at infoflash_mem
+ * and CP_FLASH_WRITE() going to infoflash_write(), so the controller sees
+ * every word written to the flash along with FCTL1-3 as they stand:
+ *
+ *   WRT     the word is programmed. It has to be erased (0xFFFF) first;
+ *           programming only clears bits, anything else fails.
+ *   ERASE   a dummy write: the word's segment is erased.
+ *
+ * Either needs LOCK clear, FSSEL and FN in FCTL2 giving a timing generator
+ * clock of 257-476 kHz, and FWKEY in all three registers as they were last
+ * written (without it the part would reset). Segment A stays locked. Reads
+ * aren't seen; they go straight to infoflash_mem.
+ *
+ * Timing: a word takes 30 timing generator cycles and an erase 4819, with
+ * the CPU held; host_cycles gets the MCLK cycles, the generator running
+ * from MCLK (given to infoflash_init()) or SMCLK, taken to be the same.
+ */
+
+#define INFOFLASH_SEGMENTS        4     // D, C, B, A from 0x1000
+#define INFOFLASH_SEGMENT_WORDS   32
+#define INFOFLASH_WORDS           (INFOFLASH_SEGMENTS * INFOFLASH_SEGMENT_WORDS)
+#define INFOFLASH_WORD_CYCLES     30    // timing generator cycles
+#define INFOFLASH_ERASE_CYCLES    4819
+
+extern unsigned short infoflash_mem[INFOFLASH_WORDS];
+// what each word would hold had the power not failed
+extern unsigned short infoflash_meant[INFOFLASH_WORDS];
+
+extern unsigned long infoflash_words;           // words programmed
+extern unsigned long infoflash_erases;          // segment erases
+extern unsigned long infoflash_segment_erases[INFOFLASH_SEGMENTS];
+extern double infoflash_word_us;                // time spent programming
+extern double infoflash_erase_us;               // and erasing
+
+// Erased flash, counts zeroed, the registers at their reset values.
+void infoflash_init(double mclk_hz);
+
+// Power fails at the flash write that many from now. That one is left half
+// done: a word keeps the bits in garbage erased, and an erased segment
+// has only those set besides what it held. Nothing written after takes.
+void infoflash_cut(unsigned long writes, unsigned short garbage);
+
+// Whether the power failed, and power back on.
+unsigned char infoflash_was_cut(void);
+void infoflash_power_up(void);
+
+void infoflash_write(volatile unsigned short *w, unsigned short v);
+
+#endif // INFOFLASH_H
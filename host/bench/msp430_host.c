@@ -0,0 +1,119 @@
+/* See license.txt for license information. */
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define HOST_DEFINE_SFRS
+#include "msp430_host.h"
+
+// the sleeps a model gets before it's taken to be stuck
+#define HOST_SLEEP_LIMIT          1000000
+
+unsigned long long host_cycles = 0;
+unsigned short host_sr = 0;
+void (*host_sleep)(void) = 0;
+
+void host_fail(const char *fmt, ...)
+{
+  va_list ap;
+
+  va_start(ap, fmt);
+  fprintf(stderr, "bench: ");
+  vfprintf(stderr, fmt, ap);
+  fprintf(stderr, "\n");
+  va_end(ap);
+  exit(1);
+}
+
+void _BIS_SR(unsigned short bits)
+{
+  unsigned long n = 0;
+
+  host_sr |= bits;
+  while ( host_sr & CPUOFF )
+  {
+    if ( !host_sleep )
+      host_fail("low-power mode with nothing to wake it");
+    if ( ++n > HOST_SLEEP_LIMIT )
+      host_fail("still asleep after %lu wakes", n - 1);
+    host_sleep();
+  }
+}
+
+void _BIC_SR(unsigned short bits)
+{
+  host_sr &= ~bits;
+}
+
+// On the part these change the copy of SR an interrupt handler returns
+// with; here the handlers run from host_sleep(), so that's host_sr.
+void _BIC_SR_IRQ(unsigned short bits)
+{
+  host_sr &= ~bits;
+}
+
+void _BIS_SR_IRQ(unsigned short bits)
+{
+  host_sr |= bits;
+}
+
+void __bis_SR_register(unsigned short bits)
+{
+  _BIS_SR(bits);
+}
+
+void __bic_SR_register(unsigned short bits)
+{
+  _BIC_SR(bits);
+}
+
+void __bic_SR_register_on_exit(unsigned short bits)
+{
+  _BIC_SR_IRQ(bits);
+}
+
+void __bis_SR_register_on_exit(unsigned short bits)
+{
+  _BIS_SR_IRQ(bits);
+}
+
+unsigned short __swap_bytes(unsigned short x)
+{
+  return (unsigned short)((x << 8) | (x >> 8));
+}
+
+unsigned short __get_SR_register(void)
+{
+  return host_sr;
+}
+
+unsigned short __get_interrupt_state(void)
+{
+  return host_sr & GIE;
+}
+
+void __set_interrupt_state(unsigned short state)
+{
+  host_sr = (host_sr & ~GIE) | (state & GIE);
+}
+
+void __disable_interrupt(void)
+{
+  host_sr &= ~GIE;
+}
+
+void __enable_interrupt(void)
+{
+  host_sr |= GIE;
+}
+
+void __no_operation(void)
+{
+  host_cycles++;
+}
+
+void __delay_cycles(unsigned long n)
+{
+  host_cycles += n;
+}
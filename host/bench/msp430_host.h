@@ -0,0 +1,36 @@
+/* See license.txt for license information. */
+
+#ifndef MSP430_HOST_H
+#define MSP430_HOST_H
+
+/*
+ * What the benchmarks in host/bench share: the register file, the status
+ * register and a cycle count for the tag sources built on the host.
+ *
+ * The register file is inert. A benchmark that needs a peripheral to do
+ * something (the USCI, the ADC10) models it in host_sleep(), which runs
+ * whenever the tag code goes into a low-power mode with _BIS_SR(), and by
+ * hand between calls into the tag code. An interrupt handler that calls
+ * LPMx_EXIT clears CPUOFF in host_sr, and that's what ends the sleep. The
+ * flash controller holds the CPU instead of letting it sleep; see
+ * infoflash.h.
+ *
+ * host_cycles counts MCLK cycles where the model knows them: __delay_cycles()
+ * and whatever the benchmark's peripheral models add for the time the CPU
+ * spends waiting on them. Time spent running C isn't counted; the host
+ * can't see that.
+ */
+
+#include <msp430x21x2.h>
+
+extern unsigned long long host_cycles;
+extern unsigned short host_sr;
+
+// Run the interrupt(s) that end a low-power mode. Left 0, a sleep is an
+// error: the tag code would hang.
+extern void (*host_sleep)(void);
+
+// Print a message and exit(1).
+void host_fail(const char *fmt, ...);
+
+#endif // MSP430_HOST_H
@@ -0,0 +1,254 @@
+/* See license.txt for license information. */
+
+/*
+ * Scheduled readings (sched.c, sensors.c) with a sensor that sleeps through
+ * its conversions in adc_seq_read() (quick accel), against a model of
+ * Timer1_A on ACLK, the ADC10 and a reader. The readings have to stay on
+ * their deadlines in real time, whatever low-power mode the driver picks.
+ *
+ * ACLK is the 32.768 kHz crystal (ACLK_FROM_CRYSTAL). It stops while OSCOFF
+ * is set (LPM4), and once that clears LFXT1 takes BENCH_XT_START_MS to
+ * oscillate again; the datasheet gives no figure, so that's taken from
+ * typical watch crystals. Timer1_A counts ACLK in up mode and runs
+ * sched_ISR() at TA1CCR0. The ADC10 converts a CONSEQ_1 sequence at
+ * ADC10SHTx + 13 clocks of ADC10OSC / (ADC10DIVx + 1) a channel, the DTC
+ * fills the block with mid-scale (ADC10SA as in accel_bench.c), and
+ * ADC10_ISR() runs at the end.
+ *
+ * The tag listens in LPM3, as setup_to_receive() does. A reader command
+ * comes at random, BENCH_COMMAND_GAP_MS apart on average, and keeps the CPU
+ * up to BENCH_COMMAND_MS; then, as the main loop does at a timeout, a
+ * reading is taken if one is due (sensors_due()). Reading k of the sensor
+ * is due at tick k * SENSOR_ACCEL_QUICK_EVERY, which on ACLK is a real time
+ * too. Checked: no reading before that, none later than a command and a
+ * tick after it, no deadline missed, and Timer1_A still in step with real
+ * time at the end.
+ *
+ *   sched_bench [seconds]
+ */
+
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "msp430_host.h"
+#include "dlwisp41.h"
+#include "mywisp.h"
+#include "rfid.h"
+#include "sensors.h"
+#include "sched.h"
+#include "adc_seq.h"
+
+#define BENCH_XT_START_MS         300.0
+#define BENCH_ADC10OSC_HZ         5.0e6
+#define BENCH_COMMAND_GAP_MS      20.0
+#define BENCH_COMMAND_MS          3.0
+
+#define BENCH_PERIOD              QUICK_ACCEL_PERIOD  // ticks
+#define BENCH_NEVER               1e30
+
+void sched_ISR(void);
+void ADC10_ISR(void);
+
+// what the tag code around sensors.c would hold
+unsigned int sensor_counter;
+
+unsigned short is_power_good()
+{
+  return 1;
+}
+
+void sleep()
+{
+  host_fail("sleep() with the power good");
+}
+
+static unsigned long long seed = 1;
+
+static double now;                // s
+static double xt_ready;           // when LFXT1 runs again
+static int xt_stopped;
+static double ta1_count;          // ACLK cycles into this tick
+static unsigned long ta1_ticks;   // real ones, for the end
+
+static double adc_end = -1;       // when the sequence is in, or -1
+
+static double next_command;
+
+static double bench_uniform(void)
+{
+  seed = seed * 6364136223846793005ull + 1442695040888963407ull;
+  return ( ( seed >> 11 ) + 0.5 ) / 9007199254740992.0;
+}
+
+static double aclk_from(void)
+{
+  if ( xt_stopped )
+    return BENCH_NEVER;
+  return now > xt_ready ? now : xt_ready;
+}
+
+// the next Timer1_A interrupt
+static double tick_at(void)
+{
+  double from = aclk_from();
+
+  if ( from == BENCH_NEVER )
+    return BENCH_NEVER;
+  return from + ( TA1CCR0 + 1 - ta1_count ) / ACLK_HZ;
+}
+
+// LFXT1 stops with OSCOFF, and starts over once it's cleared
+static void crystal(void)
+{
+  if ( host_sr & OSCOFF )
+    xt_stopped = 1;
+  else if ( xt_stopped )
+  {
+    xt_stopped = 0;
+    xt_ready = now + BENCH_XT_START_MS * 1e-3;
+  }
+}
+
+// Time goes on to t, the timer with it while ACLK runs. sched_ISR() runs
+// for each tick; the CPU is awake or about to sleep, and GIE is on.
+static void advance(double t)
+{
+  crystal();
+  while ( tick_at() <= t )
+  {
+    now = tick_at();
+    ta1_count = 0;
+    ta1_ticks++;
+    sched_ISR();
+  }
+
+  if ( aclk_from() < t )
+    ta1_count += ( t - aclk_from() ) * ACLK_HZ;
+  now = t;
+}
+
+static double adc_sequence_s(void)
+{
+  static const unsigned sht[4] = { 4, 8, 16, 64 };
+  unsigned div = ( ( ADC10CTL1 >> 5 ) & 7 ) + 1;
+  unsigned words = ADC10DTC1;
+
+  return words * ( sht[( ADC10CTL0 >> 11 ) & 3] + 13 ) * div /
+         BENCH_ADC10OSC_HZ;
+}
+
+// The block ADC10SA points into: the low 16 bits are the register, the rest
+// the nearest 64K window at or above this frame.
+static unsigned short *adc_map(void)
+{
+  unsigned short here;
+  uintptr_t base = (uintptr_t)&here;
+  uintptr_t p = (base & ~(uintptr_t)0xFFFF) | ADC10SA;
+
+  if ( p < base )
+    p += 0x10000;
+  return (unsigned short *)p;
+}
+
+// Asleep: on to the next interrupt that could wake the CPU, and run it.
+static void bench_sleep(void)
+{
+  double t;
+
+  crystal();
+  if ( !( host_sr & GIE ) )
+    host_fail("asleep with GIE off");
+
+  if ( ( ADC10CTL0 & ENC ) && adc_end < 0 )
+  {
+    if ( ( ADC10CTL1 & CONSEQ_3 ) != CONSEQ_1 || ADC10DTC0 )
+      host_fail("only one-shot sequences are modelled");
+    adc_end = now + adc_sequence_s();
+  }
+
+  if ( adc_end >= 0 )
+  {
+    // the tick can come first; the driver has to go back to sleep
+    t = tick_at();
+    if ( t < adc_end )
+    {
+      advance(t);
+      return;
+    }
+    advance(adc_end);
+    for ( unsigned i = 0; i < ADC10DTC1; i++ )
+      adc_map()[i] = 512;
+    adc_end = -1;
+    ADC10_ISR();
+    return;
+  }
+
+  // listening: a tick, or the next command (at once if it came while the
+  // tag was busy)
+  t = tick_at();
+  if ( t < next_command )
+  {
+    advance(t);
+    return;
+  }
+  if ( next_command > now )
+    advance(next_command);
+  host_sr &= ~LPM4_bits;                  // Port1_ISR
+}
+
+int main(int argc, char **argv)
+{
+  double seconds = ( argc > 1 ) ? atof(argv[1]) : 3600;
+  double late_max = 0, late_sum = 0, tick_s = 1.0 / SCHED_TICK_HZ;
+  unsigned long readings = 0, commands = 0;
+  unsigned char payload[16], type;
+  unsigned short first;
+
+  host_sleep = bench_sleep;
+  sched_start();
+  host_sr |= GIE;
+  next_command = -log(bench_uniform()) * BENCH_COMMAND_GAP_MS * 1e-3;
+
+  printf("sched_bench: reading every %u ticks at %u Hz, crystal start "
+         "%.0f ms, a command every %.0f ms\n", BENCH_PERIOD, SCHED_TICK_HZ,
+         BENCH_XT_START_MS, BENCH_COMMAND_GAP_MS);
+
+  while ( now < seconds )
+  {
+    if ( sensors_due() )
+    {
+      double at = now, late;
+
+      if ( !sensors_read(payload, &type, &first) )
+        host_fail("a reading was due and none came");
+      late = at - (double)first * BENCH_PERIOD * tick_s;
+      if ( late < -1e-9 )                  // rounding
+        host_fail("reading %u taken %.1f ms early", first, -late * 1e3);
+      if ( late > tick_s + BENCH_COMMAND_MS * 1e-3 )
+        host_fail("reading %u taken %.1f ms late, after %lu", first,
+                  late * 1e3, readings);
+      if ( late > late_max )
+        late_max = late;
+      late_sum += late;
+      readings++;
+    }
+
+    _BIS_SR(LPM3_bits + GIE);
+    if ( now >= next_command )
+    {
+      commands++;
+      advance(now + bench_uniform() * BENCH_COMMAND_MS * 1e-3);
+      next_command = now - log(bench_uniform()) * BENCH_COMMAND_GAP_MS * 1e-3;
+    }
+  }
+
+  if ( sensor_misses )
+    host_fail("%u deadlines missed", sensor_misses);
+  if ( fabs(ta1_ticks - now / tick_s) > 1 )
+    host_fail("Timer1_A at %lu ticks after %.0f s", ta1_ticks, now);
+  printf("  %.0f s, %lu commands, %lu readings: %.1f ms late on average, "
+         "%.1f at most\n", now, commands, readings,
+         late_sum / readings * 1e3, late_max * 1e3);
+  return 0;
+}
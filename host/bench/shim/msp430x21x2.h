@@ -0,0 +1,355 @@
+/* See license.txt for license information. */
+
+#ifndef MSP430X21X2_H
+#define MSP430X21X2_H
+
+/*
+ * Host stand-in for the IAR part header, for the benchmarks in host/bench.
+ * Only what the tag sources use is here. Registers are plain variables
+ * (msp430_host.c defines them); nothing happens when they're written, so a
+ * benchmark that needs a peripheral models it itself, see msp430_host.h.
+ * The bit values are the F2132's.
+ */
+
+#ifdef HOST_DEFINE_SFRS
+#define SFRB(n)                   volatile unsigned char n
+#define SFRW(n)                   volatile unsigned short n
+#else
+#define SFRB(n)                   extern volatile unsigned char n
+#define SFRW(n)                   extern volatile unsigned short n
+#endif
+#define BIT0 0x01
+#define BIT1 0x02
+#define BIT2 0x04
+#define BIT3 0x08
+#define BIT4 0x10
+#define BIT5 0x20
+#define BIT6 0x40
+#define BIT7 0x80
+#define BIT8 0x100
+#define BIT9 0x200
+#define BITA 0x400
+#define BITB 0x800
+#define BITC 0x1000
+#define BITD 0x2000
+#define BITE 0x4000
+#define BITF 0x8000
+SFRB(P1IN);
+SFRB(P1OUT);
+SFRB(P1DIR);
+SFRB(P1SEL);
+SFRB(P1IE);
+SFRB(P1IES);
+SFRB(P1IFG);
+SFRB(P1REN);
+SFRB(P2IN);
+SFRB(P2OUT);
+SFRB(P2DIR);
+SFRB(P2SEL);
+SFRB(P2IE);
+SFRB(P2IES);
+SFRB(P2IFG);
+SFRB(P2REN);
+SFRB(P3IN);
+SFRB(P3OUT);
+SFRB(P3DIR);
+SFRB(P3SEL);
+SFRB(P3REN);
+SFRB(IE1);
+SFRB(IFG1);
+SFRB(IE2);
+SFRB(IFG2);
+#define WDTIE 0x01
+#define WDTIFG 0x01
+#define OFIFG 0x02
+#define PORIFG 0x04
+#define RSTIFG 0x08
+#define NMIIFG 0x10
+#define OFIE 0x02
+#define UCB0TXIFG 0x08
+#define UCB0RXIFG 0x04
+#define UCB0TXIE 0x08
+#define UCB0RXIE 0x04
+SFRW(WDTCTL);
+#define WDTPW 0x5A00
+#define WDTHOLD 0x0080
+#define WDTTMSEL 0x0010
+#define WDTCNTCL 0x0008
+#define WDTSSEL 0x0004
+#define WDTIS0 1
+#define WDTIS1 2
+#define WDT_MDLY_0_5 (WDTPW+WDTTMSEL+WDTCNTCL+WDTIS1)
+#define WDT_MDLY_0_064 (WDTPW+WDTTMSEL+WDTCNTCL+WDTIS1+WDTIS0)
+#define WDT_ADLY_1_9 (WDTPW+WDTTMSEL+WDTCNTCL+WDTSSEL+WDTIS1+WDTIS0)
+#define WDT_ADLY_16 (WDTPW+WDTTMSEL+WDTCNTCL+WDTSSEL+WDTIS1)
+SFRB(DCOCTL);
+SFRB(BCSCTL1);
+SFRB(BCSCTL2);
+SFRB(BCSCTL3);
+SFRB(CALDCO_1MHZ);
+SFRB(CALBC1_1MHZ);
+SFRB(CALDCO_8MHZ);
+SFRB(CALBC1_8MHZ);
+SFRB(CALDCO_12MHZ);
+SFRB(CALBC1_12MHZ);
+SFRB(CALDCO_16MHZ);
+SFRB(CALBC1_16MHZ);
+#define DCO0 0x20
+#define DCO1 0x40
+#define DCO2 0x80
+#define MOD0 0x01
+#define RSEL0 0x01
+#define RSEL1 0x02
+#define RSEL2 0x04
+#define RSEL3 0x08
+#define DIVA_0 0x00
+#define DIVA_1 0x10
+#define DIVA_2 0x20
+#define DIVA_3 0x30
+#define XTS 0x40
+#define XT2OFF 0x80
+#define DIVS_0 0
+#define DIVS_1 2
+#define DIVS_2 4
+#define DIVS_3 6
+#define DIVM_0 0
+#define DIVM_1 0x10
+#define DIVM_2 0x20
+#define DIVM_3 0x30
+#define SELM_0 0
+#define SELS 0x08
+#define LFXT1OF 0x01
+#define XT2OF 0x02
+#define XCAP_0 0
+#define XCAP_1 0x04
+#define XCAP_2 0x08
+#define XCAP_3 0x0C
+#define LFXT1S_0 0
+#define LFXT1S_2 0x20
+SFRW(TACTL);
+SFRW(TAR);
+SFRW(TACCR0);
+SFRW(TACCR1);
+SFRW(TACCR2);
+SFRW(TACCTL0);
+SFRW(TACCTL1);
+SFRW(TACCTL2);
+SFRW(TAIV);
+SFRW(TA0CTL);
+SFRW(TA0R);
+SFRW(TA0CCR0);
+SFRW(TA0CCR1);
+SFRW(TA0CCR2);
+SFRW(TA0CCTL0);
+SFRW(TA0CCTL1);
+SFRW(TA0CCTL2);
+SFRW(TA0IV);
+SFRW(TA1CTL);
+SFRW(TA1R);
+SFRW(TA1CCR0);
+SFRW(TA1CCR1);
+SFRW(TA1CCTL0);
+SFRW(TA1CCTL1);
+SFRW(TA1IV);
+#define TASSEL_0 0
+#define TASSEL_1 0x100
+#define TASSEL_2 0x200
+#define TASSEL0 0x100
+#define TASSEL1 0x200
+#define ID_0 0
+#define ID_1 0x40
+#define ID_2 0x80
+#define ID_3 0xC0
+#define MC_0 0
+#define MC_1 0x10
+#define MC_2 0x20
+#define MC_3 0x30
+#define MC0 0x10
+#define MC1 0x20
+#define TACLR 0x04
+#define TAIE 0x02
+#define TAIFG 0x01
+#define CM_0 0
+#define CM_1 0x4000
+#define CM_2 0x8000
+#define CM_3 0xC000
+#define CM0 0x4000
+#define CM1 0x8000
+#define CCIS_0 0
+#define CCIS_1 0x1000
+#define CCIS0 0x1000
+#define CCIS1 0x2000
+#define SCS 0x0800
+#define SCCI 0x0400
+#define CAP 0x0100
+#define OUTMOD_0 0
+#define OUTMOD_3 0x60
+#define OUTMOD_4 0x80
+#define OUTMOD_7 0xE0
+#define OUTMOD2 0x80
+#define CCIE 0x10
+#define CCI 0x08
+#define OUT 0x04
+#define COV 0x02
+#define CCIFG 0x01
+SFRW(ADC10CTL0);
+SFRW(ADC10CTL1);
+SFRW(ADC10MEM);
+SFRW(ADC10SA);
+SFRB(ADC10AE0);
+SFRB(ADC10DTC0);
+SFRB(ADC10DTC1);
+#define ADC10SC 0x01
+#define ENC 0x02
+#define ADC10IFG 0x04
+#define ADC10IE 0x08
+#define ADC10ON 0x10
+#define REFON 0x20
+#define REF2_5V 0x40
+#define MSC 0x80
+#define REFBURST 0x100
+#define REFOUT 0x200
+#define ADC10SR 0x400
+#define ADC10SHT_0 0
+#define ADC10SHT_1 0x800
+#define ADC10SHT_2 0x1000
+#define ADC10SHT_3 0x1800
+#define SREF_0 0
+#define SREF_1 0x2000
+#define ADC10BUSY 0x01
+#define CONSEQ_0 0
+#define CONSEQ_1 0x02
+#define CONSEQ_2 0x04
+#define CONSEQ_3 0x06
+#define ADC10SSEL_0 0
+#define ADC10SSEL_1 0x08
+#define ADC10SSEL_2 0x10
+#define ADC10SSEL_3 0x18
+#define ADC10DIV_0 0
+#define ADC10DIV_1 0x20
+#define ADC10DIV_2 0x40
+#define ADC10DIV_3 0x60
+#define ADC10DIV_4 0x80
+#define ADC10DIV_5 0xA0
+#define ADC10DIV_6 0xC0
+#define ADC10DIV_7 0xE0
+#define ISSH 0x100
+#define ADC10DF 0x200
+#define SHS_0 0
+#define SHS_1 0x400
+#define SHS_2 0x800
+#define SHS_3 0xC00
+#define INCH_0 0
+#define INCH_1 0x1000
+#define INCH_2 0x2000
+#define INCH_3 0x3000
+#define INCH_4 0x4000
+#define INCH_5 0x5000
+#define INCH_6 0x6000
+#define INCH_7 0x7000
+#define INCH_10 0xA000
+#define INCH_11 0xB000
+#define ADC10FETCH 0x01
+#define ADC10B1 0x02
+#define ADC10CT 0x04
+#define ADC10TB 0x08
+SFRB(UCB0CTL0);
+SFRB(UCB0CTL1);
+SFRB(UCB0BR0);
+SFRB(UCB0BR1);
+SFRB(UCB0STAT);
+SFRB(UCB0RXBUF);
+SFRB(UCB0TXBUF);
+SFRW(UCB0I2CSA);
+SFRB(UCB0I2CIE);
+#define UCMST 0x08
+#define UCMODE_3 0x06
+#define UCSYNC 0x01
+#define UCSSEL_2 0x80
+#define UCSWRST 0x01
+#define UCTR 0x10
+#define UCTXSTT 0x02
+#define UCTXSTP 0x04
+#define UCTXNACK 0x08
+#define UCNACKIFG 0x08
+#define UCALIFG 0x01
+#define UCSTTIFG 0x02
+#define UCSTPIFG 0x04
+#define UCNACKIE 0x08
+#define UCALIE 0x01
+#define UCBBUSY 0x10
+SFRW(FCTL1);
+SFRW(FCTL2);
+SFRW(FCTL3);
+#define FWKEY 0xA500
+#define FRKEY 0x9600
+#define ERASE 0x02
+#define MERAS 0x04
+#define WRT 0x40
+#define BLKWRT 0x80
+#define FSSEL_1 0x40
+#define FSSEL_2 0x80
+#define FN0 1
+#define FN1 2
+#define FN2 4
+#define FN3 8
+#define FN4 16
+#define FN5 32
+#define LOCK 0x10
+#define LOCKA 0x40
+#define BUSY 0x01
+#define WAIT 0x08
+#define KEYV 0x20
+#define ACCVIFG 0x04
+#define GIE 0x08
+#define CPUOFF 0x10
+#define OSCOFF 0x20
+#define SCG0 0x40
+#define SCG1 0x80
+#define LPM0_bits CPUOFF
+#define LPM1_bits (SCG0+CPUOFF)
+#define LPM3_bits (SCG1+SCG0+CPUOFF)
+#define LPM4_bits (SCG1+SCG0+OSCOFF+CPUOFF)
+#define LPM4 _BIS_SR(LPM4_bits)
+#define LPM3 _BIS_SR(LPM3_bits)
+#define LPM0 _BIS_SR(LPM0_bits)
+#define LPM4_EXIT _BIC_SR_IRQ(LPM4_bits)
+#define LPM3_EXIT _BIC_SR_IRQ(LPM3_bits)
+#define LPM0_EXIT _BIC_SR_IRQ(LPM0_bits)
+
+// intrinsics (msp430_host.c)
+void _BIS_SR(unsigned short);
+void _BIC_SR(unsigned short);
+void _BIC_SR_IRQ(unsigned short);
+void _BIS_SR_IRQ(unsigned short);
+void __bis_SR_register(unsigned short);
+void __bic_SR_register(unsigned short);
+void __bic_SR_register_on_exit(unsigned short);
+void __bis_SR_register_on_exit(unsigned short);
+unsigned short __swap_bytes(unsigned short);
+unsigned short __get_SR_register(void);
+unsigned short __get_interrupt_state(void);
+void __set_interrupt_state(unsigned short);
+void __disable_interrupt(void);
+void __enable_interrupt(void);
+void __no_operation(void);
+void __delay_cycles(unsigned long);
+
+// IAR keywords the host compiler doesn't need
+#define __interrupt
+#define __no_init
+#define __regvar
+#define __monitor
+#define __raw
+
+#define PORT1_VECTOR 1
+#define PORT2_VECTOR 2
+#define ADC10_VECTOR 3
+#define TIMER0_A0_VECTOR 4
+#define TIMER0_A1_VECTOR 5
+#define TIMER1_A0_VECTOR 6
+#define TIMER1_A1_VECTOR 7
+#define WDT_VECTOR 8
+#define USCIAB0TX_VECTOR 9
+#define USCIAB0RX_VECTOR 10
+#endif // MSP430X21X2_H
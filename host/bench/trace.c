@@ -0,0 +1,109 @@
+/* See license.txt for license information. */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "trace.h"
+
+#define TRACE_PI                  3.14159265358979323846
+#define TRACE_COUNTS_PER_MV       200.0
+
+typedef struct {
+  double at, width, mv;         // seconds from the R peak, seconds, mV
+} trace_wave;
+
+static const trace_wave trace_waves[] = {
+  { -0.20,  0.025,  0.15 },     // P
+  { -0.03,  0.008, -0.10 },     // Q
+  {  0.00,  0.010,  1.20 },     // R
+  {  0.03,  0.008, -0.25 },     // S
+  {  0.25,  0.040,  0.30 },     // T
+};
+
+// R peak of beat n: 0.83 s apart, +/-40 ms of slow variation
+static double trace_beat(long n)
+{
+  return 0.5 + n * 0.83 + 0.04 * sin(n * 0.7);
+}
+
+double trace_ecg(double t)
+{
+  long n = (long)floor((t - 0.5) / 0.83);
+  double v = 0;
+
+  // the neighbouring beats' waves reach this far
+  for ( long b = n - 1; b <= n + 2; b++ )
+  {
+    double r = trace_beat(b);
+
+    for ( size_t i = 0; i < sizeof(trace_waves) / sizeof(trace_waves[0]);
+          i++ )
+    {
+      double d = (t - r - trace_waves[i].at) / trace_waves[i].width;
+      v += trace_waves[i].mv * exp(-0.5 * d * d);
+    }
+  }
+  return TRACE_MID + v * TRACE_COUNTS_PER_MV;
+}
+
+double trace_wander(double t)
+{
+  return 60.0 * sin(2 * TRACE_PI * 0.25 * t) +
+         20.0 * sin(2 * TRACE_PI * 0.09 * t + 1.0);
+}
+
+double trace_hum(double t)
+{
+  return 10.0 * sin(2 * TRACE_PI * 50.0 * t);
+}
+
+// uniform in (0, 1), 64-bit LCG
+static double trace_uniform(unsigned long long *seed)
+{
+  *seed = *seed * 6364136223846793005ULL + 1442695040888963407ULL;
+  return ((*seed >> 11) + 0.5) / 9007199254740992.0;
+}
+
+double trace_noise(unsigned long long *seed, double rms)
+{
+  double u = trace_uniform(seed), v = trace_uniform(seed);
+
+  return rms * sqrt(-2 * log(u)) * cos(2 * TRACE_PI * v);
+}
+
+unsigned short trace_adc(double counts)
+{
+  long c = lround(counts);
+
+  if ( c < 0 )
+    return 0;
+  return ( c > 1023 ) ? 1023 : (unsigned short)c;
+}
+
+long trace_load(const char *path, unsigned short *out, size_t max)
+{
+  FILE *f = fopen(path, "r");
+  char line[256];
+  size_t n = 0;
+
+  if ( !f )
+    return -1;
+  while ( n < max && fgets(line, sizeof(line), f) )
+  {
+    char *p = line, *end;
+
+    if ( *p == '#' )
+      continue;
+    for ( ;; )
+    {
+      long v = strtol(p, &end, 10);
+
+      if ( end == p || n >= max )
+        break;
+      out[n++] = trace_adc(v);
+      p = end;
+    }
+  }
+  fclose(f);
+  return (long)n;
+}
@@ -0,0 +1,41 @@
+/* See license.txt for license information. */
+
+#ifndef TRACE_H
+#define TRACE_H
+
+/*
+ * ECG test signals for the benchmarks, in 10-bit ADC counts.
+ *
+ * The synthetic one is a sum of Gaussian P, Q, R, S and T waves at about
+ * 72 bpm with a little beat-to-beat variation, 1 mV taken as 200 counts
+ * around mid-scale. Baseline wander, mains hum and white noise are added
+ * separately so a benchmark can tell them apart.
+ *
+ * A recorded trace is a text file of 10-bit samples, one per line or
+ * separated by any white space; lines starting with # are skipped.
+ */
+
+#include <stddef.h>
+
+#define TRACE_MID                 512.0
+
+// The synthetic ECG at time t seconds, no wander, hum or noise.
+double trace_ecg(double t);
+
+// Baseline wander (breathing, electrode motion): ~0.25 Hz, 80 counts.
+double trace_wander(double t);
+
+// Mains hum: 50 Hz, 10 counts.
+double trace_hum(double t);
+
+// Gaussian white noise, rms counts, from *seed.
+double trace_noise(unsigned long long *seed, double rms);
+
+// What the ADC10 reads: rounded, clipped to 0..1023.
+unsigned short trace_adc(double counts);
+
+// Read a recorded trace. Returns the number of samples read (at most max),
+// or -1 if the file can't be read.
+long trace_load(const char *path, unsigned short *out, size_t max);
+
+#endif // TRACE_H
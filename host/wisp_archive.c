@@ -0,0 +1,83 @@
+/* See license.txt for license information. */
+
+#include <stdlib.h>
+#include "wisp_archive.h"
+
+// crc16_ccitt() on the tag, over everything but the CRC in bytes 2-3
+static unsigned record_check(const unsigned char *r)
+{
+  unsigned crc = 0xFFFF;
+  int i, j;
+
+  for ( i = 0; i < WISP_ARCHIVE_RECORD_BYTES; i++ )
+  {
+    if ( i == 2 || i == 3 )
+      continue;
+    crc ^= (unsigned)r[i] << 8;
+    for ( j = 0; j < 8; j++ )
+      crc = ( crc & 0x8000 ) ? ( ( crc << 1 ) ^ 0x1021 ) & 0xFFFF :
+                               ( crc << 1 ) & 0xFFFF;
+  }
+  return crc ^ 0xFFFF;
+}
+
+int wisp_archive_record_decode(const unsigned char *data, unsigned slot,
+                               wisp_archive_record *r)
+{
+  unsigned number = (unsigned)((data[0] << 8) | data[1]);
+
+  if ( record_check(data) != (unsigned)((data[2] << 8) | data[3]) ||
+       number >= WISP_ARCHIVE_SEQ_MOD ||
+       number % WISP_ARCHIVE_SLOTS != slot )
+    return -1;
+
+  r->number = (unsigned short)number;
+  r->slot = slot;
+  r->payload = data + 4;
+  return 0;
+}
+
+// Records in a ring are within WISP_ARCHIVE_SLOTS of the newest, so if the
+// numbers straddle the wrap, the small ones are the newer. (qsort() takes no
+// context, hence the static.)
+static int wrapped;
+
+static unsigned long unwrap(unsigned short n)
+{
+  return ( wrapped && n < WISP_ARCHIVE_SEQ_MOD / 2 ) ?
+         n + (unsigned long)WISP_ARCHIVE_SEQ_MOD : n;
+}
+
+static int by_number(const void *a, const void *b)
+{
+  unsigned long x = unwrap(((const wisp_archive_record *)a)->number);
+  unsigned long y = unwrap(((const wisp_archive_record *)b)->number);
+
+  return ( x > y ) - ( x < y );
+}
+
+size_t wisp_archive_decode(const unsigned char *bank, size_t len,
+                           wisp_archive_record *out, size_t max)
+{
+  size_t n = 0;
+  unsigned slot;
+  unsigned short lo = 0xFFFF, hi = 0;
+
+  for ( slot = 0; slot < WISP_ARCHIVE_SLOTS && n < max; slot++ )
+  {
+    if ( (slot + 1) * WISP_ARCHIVE_RECORD_BYTES > len )
+      break;
+    if ( wisp_archive_record_decode(bank + slot * WISP_ARCHIVE_RECORD_BYTES,
+                                    slot, &out[n]) )
+      continue;
+    if ( out[n].number < lo )
+      lo = out[n].number;
+    if ( out[n].number > hi )
+      hi = out[n].number;
+    n++;
+  }
+
+  wrapped = n && (unsigned)(hi - lo) > WISP_ARCHIVE_SEQ_MOD / 2;
+  qsort(out, n, sizeof(*out), by_number);
+  return n;
+}
@@ -0,0 +1,47 @@
+/* See license.txt for license information. */
+
+#ifndef WISP_ARCHIVE_H
+#define WISP_ARCHIVE_H
+
+/*
+ * Reader-side decoding of a WISP sample archive (archive.h on the tag), as
+ * read out of the User memory bank (user_bank.h).
+ *
+ * User word w holds EEPROM bytes 2w and 2w+1, MSB first, and archive slot s
+ * is words 8s to 8s+7. Read the slots with Reads of 8 words each, straight
+ * through; the tag has the next one ready while it answers the last. Put
+ * the bytes back together in slot order and hand them to
+ * wisp_archive_decode(), which checks every record and puts the good ones
+ * in order, oldest first. Slots that weren't read (or that failed) can be
+ * left as 0xFF; they're skipped like a torn record.
+ *
+ * Each record's payload is what the tag sent over the air at the time:
+ * wisp_payload_parse() the header, then wisp_stream_put() the samples as
+ * for any other batch.
+ */
+
+#include <stddef.h>
+
+#define WISP_ARCHIVE_RECORD_BYTES 16
+#define WISP_ARCHIVE_SLOTS        64
+#define WISP_ARCHIVE_DATA_BYTES   12
+#define WISP_ARCHIVE_SEQ_MOD      65472u    // ARCHIVE_SEQ_MOD on the tag
+
+typedef struct {
+  unsigned short number;        // record number, mod WISP_ARCHIVE_SEQ_MOD
+  unsigned slot;
+  const unsigned char *payload; // WISP_ARCHIVE_DATA_BYTES, zero-padded
+} wisp_archive_record;
+
+// Check the record read from slot. Returns 0, or -1 if it's torn, erased or
+// in the wrong slot.
+int wisp_archive_record_decode(const unsigned char *data, unsigned slot,
+                               wisp_archive_record *r);
+
+// The good records among the first len bytes of the bank, oldest first.
+// out has room for max. Returns how many there are; payload points into
+// bank.
+size_t wisp_archive_decode(const unsigned char *bank, size_t len,
+                           wisp_archive_record *out, size_t max);
+
+#endif // WISP_ARCHIVE_H
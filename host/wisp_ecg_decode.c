@@ -0,0 +1,101 @@
+/* See license.txt for license information. */
+
+#include "wisp_ecg_decode.h"
+
+#define ECG_RICE_ESCAPE   10   // must match ecg_codec.h
+
+typedef struct {
+  const unsigned char *p;
+  size_t len;
+  size_t pos;   // in bits
+} bit_reader;
+
+static int get_bit(bit_reader *br)
+{
+  size_t byte = br->pos >> 3;
+
+  if ( byte >= br->len )
+    return -1;
+  return (br->p[byte] >> (7 - (br->pos++ & 7))) & 1;
+}
+
+static long get_bits(bit_reader *br, unsigned n)
+{
+  long v = 0;
+
+  while ( n-- )
+  {
+    int b = get_bit(br);
+    if ( b < 0 )
+      return -1;
+    v = (v << 1) | b;
+  }
+  return v;
+}
+
+int wisp_ecg_decode(const unsigned char *block, size_t len,
+                    unsigned short *out, size_t max)
+{
+  bit_reader br = { block, len, 0 };
+  long header = get_bits(&br, 8);
+  unsigned count, order, k, i;
+
+  if ( header < 0 )
+    return -1;
+  count = (unsigned)header >> 4;
+  order = (((unsigned)header >> 3) & 1) + 1;
+  k = (unsigned)header & 7;
+
+  if ( count == 0 )
+    return 0;
+  if ( count > max )
+    return -1;
+
+  {
+    long first = get_bits(&br, 10);
+    if ( first < 0 )
+      return -1;
+    out[0] = (unsigned short)first;
+  }
+
+  for ( i = 1; i < count; i++ )
+  {
+    unsigned q = 0;
+    int b;
+    long x;
+
+    while ( q < ECG_RICE_ESCAPE && (b = get_bit(&br)) == 1 )
+      q++;
+    if ( q < ECG_RICE_ESCAPE && b < 0 )
+      return -1;
+
+    if ( q == ECG_RICE_ESCAPE )
+    {
+      x = get_bits(&br, 10);
+      if ( x < 0 )
+        return -1;
+    }
+    else
+    {
+      long low = get_bits(&br, k);
+      long u, r, p;
+
+      if ( low < 0 )
+        return -1;
+      u = ((long)q << k) | low;
+      r = (u & 1) ? -((u + 1) >> 1) : (u >> 1);
+
+      if ( order == 1 || i == 1 )
+        p = out[i-1];
+      else
+        p = 2L * out[i-1] - out[i-2];
+
+      x = p + r;
+      if ( x < 0 || x > 0x3ff )
+        return -1;
+    }
+    out[i] = (unsigned short)x;
+  }
+
+  return (int)count;
+}
@@ -0,0 +1,19 @@
+/* See license.txt for license information. */
+
+#ifndef WISP_ECG_DECODE_H
+#define WISP_ECG_DECODE_H
+
+/*
+ * Reader-side decoder for ECG blocks coded on the tag by ecg_encode()
+ * (ECG_COMPRESS; the format is described in ecg_codec.h). The coded block
+ * follows the payload header (see wisp_stream.h).
+ */
+
+#include <stddef.h>
+
+// Decode one coded block into out (room for max samples). Returns the number
+// of samples decoded, or -1 if the block is malformed or doesn't fit.
+int wisp_ecg_decode(const unsigned char *block, size_t len,
+                    unsigned short *out, size_t max);
+
+#endif // WISP_ECG_DECODE_H
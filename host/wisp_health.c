@@ -0,0 +1,177 @@
+/* See license.txt for license information. */
+
+#include <string.h>
+#include "wisp_health.h"
+
+int wisp_health_decode(const unsigned char *data, size_t len, wisp_health *h)
+{
+  unsigned first, n, i;
+
+  if ( len < 3 )
+    return -1;
+  first = data[2] & 0x0F;
+  n = data[2] >> 4;
+  if ( first >= WISP_HEALTH_COUNTERS || n == 0 || n > WISP_HEALTH_COUNTERS ||
+       len < 3 + 2 * n )
+    return -1;
+
+  memset(h, 0, sizeof(*h));
+  h->reset_cause = data[0];
+  h->vcap_mv = (unsigned)((data[1] * 4UL * WISP_HEALTH_FULL_SCALE_MV) / 1023);
+  for ( i = 0; i < n; i++ )
+  {
+    unsigned c = (first + i) % WISP_HEALTH_COUNTERS;
+
+    h->counter[c] = (unsigned short)((data[3 + 2*i] << 8) | data[4 + 2*i]);
+    h->has |= 1u << c;
+  }
+  return 0;
+}
+
+void wisp_health_fleet_init(wisp_health_fleet *f, wisp_health_tag *tags,
+                            size_t max)
+{
+  memset(tags, 0, max * sizeof(*tags));
+  f->tags = tags;
+  f->max = max;
+  f->count = 0;
+}
+
+static wisp_health_tag *find_tag(wisp_health_fleet *f, unsigned long tag)
+{
+  size_t i;
+
+  for ( i = 0; i < f->count; i++ )
+  {
+    if ( f->tags[i].tag == tag )
+      return &f->tags[i];
+  }
+  if ( f->count == f->max )
+    return NULL;
+
+  f->tags[f->count].tag = tag;
+  return &f->tags[f->count++];
+}
+
+// The tag started over since its last report: it came up from a cold start
+// with a new reset cause, or a power counter went backwards. The timeouts
+// can wrap between two reports, so they don't tell.
+static int restarted(const wisp_health_tag *t, const wisp_health *h)
+{
+  unsigned c;
+
+  if ( h->reset_cause != t->last.reset_cause &&
+       !( h->reset_cause & WISP_HEALTH_RESET_RESUMED ) )
+    return 1;
+  for ( c = 0; c < WISP_HEALTH_COUNTERS; c++ )
+  {
+    if ( c != WISP_HEALTH_TIMEOUTS && ( h->has & t->known & ( 1u << c ) ) &&
+         h->counter[c] < t->counter[c] )
+      return 1;
+  }
+  return 0;
+}
+
+int wisp_health_fleet_put(wisp_health_fleet *f, unsigned long tag,
+                          const wisp_payload_header *hdr,
+                          const unsigned char *data, size_t len)
+{
+  wisp_health_tag *t;
+  wisp_health h;
+  unsigned long *total[WISP_HEALTH_COUNTERS];
+  unsigned c;
+
+  if ( hdr->type != WISP_HEALTH_TYPE || wisp_health_decode(data, len, &h) )
+    return -1;
+  if ( (t = find_tag(f, tag)) == NULL )
+    return -1;
+
+  if ( t->used )
+  {
+    unsigned short step = (unsigned short)(hdr->first - t->last_hdr.first);
+
+    if ( hdr->seq == t->last_hdr.seq && step == 0 )
+    {
+      t->duplicates++;
+      return 0;
+    }
+
+    if ( restarted(t, &h) )
+    {
+      // everything on the counters happened since the restart, the ones
+      // this report doesn't carry included
+      t->restarts++;
+      t->known = 0;
+      t->restarted = (1u << WISP_HEALTH_COUNTERS) - 1;
+    }
+    else if ( step > 1 && step < 0x8000 )
+      t->missed += step - 1u;
+  }
+  else
+  {
+    t->used = 1;
+    t->vcap_min_mv = h.vcap_mv;
+  }
+
+  // a counter seen for the first time only sets where the next one counts
+  // from
+  total[WISP_HEALTH_SLEEPS] = &t->sleeps;
+  total[WISP_HEALTH_WAKES] = &t->wakes;
+  total[WISP_HEALTH_TIMEOUTS] = &t->timeouts;
+  for ( c = 0; c < WISP_HEALTH_COUNTERS; c++ )
+  {
+    unsigned char bit = (unsigned char)(1u << c);
+
+    if ( !( h.has & bit ) )
+      continue;
+    if ( t->known & bit )
+      *total[c] += (unsigned short)(h.counter[c] - t->counter[c]);
+    else if ( t->restarted & bit )
+      *total[c] += h.counter[c];
+    t->counter[c] = h.counter[c];
+    t->known |= bit;
+    t->restarted &= (unsigned char)~bit;
+  }
+
+  t->reports++;
+  if ( h.vcap_mv < t->vcap_min_mv )
+    t->vcap_min_mv = h.vcap_mv;
+  t->vcap_sum_mv += h.vcap_mv;
+  t->last = h;
+  t->last_hdr = *hdr;
+  return 1;
+}
+
+void wisp_health_metrics_of(const wisp_health_tag *t, unsigned low_vcap_mv,
+                            wisp_health_metrics *m)
+{
+  memset(m, 0, sizeof(*m));
+  m->sleeps_rate = -1;
+  m->wakes_rate = -1;
+  if ( !t->used )
+  {
+    m->verdict = WISP_HEALTH_UNKNOWN;
+    return;
+  }
+
+  m->vcap_mv = t->last.vcap_mv;
+  m->vcap_min_mv = t->vcap_min_mv;
+  m->vcap_avg_mv = (unsigned)(t->vcap_sum_mv / t->reports);
+  m->delivery = (double)t->reports / (double)(t->reports + t->missed);
+  m->restarts = t->restarts;
+  if ( t->timeouts )
+  {
+    m->sleeps_rate = (double)t->sleeps * WISP_HEALTH_PER_TIMEOUTS /
+                     t->timeouts;
+    m->wakes_rate = (double)t->wakes * WISP_HEALTH_PER_TIMEOUTS /
+                    t->timeouts;
+  }
+
+  if ( m->vcap_avg_mv < low_vcap_mv ||
+       m->sleeps_rate > WISP_HEALTH_STARVING_RATE )
+    m->verdict = WISP_HEALTH_STARVING;
+  else if ( m->delivery < 0.5 )
+    m->verdict = WISP_HEALTH_LINK;
+  else
+    m->verdict = WISP_HEALTH_OK;
+}
@@ -0,0 +1,124 @@
+/* See license.txt for license information. */
+
+#ifndef WISP_HEALTH_H
+#define WISP_HEALTH_H
+
+/*
+ * Reader-side decoding of WISP health reports (SENSOR_HEALTH, type 0x13,
+ * health_sensor.h on the tag), and per-tag metrics for a fleet dashboard.
+ *
+ * Feed every payload of type WISP_HEALTH_TYPE to wisp_health_fleet_put()
+ * with an id for the tag it came from (the WISP ID from the EPC, see
+ * wisp_stream.h). Repeats of the same report are dropped; reports that never
+ * made it show up as gaps in the payload index. A report carries Vcap and
+ * the reset cause, and some of the counters: one in the EPC, the tag going
+ * round them from one report to the next. wisp_health_metrics_of() then
+ * says, per tag, how low its supply runs, how often it browns out, how many
+ * reports get through, and whether it looks starved for power or short of
+ * link.
+ *
+ * Plain C, no allocation: the caller hands over the table of tags.
+ */
+
+#include <stddef.h>
+#include "wisp_stream.h"
+
+#define WISP_HEALTH_TYPE          0x13
+
+// the counters, HEALTH_x on the tag
+#define WISP_HEALTH_SLEEPS        0     // power-fail sleeps since cold start
+#define WISP_HEALTH_WAKES         1     // power-good wakeups since cold start
+#define WISP_HEALTH_TIMEOUTS      2     // main-loop timeouts since cold start
+#define WISP_HEALTH_COUNTERS      3
+
+// VSENSE_FULL_SCALE_MV in the tag's dlwisp41.h
+#define WISP_HEALTH_FULL_SCALE_MV 3000
+
+// reset cause bits
+#define WISP_HEALTH_RESET_WDT     0x01
+#define WISP_HEALTH_RESET_POR     0x04
+#define WISP_HEALTH_RESET_PIN     0x08
+#define WISP_HEALTH_RESET_NMI     0x10
+#define WISP_HEALTH_RESET_RESUMED 0x80
+
+// The rates below count per 1000 timeouts. A timeout is the tag's one clock
+// in every configuration, but not a fixed one: they come as often as the
+// reader keeps the tag busy (plus its sample clock or scheduler wakeups,
+// if it has them), so these are rates per reader round rather than per
+// second.
+#define WISP_HEALTH_PER_TIMEOUTS  1000
+
+// More power-fail sleeps than this per 1000 timeouts counts as starving.
+#define WISP_HEALTH_STARVING_RATE 1
+
+typedef struct {
+  unsigned char reset_cause;
+  unsigned vcap_mv;
+  unsigned char has;            // counters carried, 1 << WISP_HEALTH_x
+  unsigned short counter[WISP_HEALTH_COUNTERS];   // mod 2^16
+} wisp_health;
+
+typedef struct {
+  unsigned long tag;
+  int used;
+
+  unsigned long reports;        // reports received
+  unsigned long missed;         // reports that never arrived
+  unsigned long duplicates;
+  unsigned long restarts;       // cold starts seen between reports
+  unsigned long sleeps;         // power-fail sleeps, all reports together
+  unsigned long wakes;
+  unsigned long timeouts;       // main-loop timeouts on the tag
+  unsigned vcap_min_mv;
+  unsigned long vcap_sum_mv;
+
+  wisp_health last;
+  wisp_payload_header last_hdr;
+  unsigned short counter[WISP_HEALTH_COUNTERS];   // latest of each
+  unsigned char known;          // counters with a latest value
+  unsigned char restarted;      // and ones that start from 0 at a restart
+} wisp_health_tag;
+
+typedef struct {
+  wisp_health_tag *tags;
+  size_t max;
+  size_t count;
+} wisp_health_fleet;
+
+enum {
+  WISP_HEALTH_UNKNOWN,          // nothing heard yet
+  WISP_HEALTH_OK,
+  WISP_HEALTH_STARVING,         // supply low, or browning out often
+  WISP_HEALTH_LINK              // powered fine, but reports go missing
+};
+
+typedef struct {
+  unsigned vcap_mv;             // last report
+  unsigned vcap_min_mv;
+  unsigned vcap_avg_mv;
+  double sleeps_rate;           // per WISP_HEALTH_PER_TIMEOUTS timeouts; -1
+  double wakes_rate;            // until the tag has counted any
+  double delivery;              // fraction of reports that arrived
+  unsigned long restarts;
+  int verdict;                  // WISP_HEALTH_x
+} wisp_health_metrics;
+
+// Decode the bytes after the payload header. Returns 0, or -1 if len is too
+// short or the counters are out of range.
+int wisp_health_decode(const unsigned char *data, size_t len, wisp_health *h);
+
+void wisp_health_fleet_init(wisp_health_fleet *f, wisp_health_tag *tags,
+                            size_t max);
+
+// Add one report from tag. Returns 1 if it was new, 0 if it was a repeat,
+// -1 if it's malformed or the table is full.
+int wisp_health_fleet_put(wisp_health_fleet *f, unsigned long tag,
+                          const wisp_payload_header *hdr,
+                          const unsigned char *data, size_t len);
+
+// Metrics for one tag. low_vcap_mv is where the supply counts as starving
+// (ENERGY_VCAP_MIN_MV on the tag is a good start).
+void wisp_health_metrics_of(const wisp_health_tag *t, unsigned low_vcap_mv,
+                            wisp_health_metrics *m);
+
+#endif // WISP_HEALTH_H
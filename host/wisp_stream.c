@@ -0,0 +1,174 @@
+/* See license.txt for license information. */
+
+#include <string.h>
+#include "wisp_stream.h"
+
+int wisp_payload_parse(const unsigned char *payload, size_t len,
+                       wisp_payload_header *hdr)
+{
+  if ( len < WISP_PAYLOAD_HEADER_BYTES )
+    return -1;
+
+  hdr->type = payload[0] & ~WISP_PAYLOAD_NEW;
+  hdr->fresh = (payload[0] & WISP_PAYLOAD_NEW) != 0;
+  hdr->seq = payload[1];
+  hdr->first = (unsigned short)((payload[2] << 8) | payload[3]);
+  return (int)(len - WISP_PAYLOAD_HEADER_BYTES);
+}
+
+void wisp_stream_init(wisp_stream *s, unsigned channels, wisp_emit_fn emit,
+                      void *ctx)
+{
+  memset(s, 0, sizeof(*s));
+  s->channels = channels;
+  s->emit = emit;
+  s->ctx = ctx;
+}
+
+// Emit the frames of a batch that haven't been emitted yet. first <= next.
+static void emit_batch(wisp_stream *s, unsigned long first,
+                       const unsigned short *data, size_t frames)
+{
+  size_t i = (size_t)(s->next - first);
+
+  for ( ; i < frames; i++ )
+  {
+    s->emit(s->ctx, s->next++, data + i * s->channels, s->channels);
+    s->frames++;
+  }
+}
+
+static void emit_gap(wisp_stream *s, unsigned long upto)
+{
+  while ( s->next < upto )
+  {
+    s->emit(s->ctx, s->next++, NULL, s->channels);
+    s->missing++;
+  }
+}
+
+// Oldest held batch, or NULL
+static wisp_stream_slot *oldest(wisp_stream *s)
+{
+  wisp_stream_slot *o = NULL;
+  int i;
+
+  for ( i = 0; i < WISP_STREAM_SLOTS; i++ )
+    if ( s->slot[i].used && (o == NULL || s->slot[i].first < o->first) )
+      o = &s->slot[i];
+  return o;
+}
+
+// Emit held batches for as long as they carry on from next.
+static void drain(wisp_stream *s)
+{
+  wisp_stream_slot *o;
+
+  while ( (o = oldest(s)) != NULL && o->first <= s->next )
+  {
+    if ( o->first + o->frames > s->next )
+      emit_batch(s, o->first, o->data, o->frames);
+    o->used = 0;
+  }
+}
+
+// Give up on the gap in front of the oldest held batch.
+static void skip_gap(wisp_stream *s)
+{
+  wisp_stream_slot *o = oldest(s);
+
+  if ( o != NULL )
+  {
+    emit_gap(s, o->first);
+    drain(s);
+  }
+}
+
+int wisp_stream_put(wisp_stream *s, const wisp_payload_header *hdr,
+                    const unsigned short *samples, size_t frames)
+{
+  unsigned long first;
+  int held = 0;
+  int i;
+
+  if ( frames * s->channels > WISP_STREAM_MAX_SAMPLES )
+    return -1;
+
+  // the same EPC reported again
+  if ( s->started && hdr->seq == s->last.seq && hdr->first == s->last.first )
+  {
+    s->duplicates++;
+    return 0;
+  }
+  s->last = *hdr;
+
+  if ( !s->started )
+  {
+    s->started = 1;
+    s->next = hdr->first;
+  }
+
+  // unwrap the 16-bit index to the one nearest next
+  first = s->next + (long)(short)(unsigned short)(hdr->first - s->next);
+
+  // already emitted, or already waiting
+  if ( first + frames <= s->next )
+  {
+    s->duplicates++;
+    return 0;
+  }
+  for ( i = 0; i < WISP_STREAM_SLOTS; i++ )
+  {
+    if ( s->slot[i].used )
+    {
+      if ( s->slot[i].first == first )
+      {
+        s->duplicates++;
+        return 0;
+      }
+      held = 1;
+    }
+  }
+
+  s->batches++;
+
+  if ( first <= s->next )
+  {
+    if ( held )
+      s->reordered++;
+    emit_batch(s, first, samples, frames);
+    drain(s);
+    return 1;
+  }
+
+  // past a gap: hold it back, making room if we have to
+  for ( ;; )
+  {
+    for ( i = 0; i < WISP_STREAM_SLOTS; i++ )
+    {
+      if ( !s->slot[i].used )
+      {
+        s->slot[i].used = 1;
+        s->slot[i].first = first;
+        s->slot[i].frames = frames;
+        memcpy(s->slot[i].data, samples,
+               frames * s->channels * sizeof(samples[0]));
+        return 1;
+      }
+    }
+    skip_gap(s);
+    if ( first <= s->next )
+    {
+      // that caught up with this one
+      emit_batch(s, first, samples, frames);
+      drain(s);
+      return 1;
+    }
+  }
+}
+
+void wisp_stream_flush(wisp_stream *s)
+{
+  while ( oldest(s) != NULL )
+    skip_gap(s);
+}
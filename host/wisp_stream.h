@@ -0,0 +1,96 @@
+/* See license.txt for license information. */
+
+#ifndef WISP_STREAM_H
+#define WISP_STREAM_H
+
+/*
+ * Reader-side reassembly of WISP sample batches into one continuous series.
+ *
+ * Every sensor payload starts with a four-byte header (payload.h on the tag):
+ * sensor type, batch sequence number, and the 16-bit index of the first
+ * sample. A reader reports the same EPC over and over, reads go missing, and
+ * reports can arrive out of order. Feed every payload to wisp_stream_put()
+ * (after decoding the samples with wisp_unpack() or wisp_ecg_decode()) and
+ * the emit callback gets each frame exactly once, in index order, with a
+ * NULL frame for every index no batch covered. A batch that arrives past a
+ * gap is held back in case the gap gets filled; once WISP_STREAM_SLOTS
+ * batches are waiting, the gap is given up on.
+ *
+ * Indexes are unwrapped to 32 bits, so a stream can run past 2^16 samples as
+ * long as no gap is longer than 2^15. A tag that loses power starts its
+ * indexes over, so start a new stream when that happens. One stream per tag
+ * and sensor type: a tag built with several sensors (sensors.h) interleaves
+ * their payloads, each with its own indexes, so route them by hdr.type.
+ * Nothing is allocated.
+ *
+ * In the EPC the payload takes the first WISP_EPC_PAYLOAD_BYTES; the WISP
+ * version and the WISP ID follow it, and the ID is what tells the tags, and
+ * so the streams, apart.
+ */
+
+#include <stddef.h>
+
+#define WISP_PAYLOAD_HEADER_BYTES 4
+#define WISP_PAYLOAD_NEW          0x80  // in the type byte, REPORT_ON_CHANGE
+#define WISP_STREAM_SLOTS         8     // batches held back for reordering
+
+// byte offsets in a 12-byte EPC
+#define WISP_EPC_PAYLOAD_BYTES    9     // header and sensor data
+#define WISP_EPC_VERSION          9
+#define WISP_EPC_ID               10    // two bytes, MSB first
+#define WISP_STREAM_MAX_SAMPLES   64    // per batch, all channels
+
+typedef struct {
+  unsigned char type;       // sensor type ID
+  unsigned char fresh;      // PAYLOAD_NEW was set: not yet seen in an ACK
+  unsigned char seq;        // batch sequence number
+  unsigned short first;     // index of the first sample
+} wisp_payload_header;
+
+// Called once per index. frame holds channels samples, or is NULL if the
+// index was missed.
+typedef void (*wisp_emit_fn)(void *ctx, unsigned long index,
+                             const unsigned short *frame, unsigned channels);
+
+typedef struct {
+  unsigned long first;
+  size_t frames;
+  int used;
+  unsigned short data[WISP_STREAM_MAX_SAMPLES];
+} wisp_stream_slot;
+
+typedef struct {
+  unsigned channels;
+  wisp_emit_fn emit;
+  void *ctx;
+
+  int started;
+  unsigned long next;           // next index to emit
+  wisp_payload_header last;     // last header seen
+  wisp_stream_slot slot[WISP_STREAM_SLOTS];
+
+  // statistics
+  unsigned long batches;        // new batches accepted
+  unsigned long duplicates;     // repeats and batches that came too late
+  unsigned long reordered;      // batches that arrived after a later one
+  unsigned long frames;         // frames emitted with data
+  unsigned long missing;        // frames emitted as NULL
+} wisp_stream;
+
+// Split a payload into header and sample bytes. Returns the number of bytes
+// after the header, or -1 if len is too short.
+int wisp_payload_parse(const unsigned char *payload, size_t len,
+                       wisp_payload_header *hdr);
+
+void wisp_stream_init(wisp_stream *s, unsigned channels, wisp_emit_fn emit,
+                      void *ctx);
+
+// Add one batch of frames (channels samples each, in reply order). Returns 1
+// if it was new, 0 if it was a duplicate, -1 if it's too big.
+int wisp_stream_put(wisp_stream *s, const wisp_payload_header *hdr,
+                    const unsigned short *samples, size_t frames);
+
+// Emit everything held back, gaps and all. Call at the end of a session.
+void wisp_stream_flush(wisp_stream *s);
+
+#endif // WISP_STREAM_H
@@ -0,0 +1,51 @@
+/* See license.txt for license information. */
+
+#include "wisp_unpack.h"
+
+size_t wisp_packed_bytes(size_t n, unsigned bits)
+{
+  if ( bits == 0 )
+    return n * 2;
+  return (n * bits + 7) / 8;
+}
+
+size_t wisp_unpack(const unsigned char *payload, size_t len, unsigned bits,
+                   unsigned short *out, size_t n)
+{
+  size_t used = wisp_packed_bytes(n, bits);
+  size_t i;
+
+  if ( bits > 16 || used > len )
+    return 0;
+
+  if ( bits == 0 )
+  {
+    // two bytes per sample, MSB first
+    for ( i = 0; i < n; i++ )
+      out[i] = (unsigned short)(((payload[2*i] & 0x03) << 8) | payload[2*i+1]);
+    return used;
+  }
+
+  // samples run MSB first across byte boundaries; the inverse of
+  // pack_samples() on the tag
+  {
+    unsigned long acc = 0;
+    unsigned count = 0;
+    const unsigned char *p = payload;
+
+    for ( i = 0; i < n; i++ )
+    {
+      while ( count < bits )
+      {
+        acc = (acc << 8) | *p++;
+        count += 8;
+      }
+      count -= bits;
+      out[i] = (unsigned short)((acc >> count) & ((1ul << bits) - 1));
+      if ( bits < 10 )
+        out[i] <<= 10 - bits;
+    }
+  }
+
+  return used;
+}
@@ -0,0 +1,28 @@
+/* See license.txt for license information. */
+
+#ifndef WISP_UNPACK_H
+#define WISP_UNPACK_H
+
+/*
+ * Reader-side decoding of WISP sensor payloads: the bytes after the payload
+ * header (see wisp_stream.h) in the EPC or the Read reply.
+ * Plain C, no dependencies; build it into whatever talks to the reader.
+ *
+ * bits is PACKED_SAMPLE_BITS from the tag's mywisp.h, or 0 if the tag was
+ * built without PACKED_SAMPLES (two bytes per sample). Samples come back
+ * scaled to 10 bits either way, so readings at different resolutions
+ * compare directly. The oversampled accelerometer packs its readings the
+ * same way at OVERSAMPLE_BITS (12); bits above 10 come back as they are.
+ */
+
+#include <stddef.h>
+
+// Payload bytes taken up by n samples (PACKED_BYTES() on the tag).
+size_t wisp_packed_bytes(size_t n, unsigned bits);
+
+// Decode n samples from payload into out. Returns the number of payload bytes
+// used, or 0 if len is too short or bits is out of range.
+size_t wisp_unpack(const unsigned char *payload, size_t len, unsigned bits,
+                   unsigned short *out, size_t n);
+
+#endif // WISP_UNPACK_H
@@ -49,12 +49,23 @@
 #if(WISP_VERSION != BLUE_WISP)
   #error "WISP Version not supported"
 #endif
+#include "dlwisp41.h"
 #include "rfid.h"
 
 /*******************************************************************************
  *****************  Edit mywisp.h to configure this WISP  **********************
  ******************************************************************************/
 #include "mywisp.h"
+#include "sampler.h"
+#include "ecg_clock.h"
+#include "qrs.h"
+#include "payload.h"
+#include "sched.h"
+#include "energy.h"
+#include "i2c.h"
+#include "archive.h"
+#include "user_bank.h"
+#include "checkpoint.h"
 
 // as per mapping in monitor code
 #define wisp_debug_1                  DEBUG_1_4   // P1.4
@@ -101,11 +112,71 @@ unsigned char session_table[] = {
 #endif // ENABLE_SESSIONS
 int i;
 
+#if ENABLE_FAST_RESUME
+// Written just before we go to sleep waiting for power-good, and cleared once
+// we are listening again. If a brownout reset hits in between, RAM is still
+// ours and we can pick up where we left off. __no_init so the C startup code
+// doesn't touch them.
+#define RESUME_KEY                    0xC0DE
+__no_init unsigned short resume_key;
+__no_init unsigned short resume_key_inv;
+__no_init unsigned char fast_resumed;
+unsigned short fast_resume_count = 0;
+
+// Called by the IAR C startup code before RAM is initialized. Returning 0
+// skips the data/bss initialization.
+int __low_level_init(void)
+{
+  WDTCTL = WDTPW + WDTHOLD;            // Stop Watchdog Timer
+
+  fast_resumed = ( resume_key == RESUME_KEY &&
+                   resume_key_inv == (unsigned short)~RESUME_KEY );
+  resume_key = 0;
+  resume_key_inv = 0;
+
+  return !fast_resumed;
+}
+#endif // ENABLE_FAST_RESUME
+
+#if MEASURE_LISTEN_LATENCY
+// SMCLK cycles from power-good to the first setup_to_receive() after it. Timer_A
+// free-runs in between; setup_to_receive() stops the count before it
+// reprograms the timer. 0xFFFF means the timer overflowed.
+unsigned short listen_latency = 0;
+unsigned char listen_latency_pending = 0;
+#define LISTEN_LATENCY_START \
+  do { \
+    TACTL = TASSEL1 + MC1 + TACLR; \
+    listen_latency_pending = 1; \
+  } while (0)
+#define LISTEN_LATENCY_STOP \
+  do { \
+    if ( listen_latency_pending ) \
+    { \
+      listen_latency = ( TACTL & TAIFG ) ? 0xFFFF : TAR; \
+      listen_latency_pending = 0; \
+    } \
+  } while (0)
+#else
+#define LISTEN_LATENCY_START          do { } while (0)
+#define LISTEN_LATENCY_STOP           do { } while (0)
+#endif
+
 int main(void)
 {
   //*******************************Timer setup**********************************
   WDTCTL = WDTPW + WDTHOLD;            // Stop Watchdog Timer
 
+#if HEALTH_PERIOD
+  // what got us here (see health_sensor.h)
+  health_reset_cause = IFG1 & (WDTIFG | PORIFG | RSTIFG | NMIIFG);
+  IFG1 &= ~(WDTIFG | PORIFG | RSTIFG | NMIIFG);
+#if ENABLE_FAST_RESUME
+  if ( fast_resumed )
+    health_reset_cause |= HEALTH_RESET_RESUMED;
+#endif
+#endif
+
   P1SEL = 0;
   P2SEL = 0;
 
@@ -118,6 +189,10 @@ int main(void)
   // Check power on bootup, decide to receive or sleep.
   if(!is_power_good())
     sleep();
+  else
+  {
+    LISTEN_LATENCY_START;
+  }
 
   RECEIVE_CLOCK;
 
@@ -142,30 +217,12 @@ int main(void)
 #endif
 #endif
 
-#if ENABLE_SLOTS
-  // setup int epc
-  epc = ackReply[2]<<8;
-  epc |= ackReply[3];
-
-  // calculate RN16_1 table
-  for (Q = 0; Q < 16; Q++)
-  {
-    rn16 = epc^Q;
-    lfsr();
-
-    if (Q > 8)
-    {
-      RN16[(Q<<1)-9] = __swap_bytes(rn16);
-      RN16[(Q<<1)-8] = rn16;
-    }
-    else
-    {
-      RN16[Q] = rn16;
-    }
-  }
-#endif
+  // The RN16 table and the reply CRCs are built at compile time (see
+  // boot_tables.h), so there's nothing to compute before we can listen.
 
+#if !MEASURE_LISTEN_LATENCY
   TACTL = 0;
+#endif
 
 //  P1IES &= ~BIT2; // initial state is POS edge to find start of CW
 //  P1IFG = 0x00;       // clear interrupt flag after changing edge trigger
@@ -173,29 +230,59 @@ int main(void)
   asm("MOV #0000h, R9");
   // dest = destorig;
 
+#if ARCHIVE_SAMPLES
+  init_eeprom();
+  user_bank_init();
+#endif
+
+#if ENABLE_FAST_RESUME
+  // RAM survived a brownout: the sensor is set up, the last sample and its
+  // CRC are still in the reply buffers and the session flags are still valid
+  // (which is what the spec wants for SL and S0 anyway).
+  if ( fast_resumed )
+  {
+    fast_resume_count++;
+  }
+  else
+#endif
+  {
 #if READ_SENSOR
-  init_sensor();
+    sensors_init();
 #endif
 
-#if !(ENABLE_SLOTS)
-  queryReplyCRC = crc16_ccitt(&queryReply[0],2);
-  queryReply[3] = (unsigned char)queryReplyCRC;
-  queryReply[2] = (unsigned char)__swap_bytes(queryReplyCRC);
+#if ARCHIVE_SAMPLES
+    archive_init();
 #endif
 
-#if SENSOR_DATA_IN_ID
-  // this branch is for sensor data in the id
-  ackReply[2] = SENSOR_DATA_TYPE_ID;
-  state = STATE_READ_SENSOR;
-  timeToSample++;
-#else
-  ackReplyCRC = crc16_ccitt(&ackReply[0], 14);
-  ackReply[15] = (unsigned char)ackReplyCRC;
-  ackReply[14] = (unsigned char)__swap_bytes(ackReplyCRC);
+#if CHECKPOINT_STATE
+    // counters and payload from before the power went
+    checkpoint_init();
+    checkpoint_tidy();
+#endif
+
+#if DATA_IN_EPC
+    // this branch is for sensor data in the id
+    state = STATE_READ_SENSOR;
+    timeToSample++;
 #endif
 
 #if ENABLE_SESSIONS
-  initialize_sessions();
+    initialize_sessions();
+#endif
+  }
+
+#if BACKGROUND_SAMPLING
+  // the timer and ADC don't survive a reset, even a fast-resumed one
+  sampler_start();
+#elif ECG_HW_CLOCK
+  ecg_clock_start();
+#elif SCHEDULED_SAMPLING
+  sched_start();
+#endif
+
+#if DCO_CALIBRATION
+  // the crystal the link clocks are measured against (see dco.h)
+  dco_init();
 #endif
 
   //state = STATE_ARBITRATE;
@@ -216,10 +303,29 @@ int main(void)
     // TIMEOUT!  reset timer
     if (TAR > 0x256 || delimiterNotFound)   // was 0x1000
     {
+#if I2C_IN_IMAGE
+      // The I2C engine wakes us just to start its next transfer, which
+      // setup_to_receive() does. That isn't a timeout, so it doesn't count
+      // towards sampling, slots or DCO tracking; anything else that woke us
+      // at the same time is still seen to.
+      unsigned char timeout = delimiterNotFound || !i2c_woke;
+
+      i2c_woke = 0;
+#else
+      const unsigned char timeout = 1;
+#endif
+
       if(!is_power_good()) {
         sleep();
       }
 
+#if COMM_STATS_PERIOD
+      // only if a command had started; the sample clocks and the scheduler
+      // wake us here too, with nothing received
+      if (!delimiterNotFound && bits != 0)
+        COMM_COUNT(COMM_TIMEOUTS);
+#endif
+
 #if MONITOR_DEBUG_ON
       // for monitor - set TAR OVERFLOW debug line - 00111 - 7
       if (!delimiterNotFound)
@@ -231,14 +337,49 @@ int main(void)
       }
 #endif
 
-#if SENSOR_DATA_IN_ID
+#if REPORT_ON_CHANGE
+      // the last ACK reply carried a fresh payload; it isn't fresh any more
+      if ( payload_acked )
+        payload_delivered();
+#endif
+
+#if ECG_FILTER
+      // the sample clock wakes us for every block, and the filters have to
+      // keep up with it
+      ecg_clock_filter();
+#endif
+
+#if RR_INTERVALS_IN_ID
+      // keep the detector up with the sample clock (which wakes us for it);
+      // the EPC only changes when there's a new beat
+      qrs_run();
+      if ( qrs_pending() ) {
+        state = STATE_READ_SENSOR;
+      }
+#elif (SENSOR_DATA_IN_ID || SENSOR_DATA_IN_READ_COMMAND) && BACKGROUND_SAMPLING
+      // samples arrive on their own clock; just pick them up when there's a
+      // reply's worth waiting
+      if ( sampler_frames() >= SAMPLE_FRAMES_PER_READ ) {
+        state = STATE_READ_SENSOR;
+      }
+#elif (SENSOR_DATA_IN_ID || SENSOR_DATA_IN_READ_COMMAND) && ECG_HW_CLOCK
+      if ( ecg_clock_pending() ) {
+        state = STATE_READ_SENSOR;
+      }
+#elif (SENSOR_DATA_IN_ID || SENSOR_DATA_IN_READ_COMMAND) && SCHEDULED_SAMPLING
+      // the scheduler tick woke us, or a reading came due while we were
+      // busy with the reader
+      if ( sensors_due() ) {
+        state = STATE_READ_SENSOR;
+      }
+#elif SENSOR_DATA_IN_ID
     // this branch is for sensor data in the id
-      if ( timeToSample++ == 10 ) {
+      if ( timeout && timeToSample++ == 10 ) {
         state = STATE_READ_SENSOR;
         timeToSample = 0;
       }
 #elif SENSOR_DATA_IN_READ_COMMAND
-      if ( timeToSample++ == 10 ) {
+      if ( timeout && timeToSample++ == 10 ) {
         state = STATE_READ_SENSOR;
         timeToSample = 0;
       }
@@ -260,14 +401,29 @@ int main(void)
 #endif
 
 #if ENABLE_SESSIONS
-    handle_session_timeout();
+    if ( timeout )
+      handle_session_timeout();
 #endif
 
 #if ENABLE_SLOTS
-    if (shift < 4)
-        shift += 1;
-    else
-        shift = 0;
+    if ( timeout )
+    {
+      if (shift < 4)
+          shift += 1;
+      else
+          shift = 0;
+    }
+#endif
+
+#if DCO_CALIBRATION
+    // keep the link clocks where they should be for Vcap and temperature
+    if ( timeout )
+      dco_track();
+#endif
+
+#if HEALTH_PERIOD
+    if ( timeout )
+      health_timeouts++;
 #endif
 
       setup_to_receive();
@@ -329,6 +485,7 @@ int main(void)
         else if ( bits >= MAX_NUM_QUERY_BITS && ( ( cmd[0] & 0xF0 ) != 0xA0 ) )
         {
           do_nothing();
+          COMM_COUNT(COMM_DROPPED);
           state = STATE_READY;
           delimiterNotFound = 1;
 
@@ -378,6 +535,7 @@ int main(void)
         {
           //DEBUG_PIN5_HIGH;
           do_nothing();
+          COMM_COUNT(COMM_DROPPED);
           state = STATE_READY;
           delimiterNotFound = 1;
 
@@ -492,7 +650,7 @@ int main(void)
           handle_ack(STATE_ACKNOWLEDGED);
 
           setup_to_receive();
-#elif SENSOR_DATA_IN_ID
+#elif DATA_IN_EPC
           handle_ack(STATE_ACKNOWLEDGED);
           delimiterNotFound = 1; // reset
 #else
@@ -622,6 +780,7 @@ int main(void)
         {
           //DEBUG_PIN5_HIGH;
           do_nothing();
+          COMM_COUNT(COMM_DROPPED);
           state = STATE_READY;
           delimiterNotFound = 1;
           //DEBUG_PIN5_LOW;
@@ -769,8 +928,8 @@ int main(void)
         //////////////////////////////////////////////////////////////////////
         // process the READ command
         //////////////////////////////////////////////////////////////////////
-        // warning: won't work for read addrs > 127d
-        if ( bits == NUM_READ_BITS && ( cmd[0] == 0xC2 ) )
+        // warning: won't work for read addrs > 127d, but in the User bank
+        if ( bits == USER_BANK_READ_BITS && ( cmd[0] == 0xC2 ) )
         {
           //DEBUG_PIN5_HIGH;
           handle_read(STATE_ARBITRATE);
@@ -791,10 +950,11 @@ int main(void)
           //DEBUG_PIN5_LOW;
         }
 #endif
-        else if ( bits >= MAX_NUM_READ_BITS )
+        else if ( bits >= USER_BANK_MAX_READ_BITS )
         {
           //DEBUG_PIN5_HIGH;
           //do_nothing();
+          COMM_COUNT(COMM_DROPPED);
           state = STATE_ARBITRATE;
           delimiterNotFound = 1 ;
           //DEBUG_PIN5_LOW;
@@ -819,8 +979,8 @@ int main(void)
         //////////////////////////////////////////////////////////////////////
         // process the READ command
         //////////////////////////////////////////////////////////////////////
-        // warning: won't work for read addrs > 127d
-        if ( bits == NUM_READ_BITS  && ( cmd[0] == 0xC2 ) )
+        // warning: won't work for read addrs > 127d, but in the User bank
+        if ( bits == USER_BANK_READ_BITS  && ( cmd[0] == 0xC2 ) )
         {
           //DEBUG_PIN5_HIGH;
           handle_read(STATE_OPEN);
@@ -904,18 +1064,38 @@ int main(void)
 
     case STATE_READ_SENSOR:
       {
-#if SENSOR_DATA_IN_READ_COMMAND
-        read_sensor(&readReply[0]);
-        // crc is computed in the read state
-        RECEIVE_CLOCK;
-        state = STATE_READY;
-        delimiterNotFound = 1; // reset
-#elif SENSOR_DATA_IN_ID
-        read_sensor(&ackReply[3]);
+#if SENSOR_DATA_IN_READ_COMMAND || DATA_IN_EPC
+        // sensor data first, then the header in front of it (see payload.h).
+        // Nothing new (a sampler gap, or an unchanged reading with
+        // REPORT_ON_CHANGE) leaves the payload and its CRC as they are.
+        unsigned short first;
+        unsigned char fresh;
+        unsigned char type = SENSOR_DATA_TYPE_ID;
+#if RR_INTERVALS_IN_ID
+        first = qrs_read(PAYLOAD_DATA);
+        fresh = 1;
+#elif BACKGROUND_SAMPLING
+        fresh = sampler_read(PAYLOAD_DATA, SAMPLE_FRAMES_PER_READ, &first);
+#elif ECG_HW_CLOCK
+        first = ecg_clock_read(PAYLOAD_DATA);
+        fresh = 1;
+#else
+        fresh = sensors_read(PAYLOAD_DATA, &type, &first);
+#endif
         RECEIVE_CLOCK;
-        ackReplyCRC = crc16_ccitt(&ackReply[0], 14);
-        ackReply[15] = (unsigned char)ackReplyCRC;
-        ackReply[14] = (unsigned char)__swap_bytes(ackReplyCRC);
+        if ( fresh )
+        {
+          payload_header(PAYLOAD_START, type, first);
+#if DATA_IN_EPC
+          ackReplyCRC = crc16_ccitt(&ackReply[0], 14);
+          ackReply[15] = (unsigned char)ackReplyCRC;
+          ackReply[14] = (unsigned char)__swap_bytes(ackReplyCRC);
+#endif
+#if ARCHIVE_SAMPLES
+          archive_put(PAYLOAD_START, PAYLOAD_BYTES);
+#endif
+        }
+        // in Read mode the crc is computed in the read state
         state = STATE_READY;
         delimiterNotFound = 1; // reset
 #endif
@@ -938,6 +1118,8 @@ inline void setup_to_receive()
   _BIC_SR(GIE); // temporarily disable GIE so we can sleep and enable interrupts
                 // at the same time
 
+  LISTEN_LATENCY_STOP;
+
   P1OUT |= RX_EN_PIN;
 
   delimiterNotFound = 0;
@@ -967,12 +1149,40 @@ inline void setup_to_receive()
   P1IFG = 0;  // Clear interrupt flag
 
   P1IE  |= RX_PIN; // Enable Port1 interrupt
+
+#if TICK_HELD_WHILE_RECEIVING
+  // Port1_ISR held the tick off through the last command; one that came
+  // meanwhile runs as soon as GIE is back on
+  TA1CCTL0 |= CCIE;
+#endif
+
+#if I2C_IN_IMAGE
+  if ( I2C_BUSY )
+  {
+    // the I2C engine runs off SMCLK. That keeps Timer_A counting while we
+    // wait, so don't let it overflow into TimerA1_ISR.
+    i2c_listen();
+    TACTL &= ~TAIE;
+    _BIS_SR(LPM0_bits | GIE);
+    return;
+  }
+#endif
+
+#if ACLK_WHILE_LISTENING
+  _BIS_SR(LPM3_bits | GIE); // keep ACLK running (sample clocks, dco.h)
+#else
   _BIS_SR(LPM4_bits | GIE);
+#endif
   return;
 }
 
 inline void sleep()
 {
+#if CHECKPOINT_STATE
+  // in case the cap drains all the way this time
+  checkpoint_save();
+#endif
+
   P1OUT &= ~RX_EN_PIN;
 
 #if MONITOR_DEBUG_ON
@@ -998,8 +1208,40 @@ inline void sleep()
   if (is_power_good())
     P2IFG = VOLTAGE_SV_PIN;
 
+#if BACKGROUND_SAMPLING
+  // no point spending what's left in the cap on samples
+  sampler_stop();
+#elif ECG_HW_CLOCK
+  ecg_clock_stop();
+#endif
+
+#if HEALTH_PERIOD
+  health_sleeps++;
+#endif
+
+#if ENABLE_FAST_RESUME
+  // if we brown out from here on, RAM is still good enough to resume from
+  resume_key = RESUME_KEY;
+  resume_key_inv = (unsigned short)~RESUME_KEY;
+#endif
+
   _BIS_SR(LPM4_bits | GIE);
 
+#if ENABLE_FAST_RESUME
+  resume_key = 0;
+  resume_key_inv = 0;
+#endif
+
+#if CHECKPOINT_STATE
+  checkpoint_tidy();      // while there's power for an erase
+#endif
+
+#if BACKGROUND_SAMPLING
+  sampler_start();
+#elif ECG_HW_CLOCK
+  ecg_clock_start();
+#endif
+
 //  P1OUT |= RX_EN_PIN;
   return;
 }
@@ -1009,6 +1251,35 @@ unsigned short is_power_good()
   return P2IN & VOLTAGE_SV_PIN;
 }
 
+#if ENERGY_POLICY || HEALTH_PERIOD || DCO_CALIBRATION
+// Measure the storage cap through the VSENSE divider. Returns ADC counts,
+// full scale VSENSE_FULL_SCALE_MV.
+unsigned short vcap_read()
+{
+  unsigned short v;
+
+  // power the divider, and give it and the reference time to settle
+  P3OUT |= VSENSE_POWER;
+  ADC10AE0 |= VSENSE_IN;
+  ADC10CTL0 &= ~ENC; // make sure this is off otherwise settings are locked.
+  ADC10CTL1 = INCH_VSENSE_IN + ADC10DIV_3;
+  ADC10CTL0 = SREF_1 + ADC10SHT_3 + REFON + ADC10ON;
+  for (int k = 0; k < 50; k++);
+
+  ADC10CTL0 |= ENC + ADC10SC;
+  while (ADC10CTL1 & ADC10BUSY);
+  v = ADC10MEM;
+
+  ADC10CTL0 &= ~ENC;
+  ADC10CTL1 = 0;       // turn adc off
+  ADC10CTL0 = 0;       // turn adc off
+  ADC10AE0 &= ~VSENSE_IN;
+  P3OUT &= ~VSENSE_POWER;
+
+  return v;
+}
+#endif
+
 
 //*************************************************************************
 //************************ PORT 2 INTERRUPT *******************************
@@ -1027,7 +1298,11 @@ __interrupt void Port2_ISR(void)   // (5-6 cycles) to enter interrupt
   TACCTL0 = 0;
   TACCTL1 = 0;
   TAR = 0;
+  LISTEN_LATENCY_START;
   state = STATE_READY;
+#if HEALTH_PERIOD
+  health_wakes++;
+#endif
   LPM4_EXIT;
 }
 
@@ -1084,12 +1359,19 @@ __interrupt void Port1_ISR(void)   // (5-6 cycles) to enter interrupt
       "BIS #8010h, TACCTL1\n"     // (5 cycles)   TACCTL1 |= CM1 + CCIE
 #endif
       "MOV #0004h, P1SEL\n"       // enable TimerA1    (4 cycles)
+#if COMM_STATS_PERIOD
+      // after the capture is armed, so it costs the first bit nothing
+      "INC &comm_stats\n"         // comm_stats[COMM_DELIMITERS]++ (4 cycles)
+#endif
       "RETI\n"
 
       "delimiter_Value_Is_wrong:\n"
       "BIC #0004h, P1IES\n"
       "MOV #0000h, R5\n"          // bits = 0  (1 cycles)
       "MOV #0001h, &delimiterNotFound\n"
+#if COMM_STATS_PERIOD
+      "INC &comm_stats+2\n"       // comm_stats[COMM_BAD_DELIMITERS]++
+#endif
       "RETI\n"
 
       "bit_Is_Zero_In_Port_Int:\n"                 // bits == 0
@@ -1100,6 +1382,13 @@ __interrupt void Port1_ISR(void)   // (5-6 cycles) to enter interrupt
       "MOV #0000h, TAR\n"     // reset timer (4 cycles)
 #endif
       "BIS #0004h, P1IES\n"   // 4 cycles  change port interrupt edge to neg
+#if I2C_IN_IMAGE
+      "BIC.B #000Ch, &IE2\n"  // 5 cycles  hold the I2C engine off (i2c.h)
+      "BIC.B #0008h, &UCB0I2CIE\n"  // 5 cycles  and its NACK interrupt
+#endif
+#if TICK_HELD_WHILE_RECEIVING
+      "BIC #0010h, &TA1CCTL0\n"  // 5 cycles  and the Timer1_A tick (mywisp.h)
+#endif
       "INC R5\n"            // 1 cycle
       "RETI\n");
 
@@ -1224,6 +1513,12 @@ __interrupt void TimerA1_ISR(void)   // (6 cycles) to enter interrupt
 void sendToReader(volatile unsigned char *data, unsigned char numOfBits)
 {
 
+#if SAMPLING_ON_ACLK
+  // the bit loop below is cycle-counted; hold the sample clock off until the
+  // reply is out
+  _BIC_SR(GIE);
+#endif
+
   SEND_CLOCK;
 
   TACTL &= ~TAIE;
@@ -1589,6 +1884,15 @@ void sendToReader(volatile unsigned char *data, unsigned char numOfBits)
     TACCTL0 = 0;  // DON'T NEED THIS NOP
     RECEIVE_CLOCK;
 
+#if SAMPLING_ON_ACLK
+    _BIS_SR(GIE);
+#endif
+
+#if ENERGY_POLICY
+    energy_replies++;
+#endif
+    COMM_COUNT(COMM_REPLIES);
+
 }
 
 
@@ -1620,16 +1924,19 @@ unsigned short crc16_ccitt(volatile unsigned char *data, unsigned short n) {
   return(crc_16^0xffff);
 }
 
-void crc16_ccitt_readReply(unsigned int numDataBytes)
+// reply holds numDataBytes of data, then the handle; the CRC and a spare byte
+// go after them. The first 19 bytes get shifted, so it needs at least those.
+void crc16_ccitt_readReply(volatile unsigned char *reply,
+                           unsigned int numDataBytes)
 {
 
   // shift everything over by 1 to accomodate leading "0" bit.
   // first, grab address of beginning of array
-  readReply[numDataBytes + 2] = 0; // clear out this spot for the loner bit of
-                                   // handle
-  readReply[numDataBytes + 4] = 0; // clear out this spot for the loner bit of
-                                   // crc
-  bits = (unsigned short) &readReply[0];
+  reply[numDataBytes + 2] = 0; // clear out this spot for the loner bit of
+                               // handle
+  reply[numDataBytes + 4] = 0; // clear out this spot for the loner bit of
+                               // crc
+  bits = (unsigned short) reply;
   // shift all bytes and later use only data + handle
   asm("RRC.b @R5+");
   asm("RRC.b @R5+");
@@ -1652,19 +1959,19 @@ void crc16_ccitt_readReply(unsigned int numDataBytes)
   // store loner bit in array[numDataBytes+2] position
   asm("RRC.b @R5+");
   // make first bit 0
-  readReply[0] &= 0x7f;
+  reply[0] &= 0x7f;
 
   // compute crc on data + handle bytes
-  readReplyCRC = crc16_ccitt(&readReply[0], numDataBytes + 2);
-  readReply[numDataBytes + 4] = readReply[numDataBytes + 2];
+  readReplyCRC = crc16_ccitt(&reply[0], numDataBytes + 2);
+  reply[numDataBytes + 4] = reply[numDataBytes + 2];
   // XOR the MSB of CRC with loner bit.
-  readReply[numDataBytes + 4] ^= __swap_bytes(readReplyCRC); // XOR happens with
-                                                             // MSB of lower
-                                                             // nibble
+  reply[numDataBytes + 4] ^= __swap_bytes(readReplyCRC); // XOR happens with
+                                                         // MSB of lower
+                                                         // nibble
   // Just take the resulting bit, not the whole byte
-  readReply[numDataBytes + 4] &= 0x80;
+  reply[numDataBytes + 4] &= 0x80;
 
-  unsigned short mask = __swap_bytes(readReply[numDataBytes + 4]);
+  unsigned short mask = __swap_bytes(reply[numDataBytes + 4]);
   mask >>= 3;
   mask |= (mask >> 7);
   mask ^= 0x1020;
@@ -1672,8 +1979,8 @@ void crc16_ccitt_readReply(unsigned int numDataBytes)
   // but we don't shift the crc because it should get pushed out by 1 anyway
   readReplyCRC ^= mask;
 
-  readReply[numDataBytes + 3] = (unsigned char) readReplyCRC;
-  readReply[numDataBytes + 2] |= (unsigned char) (__swap_bytes(readReplyCRC) &
+  reply[numDataBytes + 3] = (unsigned char) readReplyCRC;
+  reply[numDataBytes + 2] |= (unsigned char) (__swap_bytes(readReplyCRC) &
           0x7F);
 }
 
@@ -1702,17 +2009,6 @@ unsigned char crc5(volatile unsigned char *buf, unsigned short numOfBits)
 
 #if ENABLE_SLOTS
 
-void lfsr()
-{
-    // calculate LFSR
-    rn16 = (rn16 << 1) | (((rn16 >> 15) ^ (rn16 >> 13) ^
-                (rn16 >> 9) ^ (rn16 >> 8)) & 1);
-    rn16 = rn16 & 0xFFFF;
-
-    // fit 2^Q-1
-    rn16 = rn16>>(15-Q);
-}
-
 inline void loadRN16()
 {
 #if 1
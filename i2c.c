@@ -0,0 +1,208 @@
+/* See license.txt for license information. */
+
+#include "dlwisp41.h"
+#include "mywisp.h"
+#include "i2c.h"
+
+#if I2C_IN_IMAGE
+
+#define I2C_DATA_IE               (UCB0TXIE | UCB0RXIE)
+
+i2c_request * volatile i2c_queue = 0;
+volatile unsigned char i2c_woke = 0;
+
+static i2c_request *i2c_last;           // end of the queue
+static unsigned char i2c_running = 0;   // i2c_queue is on the bus
+static unsigned char i2c_ie = 0;        // data interrupt the transfer needs
+static unsigned char i2c_waiting = 0;   // i2c_wait() is asleep
+static unsigned short i2c_pos;          // bytes of this phase so far
+static unsigned short i2c_rx_len;       // bytes to clock in
+
+// Also after a fast resume: requests queued before the reset are gone.
+void i2c_init()
+{
+  i2c_queue = 0;
+  i2c_running = 0;
+  i2c_ie = 0;
+  i2c_waiting = 0;
+  i2c_woke = 0;
+
+  P3SEL |= 0x06;                        // Assign I2C pins to USCI_B0
+  UCB0CTL1 |= UCSWRST;                  // Enable SW reset
+  UCB0CTL0 = UCMST + UCMODE_3 + UCSYNC; // I2C master, synchronous mode
+  UCB0CTL1 = UCSSEL_2 + UCSWRST;        // Use SMCLK, keep SW reset
+  UCB0BR0 = 12;                         // fSCL = SMCLK/12 = ~100kHz
+  UCB0BR1 = 0;
+  UCB0CTL1 &= ~UCSWRST;                 // Clear SW reset, resume operation
+  UCB0I2CIE = UCNACKIE;
+}
+
+// Repeated start (or start) in receive mode. The STOP has to be set while
+// the last byte comes in, which for a single byte means polling UCTXSTT
+// through the address; read a second byte instead and drop it.
+static void i2c_receive(i2c_request *r)
+{
+  i2c_pos = 0;
+  i2c_rx_len = (r->len < 2) ? 2 : r->len;
+  UCB0CTL1 &= ~UCTR;
+  UCB0CTL1 |= UCTXSTT;
+  IFG2 &= ~UCB0TXIFG;
+  i2c_ie = UCB0RXIE;
+  IE2 = (IE2 & ~I2C_DATA_IE) | i2c_ie;
+}
+
+static void i2c_start(i2c_request *r)
+{
+  i2c_running = 1;
+  i2c_pos = 0;
+  UCB0STAT &= ~UCNACKIFG;               // a late one from the last transfer
+  UCB0I2CSA = r->slave;
+
+  if ( r->read && r->head_len == 0 )
+  {
+    i2c_receive(r);
+  }
+  else
+  {
+    UCB0CTL1 |= UCTR + UCTXSTT;
+    i2c_ie = UCB0TXIE;
+    IE2 = (IE2 & ~I2C_DATA_IE) | i2c_ie;
+  }
+}
+
+// Main loop only, interrupts off. The STOP of the last transfer takes up to
+// a byte time to go out; interrupts don't wait for it, so they leave the
+// next start to us.
+static void i2c_kick()
+{
+  if ( i2c_queue && !i2c_running )
+  {
+    while ( UCB0CTL1 & UCTXSTP );
+    i2c_start(i2c_queue);
+  }
+}
+
+// Let the interrupts Port1_ISR held off go again.
+static void i2c_unmask()
+{
+  IE2 |= i2c_ie;
+  UCB0I2CIE |= UCNACKIE;
+}
+
+void i2c_submit(i2c_request *r)
+{
+  r->status = I2C_PENDING;
+  r->next = 0;
+
+  _BIC_SR(GIE);
+  if ( i2c_queue )
+    i2c_last->next = r;
+  else
+    i2c_queue = r;
+  i2c_last = r;
+  i2c_kick();
+  _BIS_SR(GIE);
+}
+
+unsigned char i2c_wait(i2c_request *r)
+{
+  _BIC_SR(GIE);
+  while ( r->status == I2C_PENDING )
+  {
+    i2c_kick();
+    i2c_unmask();
+    i2c_waiting = 1;
+    _BIS_SR(LPM0_bits | GIE);           // SMCLK keeps the USCI going
+    _BIC_SR(GIE);
+  }
+  i2c_waiting = 0;
+  _BIS_SR(GIE);
+
+  return r->status;
+}
+
+void i2c_listen()
+{
+  i2c_kick();
+  i2c_unmask();
+}
+
+// Take the running request off the queue. Returns 1 if the main loop has to
+// wake up: for i2c_wait(), or to start the next one, which is all i2c_woke
+// says it was.
+static unsigned char i2c_finish(unsigned char status)
+{
+  i2c_request *r = i2c_queue;
+
+  IE2 &= ~I2C_DATA_IE;
+  i2c_ie = 0;
+  i2c_running = 0;
+  i2c_queue = r->next;
+  r->status = status;
+  if ( r->done )
+    r->done(r);
+
+  if ( i2c_waiting )
+    return 1;
+  if ( i2c_queue )
+    i2c_woke = 1;
+  return ( i2c_queue != 0 );
+}
+
+// In I2C mode both data flags come here; see the family guide.
+#pragma vector=USCIAB0TX_VECTOR
+__interrupt void i2c_data_ISR(void)
+{
+  i2c_request *r = i2c_queue;
+  unsigned char wake = 0;
+
+  if ( IFG2 & UCB0RXIFG )
+  {
+    unsigned char b = UCB0RXBUF;
+
+    if ( i2c_pos < r->len )
+      r->data[i2c_pos] = b;
+    if ( ++i2c_pos == i2c_rx_len - 1 )
+      UCB0CTL1 |= UCTXSTP;              // NACK the next byte, then STOP
+    else if ( i2c_pos == i2c_rx_len )
+      wake = i2c_finish(I2C_DONE);
+  }
+  else if ( i2c_pos < r->head_len )
+  {
+    UCB0TXBUF = r->head[i2c_pos++];
+  }
+  else if ( r->read )
+  {
+    i2c_receive(r);                     // head is out, turn round
+  }
+  else if ( i2c_pos - r->head_len < r->len )
+  {
+    UCB0TXBUF = r->data[i2c_pos - r->head_len];
+    i2c_pos++;
+  }
+  else
+  {
+    UCB0CTL1 |= UCTXSTP;                // after the last byte's ACK
+    IFG2 &= ~UCB0TXIFG;
+    wake = i2c_finish(I2C_DONE);
+  }
+
+  if ( wake )
+    LPM4_EXIT;
+}
+
+// NACK: to the address (EEPROM busy, say) or to a byte
+#pragma vector=USCIAB0RX_VECTOR
+__interrupt void i2c_state_ISR(void)
+{
+  if ( UCB0STAT & UCNACKIFG )
+  {
+    UCB0STAT &= ~UCNACKIFG;
+    UCB0CTL1 |= UCTXSTP;
+    IFG2 &= ~UCB0TXIFG;
+    if ( i2c_running && i2c_finish(I2C_NACK) )
+      LPM4_EXIT;
+  }
+}
+
+#endif // I2C_IN_IMAGE
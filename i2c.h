@@ -0,0 +1,88 @@
+/* See license.txt for license information. */
+
+#ifndef I2C_H
+#define I2C_H
+
+/*
+ * Interrupt-driven I2C master on USCI_B0 (P3.1 SDA, P3.2 SCL).
+ *
+ * Callers fill in an i2c_request and hand it to i2c_submit(), which queues
+ * it and returns at once. The USCI interrupts then run the transfers one
+ * after the other, a byte per interrupt:
+ *
+ *   write  START, slave address + W, head[], data[], STOP
+ *   read   START, slave address + W, head[], repeated START + R, data[],
+ *          STOP; with no head, just START + R
+ *
+ * head carries the memory address for an EEPROM (up to I2C_HEAD_MAX bytes).
+ * To poll a slave for ACK, read one byte with no head: the status says
+ * whether it answered.
+ *
+ * When a transfer is over, status goes to I2C_DONE or I2C_NACK, then done()
+ * is called from the interrupt, if there is one. i2c_wait() sleeps in LPM0
+ * until then. While the queue isn't empty the main loop listens in LPM0
+ * instead of LPM3/4, since the USCI runs off SMCLK.
+ *
+ * Notes:
+ *  - Bit timing on the receive side is measured in the Port1 and Timer0_A
+ *    interrupts, so Port1_ISR holds the I2C interrupts off (data and NACK)
+ *    from the first edge of a reader command; i2c_listen() lets them go
+ *    again once the command is dealt with and the replies are out. The USCI
+ *    stretches SCL meanwhile.
+ *  - An interrupt that comes in right at a delimiter edge can still get the
+ *    delimiter rejected (see comm_stats_sensor.h); the reader sends the
+ *    command again.
+ *  - A STOP takes up to a byte time to go out, and the next transfer has to
+ *    wait for it. The interrupts don't: the next one is started from the
+ *    main loop (i2c_submit(), i2c_wait() or i2c_listen()). A wake for that
+ *    sets i2c_woke, so the main loop doesn't count it as a timeout.
+ *  - Only built with I2C_IN_IMAGE (mywisp.h).
+ *  - Requests belong to the caller and must stay put until they're done.
+ *    Don't touch one while it's queued. Submit and wait from the main loop,
+ *    not from done().
+ */
+
+#include "mywisp.h"
+
+#define I2C_HEAD_MAX              2
+
+#define I2C_IDLE                  0     // not submitted yet
+#define I2C_PENDING               1     // queued or running
+#define I2C_DONE                  2
+#define I2C_NACK                  3     // the slave didn't ACK
+
+typedef struct i2c_request {
+  unsigned char slave;                  // 7-bit address
+  unsigned char read;                   // 1: read into data, 0: write it
+  unsigned char head_len;
+  unsigned char head[I2C_HEAD_MAX];
+  unsigned char *data;
+  unsigned short len;
+  void (*done)(struct i2c_request *r);  // or NULL
+  volatile unsigned char status;        // I2C_x
+  struct i2c_request *next;             // queue link, the engine's
+} i2c_request;
+
+extern i2c_request * volatile i2c_queue; // running request, then the rest
+
+// The engine woke the main loop only to start its next transfer; the main
+// loop clears it and doesn't take the wake for a timeout.
+extern volatile unsigned char i2c_woke;
+
+// Something is queued or running.
+#if I2C_IN_IMAGE
+#define I2C_BUSY                  (i2c_queue != 0)
+#else
+#define I2C_BUSY                  0
+#endif
+
+void i2c_init();
+void i2c_submit(i2c_request *r);
+
+// Sleep in LPM0 until r is done. Returns its status.
+unsigned char i2c_wait(i2c_request *r);
+
+// setup_to_receive() calls this before it sleeps, interrupts off.
+void i2c_listen();
+
+#endif // I2C_H
@@ -1,19 +1,17 @@
 /* See license.txt for license information. */
 #include "mywisp.h"
-#if (ACTIVE_SENSOR == SENSOR_INTERNAL_TEMP)
+#if INT_TEMP_PERIOD
 
 #include "dlwisp41.h"
 #include "rfid.h"
 #include "int_temp_sensor.h"
+#include "payload.h"
 
-unsigned char sensor_busy = 0;
-
-void init_sensor()
-{
-  return;
-}
+#if REPORT_ON_CHANGE
+static unsigned short int_temp_ref[INT_TEMP_DATA_WORDS] = { PAYLOAD_REF_NONE };
+#endif
 
-void read_sensor(unsigned char volatile *target) 
+static unsigned char int_temp_collect(unsigned char volatile *target)
 {
   
 #if MONITOR_DEBUG_ON
@@ -28,12 +26,6 @@ void read_sensor(unsigned char volatile *target)
   BCSCTL1 = XT2OFF + RSEL1; // select internal resistor (still has effect when DCOR=1)
   DCOCTL = DCO1+DCO0; // set DCO step. 
   
-  if(!is_power_good())
-    sleep();
-  
-  // already off. Only needs to be done when READ has set
-  P1OUT &= ~RX_EN_PIN;   // turn off comparator
-  
   // Set up ADC for internal temperature sensor  
   ADC10CTL0 &= ~ENC; // make sure this is off otherwise settings are locked.
   ADC10CTL1 = INCH_10 + ADC10DIV_3;         // Temp Sensor ADC10CLK/4
@@ -49,29 +41,28 @@ void read_sensor(unsigned char volatile *target)
   
   while (ADC10CTL1 & ADC10BUSY);    // wait while ADC finished work
   
-  *(target + k + 1 ) = (ADC10MEM & 0xff);
-  // grab msb bits and store it
-  *(target + k) = (ADC10MEM & 0x0300) >> 8;
+  unsigned short sample = ADC10MEM;
+  unsigned char changed = 1;
+#if REPORT_ON_CHANGE
+  changed = payload_changed(int_temp_ref, &sample, INT_TEMP_DATA_WORDS);
+#endif
+  if ( changed )
+  {
+    *(target + k + 1 ) = (sample & 0xff);
+    // grab msb bits and store it
+    *(target + k) = (sample & 0x0300) >> 8;
+  }
   
   // Power off sensor and adc
   ADC10CTL0 &= ~ENC;
   ADC10CTL1 = 0;       // turn adc off
   ADC10CTL0 = 0;       // turn adc off
   
-  
-  // Store sensor read count
-  sensor_counter++;
-  ackReply[10] = (sensor_counter & 0x00ff);
-  // grab msb bits and store it
-  ackReply[9]  = (sensor_counter & 0xff00) >> 8;
-  
-  return;
+  return changed;
 }
 
-unsigned char is_sensor_sampling()
-{
-  if ( sensor_busy ) return 1;
-  return 0;
-}
+const sensor_driver int_temp_driver = {
+  INT_TEMP_TYPE_ID, INT_TEMP_DATA_BYTES, 0, 0, int_temp_collect
+};
 
-#endif // (ACTIVE_SENSOR == SENSOR_INTERNAL_TEMP)
+#endif // INT_TEMP_PERIOD
@@ -3,6 +3,15 @@
 #ifndef INT_TEMP_SENSOR_H
 #define INT_TEMP_SENSOR_H
 
-#define SENSOR_DATA_TYPE_ID       0x0F
+#define INT_TEMP_TYPE_ID          0x0F
+
+#define INT_TEMP_DATA_WORDS       1
+#define INT_TEMP_DATA_BYTES       (INT_TEMP_DATA_WORDS*2)
+
+extern const sensor_driver int_temp_driver;
+
+#if (ACTIVE_SENSOR == SENSOR_INTERNAL_TEMP)
+#define SENSOR_DATA_TYPE_ID       INT_TEMP_TYPE_ID
+#endif
 
 #endif // INT_TEMP_SENSOR_H
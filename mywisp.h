@@ -11,7 +11,7 @@
 ////////////////////////////////////////////////////////////////////////////////
 // Step 1: Pick an application mode
 //
-// 1(a): Only one of the four application modes below should be selected (set
+// 1(a): Only one of the five application modes below should be selected (set
 //        to 1). Make sure all the others are disabled (set to 0).
 //
 // Simple hardcoded query-ack
@@ -26,6 +26,11 @@
 // Return sampled sensor data in a read command. Returns three words of accel
 // data
 #define SENSOR_DATA_IN_READ_COMMAND   0
+//
+// Like SENSOR_DATA_IN_ID, but the EPC carries recent RR intervals and beat
+// times from an on-tag QRS detector instead of raw samples. Needs SENSOR_ECG
+// and ECG_HW_CLOCK (step 2(e)). See qrs.h.
+#define RR_INTERVALS_IN_ID            0
 ////////////////////////////////////////////////////////////////////////////////
 
 
@@ -60,16 +65,171 @@
 #define SENSOR_EXTERNAL_TEMP          4
 //
 // SENSOR_COMM_STATS(0x0A)
-//  [Not implemented] Get information about the communication link.
+//  Link statistics: delimiters, commands by type, timeouts, drops and
+//  replies, counted on the tag. Reported a few counters at a time, see
+//  comm_stats_sensor.h.
 #define SENSOR_COMM_STATS             5
 //
 // SENSOR_ECG(0x10) <= If that's not right, don't know what is.
-//  External ECG sensor system sampled w/a 10-bit ADC
+//  External ECG sensor system sampled w/a 10-bit ADC. Reports as 0x11 in
+//  RR_INTERVALS_IN_ID mode.
 #define SENSOR_ECG                    6
+//
+// SENSOR_ACCEL_OVERSAMPLED(0x12)
+//  3-axis accelerometer, quick accel's short settle and conversions, but
+//  each axis averaged over a burst of 16 sequences and reported at 12 bits.
+//  Less noise than either, for ~1.5x quick accel's energy per reading. See
+//  oversampled_accel_sensor.c and host/bench/accel_bench.c.
+#define SENSOR_ACCEL_OVERSAMPLED      7
+//
+// SENSOR_HEALTH(0x13)
+//  Tag health: Vcap, reset cause, power-fail, wakeup and timeout counts.
+//  Mostly useful next to another sensor, see 2(j) and health_sensor.h.
+#define SENSOR_HEALTH                 8
 // SENSOR_EXTERN_INPUT
 // 2(b) Change the value of ACTIVE_SENSOR to the desired sensor title 
 //      from the list above:
 #define ACTIVE_SENSOR                 SENSOR_ECG
+//
+// 2(c) Background sampling (accel, quick accel and ECG only). Normally the
+//      sensor is read in the main loop every 10th timeout, so the sample rate
+//      depends on how busy the reader is. With BACKGROUND_SAMPLING enabled a
+//      timer interrupt samples the sensor at a fixed SAMPLE_RATE_HZ into a
+//      ring of SAMPLE_RING_FRAMES frames in RAM, and EPC/Read updates are
+//      taken from there. See sampler.h.
+//
+#define BACKGROUND_SAMPLING           0
+#define SAMPLE_RATE_HZ                250
+#define SAMPLE_RING_FRAMES            16  // power of two, at most 128
+//
+// 2(d) Sample clock source. Set to 1 if the 32.768 kHz watch crystal is fitted
+//      on LFXT1; otherwise the internal VLO is used, which is only good to
+//      about +/-50% (so SAMPLE_RATE_HZ is nominal).
+//
+#define ACLK_FROM_CRYSTAL             0
+//
+// 2(e) Timer-paced ECG sampling (SENSOR_ECG only, not together with
+//      BACKGROUND_SAMPLING). Timer1_A ticks at 250 Hz from ACLK and each
+//      tick starts one conversion of the ECG lead; the DTC stores the
+//      samples in RAM without the CPU, so the sample rate doesn't move with
+//      reader traffic. Each reply carries a batch of ECG_BATCH_SAMPLES
+//      consecutive samples and the index of the first one; in the EPC that
+//      is at most 4 (five bytes, packed at 10 bits, see 2(f)). See
+//      ecg_clock.h. Costs the ADC10 supply current for as long as the tag is
+//      awake.
+//
+#define ECG_HW_CLOCK                  0
+#define ECG_BATCH_SAMPLES             4
+//
+// 2(f) Packed samples. Normally every 10-bit sample goes out as two bytes.
+//      With PACKED_SAMPLES each one takes PACKED_SAMPLE_BITS bits instead
+//      (the top bits of the result, so fewer than 10 trades resolution for
+//      room), run together across byte boundaries. Multi-sample replies
+//      (BACKGROUND_SAMPLING, ECG_HW_CLOCK) then carry more samples per EPC or
+//      Read. The EPC modes need it for the three-channel sensors: after the
+//      payload header, the WISP version and the WISP ID there are five EPC
+//      bytes left, four 10-bit samples. See pack.h; host/wisp_unpack.c
+//      decodes it.
+//
+#define PACKED_SAMPLES                1
+#define PACKED_SAMPLE_BITS            10  // 1 to 10
+//
+// 2(g) Lossless ECG compression (needs ECG_HW_CLOCK). Each batch is delta
+//      coded (ECG_CODEC_ORDER 1 or 2) and Rice coded into the whole reply
+//      payload, so ECG_BATCH_SAMPLES can go up to 15 (the five EPC bytes
+//      hold 4 to 11 samples, see host/bench/ecg_codec_bench.c). If a noisy
+//      batch doesn't fit, the reply carries as much of it as does. PACKED_SAMPLES doesn't
+//      apply here; samples are always kept at 10 bits. See ecg_codec.h;
+//      host/wisp_ecg_decode.c decodes it.
+//
+#define ECG_COMPRESS                  0
+#define ECG_CODEC_ORDER               2
+//
+// 2(h) Report on change (SENSOR_DATA_IN_ID with one of the accelerometers
+//      or the internal temp sensor). A new reading only replaces the one in
+//      the EPC if some channel has moved by more than CHANGE_THRESHOLD ADC
+//      counts; otherwise the EPC, its sequence number and its CRC are left
+//      alone, index included. Readings that didn't move still use up an
+//      index, so the next fresh payload shows how many were taken since.
+//      A fresh payload has PAYLOAD_NEW set (top bit of the sensor type byte)
+//      until the EPC has gone out in an ACK reply, so with ENABLE_SESSIONS a
+//      reader can Select just the tags with something new to say.
+//
+#define REPORT_ON_CHANGE              0
+#define CHANGE_THRESHOLD              10  // ADC counts
+//
+// 2(i) Adaptive settle time (the accelerometers). Instead of waiting out
+//      the worst-case settle time after powering the accelerometer,
+//      the driver checks its outputs every watchdog interval with a short
+//      conversion and takes the real sample once two checks in a row agree
+//      within SETTLE_TOLERANCE counts. It learns how long each channel
+//      usually takes and sleeps through most of that before checking. See
+//      settle.h.
+//
+#define ADAPTIVE_SETTLE               0
+#define SETTLE_TOLERANCE              3   // ADC counts
+//
+// 2(j) More sensors in the same image. Each sample slot (every 10th timeout,
+//      see main()) reads one sensor. ACTIVE_SENSOR is read every slot; give
+//      any other sensor a period n here (1 to 32767) and it's read every nth
+//      slot as well, the one due soonest first. With SCHEDULED_SAMPLING the
+//      periods are scheduler ticks instead (step 2(k)). Setting one for
+//      ACTIVE_SENSOR slows it down instead. The payload header's type byte
+//      says which sensor a payload came from, and each sensor counts its own
+//      sample indexes. Not with BACKGROUND_SAMPLING, ECG_HW_CLOCK or
+//      RR_INTERVALS_IN_ID. See sensors.h.
+//
+#define SENSOR_NULL_EVERY             0
+#define SENSOR_ACCEL_EVERY            0
+#define SENSOR_ACCEL_QUICK_EVERY      0
+#define SENSOR_INTERNAL_TEMP_EVERY    0
+#define SENSOR_ECG_EVERY              0
+#define SENSOR_ACCEL_OVERSAMPLED_EVERY 0
+#define SENSOR_HEALTH_EVERY           0
+#define SENSOR_COMM_STATS_EVERY       0
+//
+// 2(k) Time-based sampling (not with the streaming modes of 2(c), 2(e) or
+//      RR_INTERVALS_IN_ID). Instead of every 10th timeout, which comes
+//      faster or slower or not at all depending on the reader, sensors are
+//      read on a clock: Timer1_A ticks at SCHED_TICK_HZ from ACLK (see step
+//      2(d)) and each sensor is read every SENSOR_x_EVERY ticks, 1 for
+//      ACTIVE_SENSOR by default. The reading is taken in the next gap
+//      between reader commands. The tag listens in LPM3 to keep ACLK
+//      running. See sched.h.
+//
+#define SCHEDULED_SAMPLING            0
+#define SCHED_TICK_HZ                 16
+//
+// 2(l) Energy-aware sampling (not with the streaming modes). Before each
+//      reading the storage capacitor is measured through VSENSE. A reading
+//      is only taken if Vcap stays above ENERGY_VCAP_MIN_MV with enough left
+//      over for ENERGY_REPLY_RESERVE replies; otherwise it's skipped until
+//      that sensor's next period, or if even the replies are in doubt, the
+//      tag stops listening until the cap has charged. What a reading and
+//      a reply cost is learned as it goes. See energy.h.
+//
+#define ENERGY_POLICY                 0
+#define ENERGY_VCAP_MIN_MV            2000
+#define ENERGY_REPLY_RESERVE          8
+//
+// 2(m) Sample archive. Every fresh payload is also written to the external
+//      EEPROM, a ring of the last 64 that survives power loss, so readings
+//      taken with no reader about aren't lost. Payloads have to fit in 13
+//      bytes. A reader reads them back out of the User memory bank. See
+//      archive.h and user_bank.h.
+//
+#define ARCHIVE_SAMPLES               0
+//
+// 2(n) ECG filtering (needs ECG_HW_CLOCK). The lead is converted 8 times
+//      per sample and a CIC filter averages each 8 down to one, which cuts
+//      the ADC and front-end noise and keeps mains hum from aliasing. The
+//      samples are then band-passed to 0.5-40 Hz, which takes out baseline
+//      wander, and go out as 10-bit counts centred on 512. ECG_BATCH_SAMPLES
+//      is at most 4: the DTC blocks need 8 words per sample. See dsp.h;
+//      host/bench/dsp_bench.c compares the filters with a double-precision
+//      model.
+//
+#define ECG_FILTER                    0
 ////////////////////////////////////////////////////////////////////////////////
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -106,6 +266,44 @@
 #define ENABLE_SLOTS                  0
 #define ENABLE_SESSIONS               0
 #define ENABLE_HANDLE_CHECKING        0 // [NOT IMPLEMENTED]
+//
+// 4(b) ENABLE_FAST_RESUME keeps RAM state across a brownout reset. When the
+//      capacitor sags far enough to reset the MSP430 while it sleeps waiting
+//      for power-good, RAM is usually still intact. With this enabled the
+//      C startup code doesn't reinitialize RAM after such a reset, and main()
+//      skips the one-time setup, so the tag comes back with its last sample,
+//      counters and session flags and starts listening right away.
+//
+#define ENABLE_FAST_RESUME            1
+//
+// 4(c) CHECKPOINT_STATE keeps the counters across a real power loss, when
+//      fast resume can't help. Before the tag sleeps for want of power, the
+//      counters, payload sequence number, sample indexes and the payload
+//      waiting to go out are logged to info flash (segments B-D), and a cold
+//      start picks them up again. See checkpoint.h. When only the counters
+//      have moved on, no new checkpoint is written until the last one is
+//      CHECKPOINT_HOLDOFF seconds old (awake, by the scheduler's clock), or
+//      without SCHEDULED_SAMPLING, that many sleeps.
+//
+#define CHECKPOINT_STATE              0
+#define CHECKPOINT_HOLDOFF            30
+//
+// 4(d) DCO_CALIBRATION keeps the link clocks on frequency. The DCO drifts
+//      with supply voltage and temperature, and with it the backscatter link
+//      frequency and every Timer_A constant in the receive code. Every
+//      DCO_TRACK_EVERY timeouts the tag takes a coarse Vcap and temperature
+//      reading and uses the send and receive settings it has measured
+//      against the 32 kHz crystal for those conditions, measuring them the
+//      first time round. DCO_SEND_HZ and DCO_RECEIVE_HZ are the frequencies
+//      to hold; leave them at 0 to hold what the hand-tuned settings give at
+//      the first measurement. Needs ACLK_FROM_CRYSTAL (step 2(d)); the tag
+//      listens in LPM3 to keep it running. Not with the streaming modes,
+//      which own the ADC10. See dco.h.
+//
+#define DCO_CALIBRATION               0
+#define DCO_TRACK_EVERY               100 // timeouts
+#define DCO_SEND_HZ                   0
+#define DCO_RECEIVE_HZ                0
 ////////////////////////////////////////////////////////////////////////////////
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -142,6 +340,14 @@
 //
 #define DEBUG_PINS_ENABLED            0
 //
+// 7(b) Record how long it takes from power-good (reset or supervisor wakeup)
+//      to the first setup_to_receive() afterwards, in SMCLK cycles, in
+//      listen_latency. Useful for seeing how quickly a tag at the edge of
+//      range rejoins an inventory round. Uses Timer_A before the receive code
+//      takes it over, so it costs nothing once the tag is listening.
+//
+#define MEASURE_LISTEN_LATENCY        0
+//
 ////////////////////////////////////////////////////////////////////////////////
 
 
@@ -182,27 +388,88 @@
 #define READ_SENSOR                   1
 #warning "compiling sensor data in read command application"
 #endif
+#if RR_INTERVALS_IN_ID
+#define ENABLE_READS                  0
+#define READ_SENSOR                   1
+#warning "compiling RR intervals in id application"
+#endif
+
+// The EPC carries sensor data (payload header in the first four bytes, CRC
+// redone on every update)
+#define DATA_IN_EPC                   (SENSOR_DATA_IN_ID || RR_INTERVALS_IN_ID)
 
-// Conditional include of sensor files. Not a pleasant structure, but it works!
+// ACLK source for the sample clocks (see step 2(d))
+#if ACLK_FROM_CRYSTAL
+#define ACLK_HZ                       XTAL_ACLK_HZ
+#define ACLK_SETUP                    XTAL_ACLK_SETUP
+#else
+#define ACLK_HZ                       VLO_ACLK_HZ
+#define ACLK_SETUP                    VLO_ACLK_SETUP
+#endif
+
+// DCO settings for the link (see step 4(d) and dco.h)
+#if DCO_CALIBRATION
+#define SEND_BCSCTL1                  dco_send_bcsctl1
+#define SEND_DCOCTL                   dco_send_dcoctl
+#define RECEIVE_BCSCTL1               dco_receive_bcsctl1
+#define RECEIVE_DCOCTL                dco_receive_dcoctl
+#else
+#define SEND_BCSCTL1                  FIXED_SEND_BCSCTL1
+#define SEND_DCOCTL                   FIXED_SEND_DCOCTL
+#define RECEIVE_BCSCTL1               FIXED_RECEIVE_BCSCTL1
+#define RECEIVE_DCOCTL                FIXED_RECEIVE_DCOCTL
+#endif
+
+// Payload bytes for n sensor samples (see step 2(f) and pack.h)
+#if PACKED_SAMPLES
+#define PACKED_BYTES(n)               ((((n) * PACKED_SAMPLE_BITS) + 7) / 8)
+#else
+#define PACKED_BYTES(n)               ((n) * 2)
+#endif
+
+// Sensor type, batch sequence number and first-sample index ahead of every
+// sensor payload (see payload.h)
+#define PAYLOAD_HEADER_BYTES          4
+
+// EPC bytes left for sensor data after the header, in DATA_IN_EPC modes. The
+// last three stay WISP_VERSION and WISP_ID, so a reader can still tell tags
+// apart.
+#define EPC_DATA_BYTES                (12 - PAYLOAD_HEADER_BYTES - 3)
+
+// Something samples off ACLK while the tag listens: it must idle in LPM3, and
+// nothing may interrupt a backscattered reply.
+#define SAMPLING_ON_ACLK              (BACKGROUND_SAMPLING || ECG_HW_CLOCK || \
+                                       SCHEDULED_SAMPLING)
+
+// ACLK has to keep running while the tag listens, so it idles in LPM3
+#define ACLK_WHILE_LISTENING          (SAMPLING_ON_ACLK || DCO_CALIBRATION)
+
+// The I2C engine and the EEPROM driver are built in (i2c.h, eeprom.h). Only
+// then does Port1_ISR hold the engine off, and the tag listen in LPM0 while
+// a transfer is queued; other images keep the plain receive path.
+#define I2C_IN_IMAGE                  ARCHIVE_SAMPLES
+
+// Timer1_A's tick only counts or starts a sequence, so it can wait: Port1_ISR
+// holds it off from a command's first edge until setup_to_receive(), and it
+// can't land in the cycle-counted decode. ECG_HW_CLOCK's tick is the sample
+// instant itself, so that one isn't held.
+#define TICK_HELD_WHILE_RECEIVING     (BACKGROUND_SAMPLING || \
+                                       SCHEDULED_SAMPLING)
+
+// Sensor drivers and the registry (see step 2(j) and sensors.h)
 #if READ_SENSOR
-  #if (ACTIVE_SENSOR == SENSOR_ACCEL_QUICK)
-    #include "quick_accel_sensor.h"
-  #elif (ACTIVE_SENSOR == SENSOR_ACCEL)
-    #include "accel_sensor.h"
-  #elif (ACTIVE_SENSOR == SENSOR_INTERNAL_TEMP)
-    #include "int_temp_sensor.h"
-  #elif (ACTIVE_SENSOR == SENSOR_EXTERNAL_TEMP)
-    #error "SENSOR_EXTERNAL_TEMP not yet implemented"
-  #elif (ACTIVE_SENSOR == SENSOR_NULL)
-    #include "null_sensor.h"
-  #elif (ACTIVE_SENSOR == SENSOR_COMM_STATS)
-    #error "SENSOR_COMM_STATS not yet implemented"
-  #elif (ACTIVE_SENSOR == ECG_SENSOR)
-    #include "ecg_sensor.h"
-  #endif
-  extern unsigned char sensor_busy;
-  void init_sensor();
-  void read_sensor(unsigned char volatile *target);
+#include "sensors.h"
+#endif
+
+// The calibrated link clocks (see step 4(d) and dco.h)
+#if DCO_CALIBRATION
+#include "dco.h"
+#endif
+
+// Link statistics, counted only with SENSOR_COMM_STATS in the image (see
+// comm_stats_sensor.h)
+#ifndef COMM_COUNT
+#define COMM_COUNT(c)
 #endif
 
 #endif // MYWISP_H
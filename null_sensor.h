@@ -3,9 +3,15 @@
 #ifndef NULL_SENSOR_H
 #define NULL_SENSOR_H
 
-#define SENSOR_DATA_TYPE_ID       0x0C
+#define NULL_SENSOR_TYPE_ID       0x0C
 
-#define DATA_LENGTH_IN_WORDS      1
-#define DATA_LENGTH_IN_BYTES      (DATA_LENGTH_IN_WORDS*2)
+#define NULL_SENSOR_WORDS         1
+#define NULL_SENSOR_BYTES         (NULL_SENSOR_WORDS*2)
+
+extern const sensor_driver null_driver;
+
+#if (ACTIVE_SENSOR == SENSOR_NULL)
+#define SENSOR_DATA_TYPE_ID       NULL_SENSOR_TYPE_ID
+#endif
 
 #endif // NULL_SENSOR_H
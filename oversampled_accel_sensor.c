@@ -0,0 +1,129 @@
+/* See license.txt for license information. */
+#include "mywisp.h"
+#if OVERSAMPLED_ACCEL_PERIOD
+
+/*
+ * Quick accel, averaged. After the same short settle as quick accel, the
+ * ADC10 runs the X/Y/Z sequence over and over in repeat-sequence mode, with
+ * the same sample-and-hold time and clock. The DTC drops the passes into
+ * two small blocks in turn and the ADC10 interrupt adds each block up per
+ * axis as it fills (adc_seq_sum()), so the burst never has to fit in RAM.
+ * The first block is dropped (the sensor outputs are still moving the most
+ * then), the next OVERSAMPLE_COUNT passes are summed (a one-stage CIC,
+ * decimating by OVERSAMPLE_COUNT) and scaled to OVERSAMPLE_BITS.
+ *
+ * Averaging takes the ADC's noise down by sqrt(count), but the
+ * accelerometer's only as far as its output filter lets it: the burst is
+ * well under a millisecond, and noise slower than that is the same in every
+ * pass. Nor does it touch the partial-settling error quick accel already
+ * has. host/bench/accel_bench.c models both against quick accel, with the
+ * energy per reading.
+ */
+
+#include "dlwisp41.h"
+#include "rfid.h"
+#include "oversampled_accel_sensor.h"
+#include "adc_seq.h"
+#include "payload.h"
+#include "settle.h"
+
+#if OVERSAMPLE_LOG2 > 4 || OVERSAMPLE_COUNT < ADC_SEQ_SUM_PASSES
+#error "OVERSAMPLE_LOG2 is 1 to 4 (the sum has to fit 16 bits)"
+#endif
+
+#define AXES                      OVERSAMPLED_ACCEL_DATA_WORDS  // X, Y, Z
+
+#if REPORT_ON_CHANGE
+static unsigned short oversampled_accel_ref[AXES] = { PAYLOAD_REF_NONE };
+#endif
+
+static void oversampled_accel_start()
+{
+  // slow down clock
+  BCSCTL1 = XT2OFF + RSEL1; // select internal resistor (still has effect when DCOR=1)
+  DCOCTL = DCO1+DCO0; // set DCO step.
+
+  // Clear out any lingering voltage on the accelerometer outputs
+  ADC10AE0 = 0;
+
+#if(WISP_VERSION == BLUE_WISP || WISP_VERSION == PURPLE_WISP)
+  P2OUT &= ~(ACCEL_X | ACCEL_Y | ACCEL_Z);
+  P2DIR |=   ACCEL_X | ACCEL_Y | ACCEL_Z;
+  P2DIR &= ~(ACCEL_X | ACCEL_Y | ACCEL_Z);
+#elif(WISP_VERSION == RED_WISP)
+  P1OUT &= ~(ACCEL_X | ACCEL_Y | ACCEL_Z);
+  P1DIR |=   ACCEL_X | ACCEL_Y | ACCEL_Z;
+  P1DIR &= ~(ACCEL_X | ACCEL_Y | ACCEL_Z);
+#endif
+
+  P1DIR |= ACCEL_POWER;
+  P1OUT |= ACCEL_POWER;
+  ADC10AE0 |= ACCEL_X | ACCEL_Y | ACCEL_Z;
+}
+
+static unsigned char oversampled_accel_collect(unsigned char volatile *target)
+{
+  unsigned short blocks[2 * ADC_SEQ_SUM_PASSES * AXES];
+  unsigned short sum[AXES] = { 0, 0, 0 };
+  unsigned char c;
+
+#if ADAPTIVE_SETTLE
+  RECEIVE_CLOCK;
+  settle_sensor(AXES,
+                ADC10DIV_2 + ADC10SSEL_0 + SHS_0 + INCH_ACCEL_X, 16);
+#else
+  // a little time for regulator to stabilize active mode current AND
+  // filter caps to settle.
+  for(int k = 0; k < 225; k++);
+  RECEIVE_CLOCK;
+#endif
+
+  // GRAB DATA: X (A2), Y (A1), Z (A0), over and over, into sum[]
+  adc_seq_sum(sum, blocks, AXES, 1, OVERSAMPLE_COUNT / ADC_SEQ_SUM_PASSES,
+              SREF_0 + ADC10SHT_1,
+              ADC10DIV_2 + ADC10SSEL_0 + SHS_0 + INCH_ACCEL_X);
+
+  // Power off sensor and adc
+  P1DIR &= ~ACCEL_POWER;
+  P1OUT &= ~ACCEL_POWER;
+  ADC10CTL0 &= ~ENC;
+  ADC10CTL1 = 0;       // turn adc off
+  ADC10CTL0 = 0;       // turn adc off
+
+#if REPORT_ON_CHANGE
+  // compare at 10 bits, like the other sensors
+  unsigned short mean[AXES];
+  for ( c = 0; c < AXES; c++ )
+    mean[c] = sum[c] >> OVERSAMPLE_LOG2;
+  if ( !payload_changed(oversampled_accel_ref, mean, AXES) )
+    return 0;
+#endif
+
+  // run together as pack_samples() does, at OVERSAMPLE_BITS
+  unsigned long bits = 0;
+  unsigned char count = 0;
+  for ( c = 0; c < AXES; c++ )
+  {
+    bits = (bits << OVERSAMPLE_BITS) |
+           (sum[c] >> (OVERSAMPLE_LOG2 - OVERSAMPLE_LOG2/2));
+    count += OVERSAMPLE_BITS;
+
+    while ( count >= 8 )
+    {
+      count -= 8;
+      *target++ = (unsigned char)(bits >> count);
+    }
+  }
+
+  if ( count )
+    *target = (unsigned char)(bits << (8 - count));
+
+  return 1;
+}
+
+const sensor_driver oversampled_accel_driver = {
+  OVERSAMPLED_ACCEL_TYPE_ID, OVERSAMPLED_ACCEL_DATA_BYTES, 0,
+  oversampled_accel_start, oversampled_accel_collect
+};
+
+#endif // OVERSAMPLED_ACCEL_PERIOD
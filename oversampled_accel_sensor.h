@@ -0,0 +1,36 @@
+/* See license.txt for license information. */
+
+#ifndef OVERSAMPLED_ACCEL_SENSOR_H
+#define OVERSAMPLED_ACCEL_SENSOR_H
+
+// these bit definitions are specific to WISP 4.1 DL
+
+#define OVERSAMPLED_ACCEL_TYPE_ID 0x12
+
+#define ACCEL_ENABLE_BIT          BIT5   // 1.5
+#define SET_ACCEL_ENABLE_DIR      P1DIR |= ACCEL_ENABLE_BIT
+#define CLEAR_ACCEL_ENABLE_DIR    P1DIR &= ~ACCEL_ENABLE_BIT
+#define TURN_ON_ACCEL_ENABLE      P1OUT |= ACCEL_ENABLE_BIT
+#define TURN_OFF_ACCEL_ENABLE     P1OUT &= ~ACCEL_ENABLE_BIT
+
+// Sequences per reading (2^OVERSAMPLE_LOG2), after ADC_SEQ_SUM_PASSES (a
+// block) that are thrown away. Each doubling of the count is another half
+// bit.
+#define OVERSAMPLE_LOG2           4
+#define OVERSAMPLE_COUNT          (1 << OVERSAMPLE_LOG2)
+#define OVERSAMPLE_BITS           (10 + OVERSAMPLE_LOG2/2)
+
+// X, Y, Z at OVERSAMPLE_BITS each, run together MSB first the way pack.h
+// packs samples, so they fit the EPC: five bytes at 12 bits, the last four
+// bits zero. Not affected by PACKED_SAMPLES; host/wisp_unpack.c decodes it.
+#define OVERSAMPLED_ACCEL_DATA_WORDS  3
+#define OVERSAMPLED_ACCEL_DATA_BYTES \
+  ((OVERSAMPLED_ACCEL_DATA_WORDS*OVERSAMPLE_BITS + 7) / 8)
+
+extern const sensor_driver oversampled_accel_driver;
+
+#if (ACTIVE_SENSOR == SENSOR_ACCEL_OVERSAMPLED)
+#define SENSOR_DATA_TYPE_ID       OVERSAMPLED_ACCEL_TYPE_ID
+#endif
+
+#endif // OVERSAMPLED_ACCEL_SENSOR_H
@@ -0,0 +1,39 @@
+/* See license.txt for license information. */
+
+#include "mywisp.h"
+#include "pack.h"
+
+// Write n 10-bit samples to target in the payload format above.
+void pack_samples(unsigned char volatile *target, const unsigned short *samples,
+                  unsigned char n)
+{
+#if PACKED_SAMPLES
+  // Bits go in at the bottom and come out at the top; never more than
+  // 7 + PACKED_SAMPLE_BITS of them are waiting.
+  unsigned long bits = 0;
+  unsigned char count = 0;
+
+  while ( n-- )
+  {
+    bits = (bits << PACKED_SAMPLE_BITS) |
+           ((*samples++ & 0x03ff) >> (10 - PACKED_SAMPLE_BITS));
+    count += PACKED_SAMPLE_BITS;
+
+    while ( count >= 8 )
+    {
+      count -= 8;
+      *target++ = (unsigned char)(bits >> count);
+    }
+  }
+
+  if ( count )
+    *target = (unsigned char)(bits << (8 - count));
+#else
+  while ( n-- )
+  {
+    unsigned short s = *samples++;
+    *target++ = (s & 0x0300) >> 8;
+    *target++ = (s & 0xff);
+  }
+#endif
+}
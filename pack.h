@@ -0,0 +1,23 @@
+/* See license.txt for license information. */
+
+#ifndef PACK_H
+#define PACK_H
+
+/*
+ * Sample payload format (PACKED_SAMPLES in mywisp.h).
+ *
+ * Unpacked, each 10-bit ADC10 result takes two bytes, MSB first, top six bits
+ * zero. Packed, each sample takes PACKED_SAMPLE_BITS bits (the top bits of
+ * the 10-bit result), written MSB first straight after the previous sample,
+ * so samples run across byte boundaries. The last byte is padded with zeros.
+ *
+ *   10 bits:  s0[9:2] | s0[1:0] s1[9:4] | s1[3:0] s2[9:6] | ...
+ *
+ * PACKED_BYTES(n) in mywisp.h is the payload size for n samples either way.
+ * host/wisp_unpack.c undoes this on the reader side.
+ */
+
+void pack_samples(unsigned char volatile *target, const unsigned short *samples,
+                  unsigned char n);
+
+#endif // PACK_H
@@ -0,0 +1,74 @@
+/* See license.txt for license information. */
+
+#include "dlwisp41.h"
+#include "rfid.h"
+#include "mywisp.h"
+#include "payload.h"
+
+#if DATA_IN_EPC || SENSOR_DATA_IN_READ_COMMAND
+
+unsigned char payload_seq = 0;
+volatile unsigned char payload_acked = 0; // set by handle_ack()
+
+// Write the header for a new batch from sensor type, whose first sample has
+// index first.
+void payload_header(unsigned char volatile *target, unsigned char type,
+                    unsigned short first)
+{
+#if REPORT_ON_CHANGE
+  *target++ = type | PAYLOAD_NEW;
+  payload_acked = 0;
+#else
+  *target++ = type;
+#endif
+  *target++ = payload_seq++;
+  *target++ = __swap_bytes(first);
+  *target   = first;
+}
+
+#if REPORT_ON_CHANGE
+
+// Compare n samples against the last ones reported in ref. Returns 1, and
+// makes them the new reference, if any of them has moved by more than
+// CHANGE_THRESHOLD.
+unsigned char payload_changed(unsigned short *ref,
+                              const unsigned short *samples, unsigned char n)
+{
+  unsigned char i;
+
+  if ( ref[0] != PAYLOAD_REF_NONE )
+  {
+    for ( i = 0; i < n; i++ )
+    {
+      unsigned short d = (samples[i] > ref[i]) ?
+                         samples[i] - ref[i] :
+                         ref[i] - samples[i];
+      if ( d > CHANGE_THRESHOLD )
+        break;
+    }
+    if ( i == n )
+      return 0;
+  }
+
+  for ( i = 0; i < n; i++ )
+    ref[i] = samples[i];
+  return 1;
+}
+
+// The reader has had the EPC: clear PAYLOAD_NEW. Called from the main loop
+// rather than handle_ack() so the CRC isn't redone in the middle of a reply.
+void payload_delivered()
+{
+  payload_acked = 0;
+  if ( !(PAYLOAD_START[0] & PAYLOAD_NEW) )
+    return;
+
+  PAYLOAD_START[0] &= ~PAYLOAD_NEW;
+  ackReplyCRC = crc16_ccitt(&ackReply[0], 14);
+  ackReply[15] = (unsigned char)ackReplyCRC;
+  ackReply[14] = (unsigned char)__swap_bytes(ackReplyCRC);
+}
+
+#endif // REPORT_ON_CHANGE
+
+#endif // DATA_IN_EPC || SENSOR_DATA_IN_READ_COMMAND
@@ -0,0 +1,76 @@
+/* See license.txt for license information. */
+
+#ifndef PAYLOAD_H
+#define PAYLOAD_H
+
+/*
+ * Sensor payload header. Every sensor reply, whichever module produced it,
+ * starts with the same PAYLOAD_HEADER_BYTES:
+ *
+ *   1 byte   sensor type (the driver's type ID), top bit PAYLOAD_NEW
+ *   1 byte   batch sequence number, +1 per new payload, mod 256
+ *   2 bytes  index of the first sample in the batch, MSB first, mod 2^16
+ *
+ * followed by DATA_LENGTH_IN_BYTES of sensor data. In DATA_IN_EPC modes the
+ * header is the first four EPC bytes and the data gets the next
+ * EPC_DATA_BYTES; the last three are still WISP_VERSION and WISP_ID, so the
+ * reader can tell tags apart. Otherwise the header leads the Read reply.
+ *
+ * A reader sees the same EPC many times over, so the sequence number tells a
+ * repeat from a new batch; the index places the samples on the tag's time
+ * axis so a missed batch shows up as a gap. What counts as a sample index
+ * depends on the producer:
+ *   sensors_read()    one per reading of that sensor
+ *   sampler_read()    sample clock ticks since sampler_start()
+ *   ecg_clock_read()  ADC samples since ecg_clock_start()
+ *   qrs_read()        sample index of the latest beat
+ *
+ * With REPORT_ON_CHANGE, a sensor driver only writes a new payload when a
+ * channel has moved since its last report (payload_changed()), and
+ * PAYLOAD_NEW stays set until the EPC has been sent in reply to an ACK
+ * (payload_delivered()).
+ *
+ * host/wisp_stream.c puts the batches back together on the reader side.
+ */
+
+#include "mywisp.h"
+
+#define PAYLOAD_BYTES             (PAYLOAD_HEADER_BYTES + DATA_LENGTH_IN_BYTES)
+
+#if DATA_IN_EPC
+#define PAYLOAD_START             (&ackReply[2])
+#if (DATA_LENGTH_IN_BYTES > EPC_DATA_BYTES)
+#error "sensor payload too big for the EPC, see PACKED_SAMPLES"
+#endif
+#elif SENSOR_DATA_IN_READ_COMMAND
+#define PAYLOAD_START             (&readReply[0])
+// handle and CRC have to fit behind it, see crc16_ccitt_readReply()
+#if (PAYLOAD_BYTES > 14)
+#error "sensor payload too big for readReply"
+#endif
+#endif
+
+#define PAYLOAD_DATA              (PAYLOAD_START + PAYLOAD_HEADER_BYTES)
+
+#define PAYLOAD_NEW               0x80
+
+#if REPORT_ON_CHANGE && !SENSOR_DATA_IN_ID
+#error "REPORT_ON_CHANGE needs SENSOR_DATA_IN_ID"
+#endif
+
+extern unsigned char payload_seq;
+extern volatile unsigned char payload_acked;
+
+void payload_header(unsigned char volatile *target, unsigned char type,
+                    unsigned short first);
+
+#if REPORT_ON_CHANGE
+// ref holds a sensor's last reported samples; PAYLOAD_REF_NONE in ref[0]
+// means it hasn't reported yet.
+#define PAYLOAD_REF_NONE          0xFFFF
+unsigned char payload_changed(unsigned short *ref,
+                              const unsigned short *samples, unsigned char n);
+void payload_delivered();
+#endif
+
+#endif // PAYLOAD_H
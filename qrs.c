@@ -0,0 +1,154 @@
+/* See license.txt for license information. */
+
+#include "dlwisp41.h"
+#include "mywisp.h"
+#include "ecg_clock.h"
+#include "qrs.h"
+
+#if RR_INTERVALS_IN_ID
+
+unsigned short qrs_beats = 0;
+unsigned short qrs_beats_sent = 0;
+
+static unsigned short last_beat;               // sample index
+static unsigned short rr[QRS_RR_COUNT];        // newest first
+
+// filter state
+static unsigned short x1, x2;                  // raw history
+static unsigned short y1, y2, y3, y4;          // low-pass history
+static unsigned char window[QRS_WINDOW];
+static unsigned char window_pos;
+static unsigned short sum, last_sum;
+
+// peak classification
+static unsigned short candidate, candidate_index;
+static unsigned short spki, npki, threshold;
+static unsigned short learn = QRS_LEARN;
+
+// a*a by shift and add; the F2132 has no multiplier
+static unsigned short square(unsigned char a)
+{
+  unsigned short r = 0;
+  unsigned short m = a;
+
+  while ( a )
+  {
+    if ( a & 1 )
+      r += m;
+    m <<= 1;
+    a >>= 1;
+  }
+  return r;
+}
+
+static void qrs_beat(unsigned short index)
+{
+  if ( qrs_beats )
+  {
+    for ( int i = QRS_RR_COUNT - 1; i > 0; i-- )
+      rr[i] = rr[i-1];
+    rr[0] = index - last_beat;
+  }
+  last_beat = index;
+  qrs_beats++;
+}
+
+static void qrs_sample(unsigned short x, unsigned short index)
+{
+  unsigned short y = (x + (x1 << 1) + x2) >> 2;
+  x2 = x1;
+  x1 = x;
+
+  short d = (short)((y << 1) + y1 - y3 - (y4 << 1)) >> 3;
+  y4 = y3;
+  y3 = y2;
+  y2 = y1;
+  y1 = y;
+
+  if ( d < 0 )
+    d = -d;
+  unsigned char a = square(( d > 63 ) ? 63 : d) >> 4;
+
+  sum += a - window[window_pos];
+  window[window_pos] = a;
+  window_pos = (window_pos + 1) & (QRS_WINDOW - 1);
+
+  unsigned short rising = ( sum > last_sum );
+  last_sum = sum;
+
+  if ( candidate == 0 )
+  {
+    // still coming down from the last peak; wait for the next rise
+    if ( rising )
+    {
+      candidate = sum;
+      candidate_index = index;
+    }
+    return;
+  }
+  if ( sum > candidate )
+  {
+    candidate = sum;
+    candidate_index = index;
+    return;
+  }
+  if ( sum >= (candidate >> 1) )
+    return;
+
+  unsigned short since = candidate_index - QRS_DELAY - last_beat;
+
+  // the integrated signal has dropped to half the last peak: classify it
+  if ( learn )
+  {
+    if ( candidate > spki )
+      spki = candidate;
+  }
+  else if ( candidate > threshold && since > QRS_REFRACTORY &&
+            (since > QRS_TWAVE || candidate > (spki >> 1)) )
+  {
+    qrs_beat(candidate_index - QRS_DELAY);
+    spki = spki - (spki >> 3) + (candidate >> 3);
+  }
+  else
+  {
+    npki = npki - (npki >> 3) + (candidate >> 3);
+  }
+  threshold = npki + ((spki - npki) >> 2);
+  candidate = 0;
+}
+
+void qrs_run()
+{
+  unsigned short *batch;
+  unsigned short index;
+
+  while ( (batch = ecg_clock_take(&index)) != 0 )
+  {
+    for ( unsigned char i = 0; i < ECG_BATCH_SAMPLES; i++ )
+    {
+      qrs_sample(batch[i], index + i);
+
+      if ( learn && --learn == 0 )
+      {
+        // start from the biggest peak seen while learning
+        spki >>= 1;
+        npki = spki >> 3;
+        threshold = npki + ((spki - npki) >> 2);
+      }
+    }
+  }
+}
+
+unsigned short qrs_read(unsigned char volatile *target)
+{
+  for ( int i = 0; i < QRS_RR_COUNT; i++ )
+  {
+    *target++ = __swap_bytes(rr[i]);
+    *target++ = rr[i];
+  }
+
+  qrs_beats_sent = qrs_beats;
+  return last_beat;
+}
+
+#endif // RR_INTERVALS_IN_ID
@@ -0,0 +1,61 @@
+/* See license.txt for license information. */
+
+#ifndef QRS_H
+#define QRS_H
+
+/*
+ * On-tag R-peak detection (RR_INTERVALS_IN_ID in mywisp.h).
+ *
+ * A cut-down Pan-Tompkins detector over the ECG_HW_CLOCK samples, integer
+ * and shift-add only:
+ *
+ *   low-pass     y = (x[n] + 2x[n-1] + x[n-2]) / 4
+ *   derivative   d = (2y[n] + y[n-1] - y[n-3] - 2y[n-4]) / 8
+ *   square       |d| clipped to 63, squared by shift-add, / 16
+ *   integrate    sum of the last QRS_WINDOW values (~140 ms)
+ *
+ * Peaks of the integrated signal are classified against an adaptive threshold
+ * between the running signal and noise peak levels (SPKI, NPKI), with a
+ * 200 ms refractory period. Up to 360 ms after a beat a peak also has to reach
+ * half of SPKI, which keeps tall T waves out. The first two seconds only
+ * learn the levels.
+ *
+ * Report (QRS_REPORT_BYTES, after the payload header): the last two RR
+ * intervals in samples, newest first, MSB first; 0 until that many beats have
+ * been seen. Two is what fits the EPC next to the WISP version and ID. A new report goes out after each new beat; the index in the
+ * header is the sample index of the latest beat (see ecg_clock.h).
+ *
+ * Beat indexes lag the true R peak by the filter delay (about QRS_DELAY
+ * samples); RR intervals aren't affected.
+ */
+
+#include "mywisp.h"
+
+#if RR_INTERVALS_IN_ID
+
+#if !ECG_HW_CLOCK || (ACTIVE_SENSOR != SENSOR_ECG)
+#error "RR_INTERVALS_IN_ID needs SENSOR_ECG and ECG_HW_CLOCK"
+#endif
+
+#define QRS_WINDOW                32            // power of two
+#define QRS_DELAY                 (3 + QRS_WINDOW/2)
+#define QRS_REFRACTORY            (ECG_CLOCK_HZ / 5)
+#define QRS_TWAVE                 (ECG_CLOCK_HZ * 9 / 25)  // 360 ms
+#define QRS_LEARN                 (ECG_CLOCK_HZ * 2)
+#define QRS_RR_COUNT              2
+#define QRS_REPORT_BYTES          (2*QRS_RR_COUNT)
+
+extern unsigned short qrs_beats;
+extern unsigned short qrs_beats_sent;
+
+#define qrs_pending()             (qrs_beats != qrs_beats_sent)
+
+// Run the detector over every sample block ecg_clock has finished.
+void qrs_run();
+
+// Write the report to target. Returns the index of the latest beat.
+unsigned short qrs_read(unsigned char volatile *target);
+
+#endif // RR_INTERVALS_IN_ID
+
+#endif // QRS_H
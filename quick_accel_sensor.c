@@ -1,31 +1,26 @@
 /* See license.txt for license information. */
 #include "mywisp.h"
-#if (ACTIVE_SENSOR == SENSOR_ACCEL_QUICK)
+#if QUICK_ACCEL_PERIOD
 
 #include "dlwisp41.h"
 #include "rfid.h"
 #include "quick_accel_sensor.h"
+#include "adc_seq.h"
+#include "pack.h"
+#include "payload.h"
+#include "settle.h"
+
+#if REPORT_ON_CHANGE
+static unsigned short quick_accel_ref[QUICK_ACCEL_DATA_WORDS] =
+  { PAYLOAD_REF_NONE };
+#endif
 
-unsigned char sensor_busy = 0;
-
-void init_sensor()
-{
-  return;
-}
-
-void read_sensor(unsigned char volatile *target)
+static void quick_accel_start()
 {
-
-  // turn off comparator
-  P1OUT &= ~RX_EN_PIN;
-
   // slow down clock
   BCSCTL1 = XT2OFF + RSEL1; // select internal resistor (still has effect when DCOR=1)
   DCOCTL = DCO1+DCO0; // set DCO step.
 
-  if(!is_power_good())
-    sleep();
-
   // Clear out any lingering voltage on the accelerometer outputs
   ADC10AE0 = 0;
 
@@ -43,50 +38,35 @@ void read_sensor(unsigned char volatile *target)
   P1DIR |= ACCEL_POWER;
   P1OUT |= ACCEL_POWER;
   ADC10AE0 |= ACCEL_X | ACCEL_Y | ACCEL_Z;
+}
 
+static unsigned char quick_accel_collect(unsigned char volatile *target)
+{
+#if ADAPTIVE_SETTLE
+  // sleep until the outputs stop moving, instead of a fixed spin. Passes are
+  // timed off the receive clock, so 16 of them is a couple of ms at most.
+  RECEIVE_CLOCK;
+  settle_sensor(QUICK_ACCEL_DATA_WORDS,
+                ADC10DIV_2 + ADC10SSEL_0 + SHS_0 + INCH_ACCEL_X, 16);
+#else
   // a little time for regulator to stabilize active mode current AND
   // filter caps to settle.
   for(int i = 0; i < 225; i++);
   RECEIVE_CLOCK;
+#endif
 
-  // GRAB DATA
-  ADC10CTL0 &= ~ENC; // make sure this is off otherwise settings are locked.
-  ADC10CTL0 = SREF_0 + ADC10SHT_1 + ADC10ON;
-  ADC10CTL1 = ADC10DIV_2 + ADC10SSEL_0 + SHS_0 + CONSEQ_0 + INCH_ACCEL_X;
-  ADC10CTL0 |= ENC;
-  ADC10CTL0 |= ADC10SC;
-
-  while (ADC10CTL1 & ADC10BUSY);    // wait while ADC finished work
-
-  *(target+1) = (ADC10MEM & 0xff);
-  // grab msb bits and store it
-  *(target) =   (ADC10MEM & 0x0300) >> 8;
-
-  // GRAB DATA
-  ADC10CTL0 &= ~ENC; // make sure this is off otherwise settings are locked.
-  ADC10CTL0 = SREF_0 + ADC10SHT_1 + ADC10ON;
-  ADC10CTL1 = ADC10DIV_2 + ADC10SSEL_0 + SHS_0 + CONSEQ_0 + INCH_ACCEL_Y;
-  ADC10CTL0 |= ENC;
-  ADC10CTL0 |= ADC10SC;
-
-  while (ADC10CTL1 & ADC10BUSY);    // wait while ADC finished work
-
-  *(target+3) = (ADC10MEM & 0xff);
-  // grab msb bits and store it
-  *(target+2) = (ADC10MEM & 0x0300) >> 8;
-
-  // GRAB DATA
-  ADC10CTL0 &= ~ENC; // make sure this is off otherwise settings are locked.
-  ADC10CTL0 = SREF_0 + ADC10SHT_1 + ADC10ON;
-  ADC10CTL1 = ADC10DIV_2 + ADC10SSEL_0 + SHS_0 + CONSEQ_0 + INCH_ACCEL_Z;
-  ADC10CTL0 |= ENC;
-  ADC10CTL0 |= ADC10SC;
-
-  while (ADC10CTL1 & ADC10BUSY);    // wait while ADC finished work
+  // GRAB DATA: X (A2), Y (A1) and Z (A0) in one sequence, straight into
+  // samples[] via the DTC
+  unsigned short samples[QUICK_ACCEL_DATA_WORDS];
+  adc_seq_read(samples, QUICK_ACCEL_DATA_WORDS, SREF_0 + ADC10SHT_1,
+               ADC10DIV_2 + ADC10SSEL_0 + SHS_0 + INCH_ACCEL_X);
 
-  *(target+5) = (ADC10MEM & 0xff);
-  // grab msb bits and store it
-  *(target+4) = (ADC10MEM & 0x0300) >> 8;
+#if REPORT_ON_CHANGE
+  unsigned char changed = payload_changed(quick_accel_ref, samples,
+                                          QUICK_ACCEL_DATA_WORDS);
+  if ( changed )
+#endif
+  pack_samples(target, samples, QUICK_ACCEL_DATA_WORDS);
 
   // Power off sensor and adc
   P1DIR &= ~ACCEL_POWER;
@@ -95,14 +75,16 @@ void read_sensor(unsigned char volatile *target)
   ADC10CTL1 = 0;       // turn adc off
   ADC10CTL0 = 0;       // turn adc off
 
-  // Store sensor read count
-  sensor_counter++;
-  *(target+7) = (sensor_counter & 0x00ff);
-  // grab msb bits and store it
-  *(target+6)  = (sensor_counter & 0xff00) >> 8;
-
-  // turn on comparator
-  P1OUT |= RX_EN_PIN;
+#if REPORT_ON_CHANGE
+  return changed;
+#else
+  return 1;
+#endif
 }
 
-#endif // (ACTIVE_SENSOR == SENSOR_ACCEL_QUICK)
+const sensor_driver quick_accel_driver = {
+  QUICK_ACCEL_TYPE_ID, QUICK_ACCEL_DATA_BYTES, 0, quick_accel_start,
+  quick_accel_collect
+};
+
+#endif // QUICK_ACCEL_PERIOD
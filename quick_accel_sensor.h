@@ -5,7 +5,7 @@
 
 // these bit definitions are specific to WISP 4.1 DL
 
-#define SENSOR_DATA_TYPE_ID       0x0B
+#define QUICK_ACCEL_TYPE_ID       0x0B
 
 #define ACCEL_ENABLE_BIT          BIT5   // 1.5
 #define SET_ACCEL_ENABLE_DIR      P1DIR |= ACCEL_ENABLE_BIT
@@ -13,7 +13,26 @@
 #define TURN_ON_ACCEL_ENABLE      P1OUT |= ACCEL_ENABLE_BIT
 #define TURN_OFF_ACCEL_ENABLE     P1OUT &= ~ACCEL_ENABLE_BIT
 
-#define DATA_LENGTH_IN_WORDS      3
-#define DATA_LENGTH_IN_BYTES      (DATA_LENGTH_IN_WORDS*2)
+#define QUICK_ACCEL_DATA_WORDS    3
+#define QUICK_ACCEL_DATA_BYTES    PACKED_BYTES(QUICK_ACCEL_DATA_WORDS)
+
+extern const sensor_driver quick_accel_driver;
+
+#if (ACTIVE_SENSOR == SENSOR_ACCEL_QUICK)
+#define SENSOR_DATA_TYPE_ID       QUICK_ACCEL_TYPE_ID
+
+// BACKGROUND_SAMPLING settings (see sampler.h)
+#define SENSOR_POWER_ON \
+  do { SET_ACCEL_ENABLE_DIR; TURN_ON_ACCEL_ENABLE; } while (0)
+#define SENSOR_POWER_OFF \
+  do { CLEAR_ACCEL_ENABLE_DIR; TURN_OFF_ACCEL_ENABLE; } while (0)
+#define SAMPLE_CHANNELS           3
+#define SAMPLE_SEQ_INCH           INCH_ACCEL_X
+#define SAMPLE_SEQ_LEN            3
+#define SAMPLE_SLOT_LIST          0, 1, 2
+#define SAMPLE_ADC10AE            (ACCEL_X | ACCEL_Y | ACCEL_Z)
+#define SAMPLE_ADC10CTL0          (SREF_0 + ADC10SHT_1)
+#define SAMPLE_ADC10CTL1          (ADC10DIV_2 + ADC10SSEL_0)
+#endif
 
 #endif // QUICK_ACCEL_SENSOR_H
@@ -3,6 +3,9 @@
 #include "dlwisp41.h"
 #include "rfid.h"
 #include "mywisp.h"
+#include "boot_tables.h"
+#include "payload.h"
+#include "user_bank.h"
 
 unsigned short Q = 0;
 unsigned short slot_counter = 0;
@@ -18,13 +21,22 @@ unsigned short inInventoryRound = 0;
 volatile short state;
 volatile unsigned char cmd[BUFFER_SIZE+1]; // stored cmd from reader
 
-volatile unsigned char queryReply[]= { 0x00, 0x03, 0x00, 0x00};
+// queryReply and ackReply come up with their CRCs already in place; see
+// boot_tables.h.
+volatile unsigned char queryReply[]= { QUERY_REPLY_RN16, QUERY_REPLY_CRC };
 
 // ackReply:  First two bytes are the preamble.  Last two bytes are the crc.
-volatile unsigned char ackReply[]  = { 0x30, 0x00, EPC, 0x00, 0x00};
+volatile unsigned char ackReply[]  = { ACK_REPLY_PC,
+                                       BOOT_APPLY(ACK_REPLY_EPC, (EPC)),
+                                       ACK_REPLY_CRC };
 
 unsigned short queryReplyCRC, ackReplyCRC, readReplyCRC;
 
+#if ENABLE_SLOTS
+// RN16 table for the slotting code, seeded from the EPC at compile time
+unsigned char RN16[23] = { BOOT_APPLY(RN16_TABLE, (EPC)) };
+#endif
+
 // first 8 bits are the EPCGlobal identifier, followed by a 12-bit tag designer
 // identifer (made up), followed by a 12-bit model number
 volatile unsigned char tid[] = { 0xE2, TID_DESIGNER_ID_AND_MODEL_NUMBER };
@@ -45,6 +57,7 @@ volatile unsigned char readReply[] = {
 void handle_query(volatile short nextState)
 {
   TAR = 0;
+  COMM_COUNT(COMM_QUERY);     // while the reply waits anyway
 #if (!ENABLE_SLOTS)  && (!ENABLE_SESSIONS)
     while ( TAR < 90 ); // if bit test is 22
   //P1OUT &= ~RX_EN_PIN;   // turn off comparator
@@ -260,6 +273,7 @@ void handle_queryrep(volatile short nextState)
 {
 
   TAR = 0;
+  COMM_COUNT(COMM_QUERYREP);
 #if (!ENABLE_SESSIONS)
   while ( TAR < 150 );
 #endif
@@ -320,6 +334,7 @@ void handle_queryadjust(volatile short nextState)
 {
 
   TAR = 0;
+  COMM_COUNT(COMM_QUERYADJUST);
 #if !(ENABLE_SLOTS) && !(ENABLE_SESSIONS)
   while ( TAR < 300 );
   //P1OUT &= ~RX_EN_PIN;   // turn off comparator
@@ -434,6 +449,7 @@ void handle_queryadjust(volatile short nextState)
 // leftmost part of the pattern field.
 void handle_select(volatile short nextState)
 {
+  COMM_COUNT(COMM_SELECT);
   do_nothing();
 
 //DEBUG_PIN5_HIGH;
@@ -575,6 +591,7 @@ void handle_ack(volatile short nextState)
 {
   TACCTL1 &= ~CCIE;
   TAR = 0;
+  COMM_COUNT(COMM_ACK);
   if ( NUM_ACK_BITS == 20 )
     while ( TAR < 90 );
   else
@@ -594,6 +611,9 @@ void handle_ack(volatile short nextState)
   //P1OUT &= ~RX_EN_PIN;   // turn off comparator
   // after that sends tagResponse
   sendToReader(&ackReply[0], 129);
+#if REPORT_ON_CHANGE
+  payload_acked = 1;
+#endif
   state = nextState;
 }
 
@@ -601,6 +621,7 @@ void handle_request_rn(volatile short nextState)
 {
   TACCTL1 &= ~CCIE;
   TAR = 0;
+  COMM_COUNT(COMM_REQ_RN);
   // FIXME FIXME
   // here's a mystery: if I enable this line below, I clobber the follow-up read
   // command. specifically, the read command's cmd[0] shows up as 0xFF.  if i
@@ -625,8 +646,61 @@ void handle_request_rn(volatile short nextState)
   state = nextState;
 }
 
+#if ARCHIVE_SAMPLES
+// User bank words, then the handle, CRC and a spare byte; see
+// crc16_ccitt_readReply(). Apart from readReply, which may hold the sensor
+// payload.
+static volatile unsigned char userReply[USER_BANK_READ_MAX*2 + 5];
+
+// Read fields after the command code and MemBank, byte i of them being the
+// 8 bits from bit 2 of cmd[i] on.
+#define READ_FIELD(i)   ((unsigned char)((cmd[(i)] << 2) | (cmd[(i)+1] >> 6)))
+
+// The archive, through the User bank (user_bank.h)
+static void handle_read_user()
+{
+  unsigned short ptr = READ_FIELD(1);
+  unsigned char count = READ_FIELD(2);
+  unsigned char n;
+
+  TACCTL1 &= ~CCIE;
+  TAR = 0;
+
+  if ( ptr & 0x80 )               // EBV: a second byte follows
+  {
+    ptr = ( count & 0x80 ) ? USER_BANK_WORDS :
+                             ((ptr & 0x7F) << 7) | count;
+    count = READ_FIELD(3);
+  }
+
+  if ( user_bank_read(ptr, count, &userReply[0]) )
+  {
+    n = count * 2;
+    userReply[n] = queryReply[0];
+    userReply[n+1] = queryReply[1];
+    crc16_ccitt_readReply(userReply, n);
+
+    // data + 16 bits for the handle + 16 bits for the CRC + leading 0 + one
+    // for the xmit code
+    sendToReader(&userReply[0], (n*8)+16+16+1+1);
+  }
+  user_bank_prefetch();
+}
+#endif
+
 void handle_read(volatile short nextState)
 {
+  COMM_COUNT(COMM_READ);
+
+#if ARCHIVE_SAMPLES
+  if ( ( cmd[1] >> 6 ) == MEMBANK_USER )
+  {
+    handle_read_user();
+    state = nextState;
+    delimiterNotFound = 1;
+    return;
+  }
+#endif
 
 #if SENSOR_DATA_IN_READ_COMMAND
 
@@ -634,16 +708,16 @@ void handle_read(volatile short nextState)
   TACCTL1 &= ~CCIE;
   TAR = 0;
 
-  readReply[DATA_LENGTH_IN_BYTES] = queryReply[0]; // remember to restore
-                                                   // correct RN before doing
-                                                   // crc()
-  readReply[DATA_LENGTH_IN_BYTES+1] = queryReply[1]; // because crc() will shift
-                                                     // bits to add
-  crc16_ccitt_readReply(DATA_LENGTH_IN_BYTES);     // leading "0" bit.
+  readReply[PAYLOAD_BYTES] = queryReply[0]; // remember to restore
+                                             // correct RN before doing
+                                             // crc()
+  readReply[PAYLOAD_BYTES+1] = queryReply[1]; // because crc() will shift
+                                               // bits to add
+  crc16_ccitt_readReply(readReply, PAYLOAD_BYTES); // leading "0" bit.
 
-  // DATA_LENGTH_IN_BYTES*8 bits for data + 16 bits for the handle + 16 bits for
-  // the CRC + leading 0 + add one to number of bits for xmit code
-  sendToReader(&readReply[0], ((DATA_LENGTH_IN_BYTES*8)+16+16+1+1));
+  // PAYLOAD_BYTES*8 bits for header and data + 16 bits for the handle + 16
+  // bits for the CRC + leading 0 + add one to number of bits for xmit code
+  sendToReader(&readReply[0], ((PAYLOAD_BYTES*8)+16+16+1+1));
   state = nextState;
   delimiterNotFound = 1;
 
@@ -664,7 +738,7 @@ void handle_read(volatile short nextState)
   readReply[2] = queryReply[0]; // remember to restore correct RN before doing
                                 // crc()
   readReply[3] = queryReply[1]; // because crc() will shift bits to add
-  crc16_ccitt_readReply(2);     // leading "0" bit.
+  crc16_ccitt_readReply(readReply, 2); // leading "0" bit.
 
   // after that sends tagResponse
   // 16 bits for data + 16 bits for the handle + 16 bits for the CRC + leading 0
@@ -677,6 +751,7 @@ void handle_read(volatile short nextState)
 
 void handle_nak(volatile short nextState)
 {
+  COMM_COUNT(COMM_NAK);
   TACCTL1 &= ~CCIE;
   TAR = 0;
   state = nextState;
@@ -32,8 +32,6 @@
 
 extern volatile short state;
 extern volatile unsigned char command;
-extern unsigned short rn16;
-extern unsigned int epc;
 extern unsigned short divideRatio;
 extern unsigned short linkFrequency;
 extern unsigned char subcarrierNum;
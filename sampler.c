@@ -0,0 +1,138 @@
+/* See license.txt for license information. */
+
+#include "dlwisp41.h"
+#include "mywisp.h"
+#include "sampler.h"
+#include "adc_seq.h"
+#include "pack.h"
+
+#if BACKGROUND_SAMPLING
+
+unsigned short sample_ring[SAMPLE_RING_FRAMES][SAMPLE_SEQ_LEN];
+unsigned short sample_stamp[SAMPLE_RING_FRAMES]; // tick each frame was taken
+volatile unsigned char sample_head = 0;
+volatile unsigned char sample_tail = 0;
+unsigned short sample_overruns = 0; // ticks dropped because the ring was full
+
+static unsigned char sample_pending = 0; // a sequence is filling frame head
+static unsigned short sample_tick = 0;   // ticks since sampler_start()
+
+static const unsigned char sample_slot[SAMPLE_CHANNELS] = { SAMPLE_SLOT_LIST };
+
+void sampler_start()
+{
+  ACLK_SETUP;
+
+  // power the sensor and leave it on; it has a whole sample period to settle
+  // before the first tick
+  SENSOR_POWER_ON;
+  ADC10AE0 |= SAMPLE_ADC10AE;
+
+  sample_pending = 0;
+  sample_tick = 0;
+
+  TA1CTL = 0;
+  TA1CCR0 = SAMPLE_PERIOD_TICKS;
+  TA1CCTL0 = CCIE;
+  TA1CTL = TASSEL_1 + MC_1 + TACLR;  // ACLK, up mode
+}
+
+void sampler_stop()
+{
+  TA1CTL = 0;
+  TA1CCTL0 = 0;
+
+  // a sequence that's still running stops into a frame nobody commits.
+  // sleep() calls this with GIE off, so the ADC10 interrupt can't be waited
+  // for.
+  adc_seq_abort();
+  sample_pending = 0;
+
+  SENSOR_POWER_OFF;
+  ADC10AE0 &= ~SAMPLE_ADC10AE;
+  ADC10CTL1 = 0;       // turn adc off
+}
+
+// Copy the oldest <i>frames</i> frames into target, channels in reply order,
+// in the same payload format the sensor drivers use (see pack.h), and set
+// *first to the tick the first of them was taken on. The frames in one batch
+// have to be back to back; if ticks were dropped in between, the frames
+// before the gap are thrown away (the reader sees the gap from the index).
+// Returns <i>frames</i>, or 0 if there aren't that many in a row yet.
+unsigned char sampler_read(unsigned char volatile *target, unsigned char frames,
+                           unsigned short *first)
+{
+  unsigned short out[SAMPLE_FRAMES_PER_READ * SAMPLE_CHANNELS];
+  unsigned short *o = out;
+  unsigned char tail, n;
+
+  for ( ;; )
+  {
+    tail = sample_tail;
+    if ( (unsigned char)(sample_head - tail) < frames )
+      return 0;
+
+    for ( n = 1; n < frames; n++ )
+      if ( sample_stamp[(tail + n) & SAMPLE_RING_MASK] !=
+           (unsigned short)(sample_stamp[tail & SAMPLE_RING_MASK] + n) )
+        break;
+    if ( n == frames )
+      break;
+
+    sample_tail = tail + n;
+  }
+
+  *first = sample_stamp[tail & SAMPLE_RING_MASK];
+
+  for ( n = 0; n < frames; n++ )
+  {
+    unsigned short *frame = sample_ring[(tail + n) & SAMPLE_RING_MASK];
+
+    for ( int c = 0; c < SAMPLE_CHANNELS; c++ )
+      *o++ = frame[sample_slot[c]];
+  }
+  sample_tail = tail + frames;
+
+  pack_samples(target, out, frames * SAMPLE_CHANNELS);
+
+  return frames;
+}
+
+// Sample clock. Commits the frame the last tick's sequence filled in, then
+// starts the next one; the ADC runs off its own oscillator and the DTC stores
+// the results, so this is over in a few dozen cycles and never waits on the
+// converter. Doesn't wake the CPU.
+#pragma vector=TIMER1_A0_VECTOR
+__interrupt void sampler_ISR(void)
+{
+  unsigned char head = sample_head;
+  unsigned short tick = sample_tick++;
+
+  if ( sample_pending )
+  {
+    if ( adc_seq_busy )
+    {
+      // still converting a whole period later -- only if something else
+      // held the ADC; try again next tick
+      sample_overruns++;
+      return;
+    }
+    sample_pending = 0;
+    sample_head = ++head;
+  }
+
+  if ( (unsigned char)(head - sample_tail) >= SAMPLE_RING_FRAMES )
+  {
+    // nobody has drained the ring; skip this tick rather than overwrite
+    // samples that haven't been sent yet
+    sample_overruns++;
+    return;
+  }
+
+  sample_stamp[head & SAMPLE_RING_MASK] = tick;
+  adc_seq_start(sample_ring[head & SAMPLE_RING_MASK], SAMPLE_SEQ_LEN,
+                SAMPLE_ADC10CTL0, SAMPLE_ADC10CTL1 + SAMPLE_SEQ_INCH);
+  sample_pending = 1;
+}
+
+#endif // BACKGROUND_SAMPLING
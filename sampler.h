@@ -0,0 +1,92 @@
+/* See license.txt for license information. */
+
+#ifndef SAMPLER_H
+#define SAMPLER_H
+
+/*
+ * Background sensor acquisition (BACKGROUND_SAMPLING in mywisp.h).
+ *
+ * Timer1_A runs in up mode from ACLK and interrupts at SAMPLE_RATE_HZ. Each
+ * tick starts one ADC10 sequence (see adc_seq.h) that the DTC drops straight
+ * into the next frame of the RAM ring below, whatever the protocol state
+ * machine happens to be doing. The frame is committed on the following tick,
+ * so the newest sample shows up one period late. The main loop drains frames
+ * into the EPC or the Read reply with sampler_read().
+ *
+ * Each sensor header that supports this mode defines:
+ *   SAMPLE_SEQ_INCH      top channel of the sequence (INCH_x)
+ *   SAMPLE_SEQ_LEN       words per sequence, i.e. top channel + 1
+ *   SAMPLE_CHANNELS      channels per frame that go into the reply
+ *   SAMPLE_SLOT_LIST     their positions in the sequence, in reply order
+ *   SAMPLE_ADC10AE       ADC10AE0 bits for those channels
+ *   SAMPLE_ADC10CTL0     ADC10CTL0 setting (reference, sample time)
+ *   SAMPLE_ADC10CTL1     ADC10CTL1 setting, minus the INCH_x bits
+ *   SENSOR_POWER_ON/OFF  how to power the sensor up and down
+ *
+ * Frames go out in the sample payload format (pack.h), one frame after the
+ * other. With PACKED_SAMPLES more of them fit in the EPC. Each frame is
+ * stamped with the tick it was taken on, and the payload header (payload.h)
+ * carries the stamp of the first one, so ticks lost to overruns show up as
+ * gaps on the reader side.
+ *
+ * Notes:
+ *  - ACLK has to keep running, so the tag listens in LPM3 instead of LPM4
+ *    while sampling. sleep() still uses LPM4 and stops the sampler.
+ *  - Port1_ISR holds the tick off from a command's first edge until
+ *    setup_to_receive(), and sendToReader() while it backscatters, because
+ *    the decode and the transmit loop are cycle-counted. A pending tick is
+ *    serviced right after, so that sample comes late; a command and reply
+ *    longer than a whole sample period lose a tick.
+ *  - Timer1_A belongs to the sampler.
+ */
+
+#include "mywisp.h"
+
+#if BACKGROUND_SAMPLING
+
+#if !defined(SAMPLE_CHANNELS)
+#error "BACKGROUND_SAMPLING is not supported by the active sensor"
+#endif
+
+#if ECG_HW_CLOCK
+#error "BACKGROUND_SAMPLING and ECG_HW_CLOCK both want the ADC10"
+#endif
+
+#define SAMPLE_PERIOD_TICKS       ((ACLK_HZ / SAMPLE_RATE_HZ) - 1)
+#define SAMPLE_RING_MASK          (SAMPLE_RING_FRAMES - 1)
+
+// whole frames that fit in the reply after the payload header: the rest of
+// the EPC, or the sensor's Read payload
+#if DATA_IN_EPC
+#define SAMPLE_PAYLOAD_BYTES      EPC_DATA_BYTES
+#else
+#define SAMPLE_PAYLOAD_BYTES      DATA_LENGTH_IN_BYTES
+#endif
+#if PACKED_SAMPLES
+#define SAMPLE_FRAMES_PER_READ \
+  ((SAMPLE_PAYLOAD_BYTES * 8) / (SAMPLE_CHANNELS * PACKED_SAMPLE_BITS))
+#else
+#define SAMPLE_FRAMES_PER_READ    (SAMPLE_PAYLOAD_BYTES / (2*SAMPLE_CHANNELS))
+#endif
+#if (SAMPLE_FRAMES_PER_READ == 0)
+#error "a sample frame doesn't fit the payload, see PACKED_SAMPLES"
+#endif
+
+// The ISR only ever writes sample_head, the main loop only ever writes
+// sample_tail. Both are free-running; the difference is the fill level.
+extern unsigned short sample_ring[SAMPLE_RING_FRAMES][SAMPLE_SEQ_LEN];
+extern unsigned short sample_stamp[SAMPLE_RING_FRAMES];
+extern volatile unsigned char sample_head;
+extern volatile unsigned char sample_tail;
+extern unsigned short sample_overruns;
+
+#define sampler_frames()          ((unsigned char)(sample_head - sample_tail))
+
+void sampler_start();
+void sampler_stop();
+unsigned char sampler_read(unsigned char volatile *target, unsigned char frames,
+                           unsigned short *first);
+
+#endif // BACKGROUND_SAMPLING
+
+#endif // SAMPLER_H
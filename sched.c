@@ -0,0 +1,43 @@
+/* See license.txt for license information. */
+
+#include "dlwisp41.h"
+#include "mywisp.h"
+#include "sched.h"
+
+#if SCHEDULED_SAMPLING
+
+volatile unsigned short sched_ticks = 0;
+volatile unsigned short sched_seconds = 0;
+
+static unsigned char sched_subticks = 0;
+
+// Kept across a fast resume: the deadlines in sensors.c are in the same
+// ticks, so the count carries on where it stopped.
+void sched_start()
+{
+  ACLK_SETUP;
+
+  TA1CTL = 0;
+  TA1CCR0 = SCHED_PERIOD_TICKS;
+  TA1CCTL0 = CCIE;
+  TA1CTL = TASSEL_1 + MC_1 + TACLR;  // ACLK, up mode
+}
+
+// Scheduler tick. Wakes the main loop while a reading is due; its next
+// timeout takes it (see sensors_due()).
+#pragma vector=TIMER1_A0_VECTOR
+__interrupt void sched_ISR(void)
+{
+  unsigned short now = ++sched_ticks;
+
+  if ( ++sched_subticks == SCHED_TICK_HZ )
+  {
+    sched_subticks = 0;
+    sched_seconds++;
+  }
+
+  if ( (short)(now - sensors_wake_at) >= 0 )
+    LPM3_EXIT;
+}
+
+#endif // SCHEDULED_SAMPLING
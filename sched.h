@@ -0,0 +1,57 @@
+/* See license.txt for license information. */
+
+#ifndef SCHED_H
+#define SCHED_H
+
+/*
+ * Time-based sampling (SCHEDULED_SAMPLING in mywisp.h).
+ *
+ * Timer1_A runs in up mode from ACLK and ticks at SCHED_TICK_HZ. The sensor
+ * periods of step 2(j) then count these ticks instead of sample slots. Each
+ * sensor has a deadline, the tick its next reading is due on, and deadlines
+ * move on by whole periods however late the reading was actually taken, so
+ * the rate doesn't drift (see sensors.c).
+ *
+ * Once the earliest deadline has come, every tick wakes the CPU. The main
+ * loop takes the reading at its next timeout, i.e. in the first gap between
+ * reader commands, whether or not the reader has been talking to us.
+ *
+ * Notes:
+ *  - ACLK has to keep running, so the tag listens in LPM3 instead of LPM4,
+ *    and a driver waiting on its conversions in adc_seq.c sleeps in LPM3
+ *    too. A tick lost there would put every later deadline back; see
+ *    host/bench/sched_bench.c. Timer0_A is left to the receive and transmit
+ *    code.
+ *  - Port1_ISR holds the tick off from a command's first edge until
+ *    setup_to_receive(), and sendToReader() while it backscatters; a pending
+ *    tick is serviced right after. A command and reply are far shorter than
+ *    a tick.
+ *  - ACLK stops in LPM4, so time stands still while sleep() waits for power.
+ *    Deadlines missed while the tag was awake but busy show up as gaps in
+ *    the sensor's sample index.
+ *  - Timer1_A belongs to the scheduler.
+ */
+
+#include "mywisp.h"
+
+#if SCHEDULED_SAMPLING
+
+#if !READ_SENSOR
+#error "SCHEDULED_SAMPLING needs one of the sensor applications"
+#endif
+
+#if BACKGROUND_SAMPLING || ECG_HW_CLOCK || RR_INTERVALS_IN_ID
+#error "the streaming modes are paced by their own sample clocks"
+#endif
+
+#define SCHED_PERIOD_TICKS        ((ACLK_HZ / SCHED_TICK_HZ) - 1)
+
+// ticks, and whole seconds, since the first sched_start()
+extern volatile unsigned short sched_ticks;
+extern volatile unsigned short sched_seconds;
+
+void sched_start();
+
+#endif // SCHEDULED_SAMPLING
+
+#endif // SCHED_H
@@ -0,0 +1,177 @@
+/* See license.txt for license information. */
+
+#include "dlwisp41.h"
+#include "rfid.h"
+#include "mywisp.h"
+#include "sensors.h"
+#include "sched.h"
+#include "energy.h"
+
+#if READ_SENSOR
+
+unsigned char sensor_busy = 0;
+
+typedef struct {
+  const sensor_driver *driver;
+  unsigned short period;        // slots (or ticks) between readings
+} sensor_entry;
+
+static const sensor_entry sensor_table[SENSORS_IN_IMAGE] = {
+#if ECG_PERIOD
+  { &ecg_driver, ECG_PERIOD },
+#endif
+#if ACCEL_PERIOD
+  { &accel_driver, ACCEL_PERIOD },
+#endif
+#if QUICK_ACCEL_PERIOD
+  { &quick_accel_driver, QUICK_ACCEL_PERIOD },
+#endif
+#if OVERSAMPLED_ACCEL_PERIOD
+  { &oversampled_accel_driver, OVERSAMPLED_ACCEL_PERIOD },
+#endif
+#if INT_TEMP_PERIOD
+  { &int_temp_driver, INT_TEMP_PERIOD },
+#endif
+#if NULL_SENSOR_PERIOD
+  { &null_driver, NULL_SENSOR_PERIOD },
+#endif
+#if HEALTH_PERIOD
+  { &health_driver, HEALTH_PERIOD },
+#endif
+#if COMM_STATS_PERIOD
+  { &comm_stats_driver, COMM_STATS_PERIOD },
+#endif
+};
+
+static unsigned short sensor_deadline[SENSORS_IN_IMAGE]; // next one due
+unsigned short sensor_index[SENSORS_IN_IMAGE];           // its sample index
+volatile unsigned short sensors_wake_at = 0;  // earliest deadline
+unsigned short sensor_misses = 0;             // deadlines gone by unread
+
+#if !SCHEDULED_SAMPLING
+static unsigned short sensor_slot = 0;        // sensors_read() calls
+#endif
+
+#if ENERGY_POLICY
+static unsigned short sensor_cost[SENSORS_IN_IMAGE]; // learned, see energy.h
+#endif
+
+// deadline t has come by now (both wrap at 2^16)
+#define SENSOR_DUE(t, now)        ((short)((now) - (t)) >= 0)
+
+void sensors_init()
+{
+  unsigned char i;
+
+  for ( i = 0; i < SENSORS_IN_IMAGE; i++ )
+  {
+    if ( sensor_table[i].driver->init )
+      sensor_table[i].driver->init();
+  }
+}
+
+// Wake for the earliest deadline.
+static void sensors_plan()
+{
+  unsigned char i;
+
+  sensors_wake_at = sensor_deadline[0];
+  for ( i = 1; i < SENSORS_IN_IMAGE; i++ )
+  {
+    if ( (short)(sensor_deadline[i] - sensors_wake_at) < 0 )
+      sensors_wake_at = sensor_deadline[i];
+  }
+}
+
+unsigned char sensors_due()
+{
+#if SCHEDULED_SAMPLING
+  return SENSOR_DUE(sensors_wake_at, sched_ticks);
+#else
+  return SENSOR_DUE(sensors_wake_at, sensor_slot);
+#endif
+}
+
+unsigned char sensors_read(unsigned char volatile *target, unsigned char *type,
+                           unsigned short *first)
+{
+  const sensor_driver *d;
+  unsigned short now, period;
+  unsigned char i, s, fresh;
+
+#if SCHEDULED_SAMPLING
+  now = sched_ticks;
+#else
+  now = sensor_slot++;
+#endif
+
+  // earliest deadline first, so a fast sensor can't keep a slow one out
+  s = SENSORS_IN_IMAGE;
+  for ( i = 0; i < SENSORS_IN_IMAGE; i++ )
+  {
+    if ( SENSOR_DUE(sensor_deadline[i], now) &&
+         (s == SENSORS_IN_IMAGE ||
+          (short)(sensor_deadline[i] - sensor_deadline[s]) < 0) )
+      s = i;
+  }
+  if ( s == SENSORS_IN_IMAGE )
+    return 0;
+
+  period = sensor_table[s].period;
+
+#if ENERGY_POLICY
+  // too little in the cap: this reading is off, try again at the next
+  // deadline. Left due, it would have the scheduler wake us on every tick
+  // for another vcap_read(). Its index goes too, so the reader sees the gap.
+  if ( !energy_allow(sensor_cost[s]) )
+  {
+    sensor_deadline[s] += period;
+    sensor_index[s]++;
+    sensors_plan();
+    return 0;
+  }
+#endif
+
+  // deadlines that went by while it waited are readings it won't get; skip
+  // their indexes so the reader sees the gap
+  while ( (short)(now - sensor_deadline[s]) >= (short)period )
+  {
+    sensor_deadline[s] += period;
+    sensor_index[s]++;
+    sensor_misses++;
+  }
+  sensor_deadline[s] += period;
+  sensors_plan();
+
+  d = sensor_table[s].driver;
+
+  if(!is_power_good())
+    sleep();
+
+  P1OUT &= ~RX_EN_PIN;   // turn off comparator
+
+  sensor_busy = 1;
+  if ( d->start )
+    d->start();
+  fresh = d->collect(target);
+  sensor_busy = 0;
+
+#if ENERGY_POLICY
+  energy_spent(&sensor_cost[s]);
+#endif
+
+  *type = d->type;
+  *first = sensor_index[s]++;
+  sensor_counter++;
+
+  if ( fresh )
+  {
+    // a shorter reading than the payload has room for
+    for ( i = d->bytes; i < DATA_LENGTH_IN_BYTES; i++ )
+      target[i] = 0;
+  }
+
+  return fresh;
+}
+
+#endif // READ_SENSOR
@@ -0,0 +1,130 @@
+/* See license.txt for license information. */
+
+#ifndef SENSORS_H
+#define SENSORS_H
+
+/*
+ * Sensor drivers and the registry that runs them (see step 2(j) in
+ * mywisp.h).
+ *
+ * Each sensor module exports one sensor_driver:
+ *   type     sensor type byte for the payload header (payload.h)
+ *   bytes    payload bytes one reading takes
+ *   init     called once at boot, or NULL
+ *   start    power the sensor up, or NULL. Called with the comparator off
+ *            and power known to be good, right before collect.
+ *   collect  settle, convert, power the sensor down and write the reading
+ *            to target. Returns 0 if there's nothing new to report
+ *            (REPORT_ON_CHANGE).
+ *
+ * Every sensor with a nonzero period is linked into the image. Periods
+ * count sample slots (STATE_READ_SENSOR passes), or scheduler ticks with
+ * SCHEDULED_SAMPLING (sched.h). Each sensor has a deadline that moves on by
+ * one period per reading; sensors_read() reads the one whose deadline is
+ * earliest, so several sensors due together go out one after the other.
+ * The payload header carries that sensor's type, and the first-sample index
+ * counts that sensor's periods, so the reader can keep one stream per type
+ * (host/wisp_stream.h). A deadline that goes by before the sensor gets a
+ * turn is skipped, which shows up as a gap in its index.
+ *
+ * The streaming modes (BACKGROUND_SAMPLING, ECG_HW_CLOCK, RR_INTERVALS_IN_ID)
+ * own the ADC10 and run ACTIVE_SENSOR only.
+ */
+
+#include "mywisp.h"
+
+typedef struct {
+  unsigned char type;
+  unsigned char bytes;
+  void (*init)(void);
+  void (*start)(void);
+  unsigned char (*collect)(unsigned char volatile *target);
+} sensor_driver;
+
+// Slots (ticks) between readings of each sensor; 0 leaves it out of the image.
+// ACTIVE_SENSOR is always in, every slot unless step 2(j) says otherwise.
+#define NULL_SENSOR_PERIOD        (SENSOR_NULL_EVERY ? SENSOR_NULL_EVERY : \
+                                   (ACTIVE_SENSOR == SENSOR_NULL))
+#define ACCEL_PERIOD              (SENSOR_ACCEL_EVERY ? SENSOR_ACCEL_EVERY : \
+                                   (ACTIVE_SENSOR == SENSOR_ACCEL))
+#define QUICK_ACCEL_PERIOD        (SENSOR_ACCEL_QUICK_EVERY ? \
+                                   SENSOR_ACCEL_QUICK_EVERY : \
+                                   (ACTIVE_SENSOR == SENSOR_ACCEL_QUICK))
+#define INT_TEMP_PERIOD           (SENSOR_INTERNAL_TEMP_EVERY ? \
+                                   SENSOR_INTERNAL_TEMP_EVERY : \
+                                   (ACTIVE_SENSOR == SENSOR_INTERNAL_TEMP))
+#define ECG_PERIOD                (SENSOR_ECG_EVERY ? SENSOR_ECG_EVERY : \
+                                   (ACTIVE_SENSOR == SENSOR_ECG))
+#define OVERSAMPLED_ACCEL_PERIOD  (SENSOR_ACCEL_OVERSAMPLED_EVERY ? \
+                                   SENSOR_ACCEL_OVERSAMPLED_EVERY : \
+                                   (ACTIVE_SENSOR == SENSOR_ACCEL_OVERSAMPLED))
+#define HEALTH_PERIOD             (SENSOR_HEALTH_EVERY ? SENSOR_HEALTH_EVERY : \
+                                   (ACTIVE_SENSOR == SENSOR_HEALTH))
+#define COMM_STATS_PERIOD         (SENSOR_COMM_STATS_EVERY ? \
+                                   SENSOR_COMM_STATS_EVERY : \
+                                   (ACTIVE_SENSOR == SENSOR_COMM_STATS))
+
+#if (ACTIVE_SENSOR == SENSOR_EXTERNAL_TEMP)
+#error "SENSOR_EXTERNAL_TEMP not yet implemented"
+#endif
+
+#include "null_sensor.h"
+#include "accel_sensor.h"
+#include "quick_accel_sensor.h"
+#include "int_temp_sensor.h"
+#include "ecg_sensor_nolan.h"
+#include "oversampled_accel_sensor.h"
+#include "health_sensor.h"
+#include "comm_stats_sensor.h"
+
+#define SENSORS_IN_IMAGE          ((NULL_SENSOR_PERIOD != 0) + \
+                                   (ACCEL_PERIOD != 0) + \
+                                   (QUICK_ACCEL_PERIOD != 0) + \
+                                   (INT_TEMP_PERIOD != 0) + \
+                                   (ECG_PERIOD != 0) + \
+                                   (OVERSAMPLED_ACCEL_PERIOD != 0) + \
+                                   (HEALTH_PERIOD != 0) + \
+                                   (COMM_STATS_PERIOD != 0))
+
+#if (SENSORS_IN_IMAGE > 1) && \
+    (BACKGROUND_SAMPLING || ECG_HW_CLOCK || RR_INTERVALS_IN_ID)
+#error "the streaming modes run ACTIVE_SENSOR only, leave step 2(j) at 0"
+#endif
+
+// Payload room: the biggest reading of any sensor in the image. Shorter ones
+// are padded with zeros.
+#define SENSOR_MAX(a, b)          ((a) > (b) ? (a) : (b))
+#define NULL_SENSOR_ROOM          (NULL_SENSOR_PERIOD ? NULL_SENSOR_BYTES : 0)
+#define ACCEL_ROOM                (ACCEL_PERIOD ? ACCEL_DATA_BYTES : 0)
+#define QUICK_ACCEL_ROOM          (QUICK_ACCEL_PERIOD ? \
+                                   QUICK_ACCEL_DATA_BYTES : 0)
+#define INT_TEMP_ROOM             (INT_TEMP_PERIOD ? INT_TEMP_DATA_BYTES : 0)
+#define ECG_ROOM                  (ECG_PERIOD ? ECG_DATA_BYTES : 0)
+#define OVERSAMPLED_ACCEL_ROOM    (OVERSAMPLED_ACCEL_PERIOD ? \
+                                   OVERSAMPLED_ACCEL_DATA_BYTES : 0)
+#define HEALTH_ROOM               (HEALTH_PERIOD ? HEALTH_DATA_BYTES : 0)
+#define COMM_STATS_ROOM           (COMM_STATS_PERIOD ? \
+                                   COMM_STATS_DATA_BYTES : 0)
+#define DATA_LENGTH_IN_BYTES \
+  SENSOR_MAX(SENSOR_MAX(SENSOR_MAX(NULL_SENSOR_ROOM, ACCEL_ROOM), \
+                        SENSOR_MAX(QUICK_ACCEL_ROOM, INT_TEMP_ROOM)), \
+             SENSOR_MAX(SENSOR_MAX(ECG_ROOM, OVERSAMPLED_ACCEL_ROOM), \
+                        SENSOR_MAX(HEALTH_ROOM, COMM_STATS_ROOM)))
+
+extern unsigned char sensor_busy;
+extern volatile unsigned short sensors_wake_at; // earliest deadline
+extern unsigned short sensor_misses;            // deadlines skipped
+extern unsigned short sensor_index[];           // readings, per sensor
+
+void sensors_init();
+
+// A reading is due.
+unsigned char sensors_due();
+
+// Read the next sensor due into target. Sets *type and *first (that sensor's
+// reading count) and returns 1, or returns 0 if there's nothing new for the
+// payload (no sensor due, or an unchanged reading with REPORT_ON_CHANGE).
+unsigned char sensors_read(unsigned char volatile *target, unsigned char *type,
+                           unsigned short *first);
+
+#endif // SENSORS_H
@@ -0,0 +1,88 @@
+/* See license.txt for license information. */
+
+#include "dlwisp41.h"
+#include "mywisp.h"
+#include "settle.h"
+#include "adc_seq.h"
+
+#if ADAPTIVE_SETTLE
+
+// average passes to settle, per channel, times 4
+static unsigned char settle_learned[SETTLE_MAX_CHANNELS];
+
+unsigned char settle_passes = 0;
+
+unsigned char settle_sensor(unsigned char n, unsigned short ctl1,
+                            unsigned char max_passes)
+{
+  unsigned short a[SETTLE_MAX_CHANNELS], b[SETTLE_MAX_CHANNELS];
+  unsigned short *prev = a, *cur = b, *t;
+  unsigned char since[SETTLE_MAX_CHANNELS]; // pass the channel stopped moving
+  unsigned char blind = 0, pass, c, still = 0;
+
+  for ( c = 0; c < n; c++ )
+  {
+    if ( settle_learned[c] > blind )
+      blind = settle_learned[c];
+    since[c] = 0;
+  }
+  blind = (blind * 3) >> 4;   // 3/4 of the slowest channel, in passes
+
+  WDTCTL = WDT_MDLY_0_5;
+  IE1 |= WDTIE;
+
+  for ( pass = 1; pass <= max_passes; pass++ )
+  {
+    _BIS_SR(LPM1_bits + GIE);
+    if ( pass <= blind )
+      continue;
+
+    adc_seq_read(cur, n, SREF_0 + ADC10SHT_0, ctl1);
+
+    if ( pass > blind + 1 )
+    {
+      still = 1;
+      for ( c = 0; c < n; c++ )
+      {
+        unsigned short d = (cur[c] > prev[c]) ? cur[c] - prev[c] :
+                                                prev[c] - cur[c];
+        if ( d > SETTLE_TOLERANCE )
+        {
+          since[c] = 0;
+          still = 0;
+        }
+        else if ( since[c] == 0 )
+        {
+          since[c] = pass - 1;
+        }
+      }
+      if ( still )
+        break;
+    }
+
+    t = prev; prev = cur; cur = t;
+  }
+
+  IE1 &= ~WDTIE;
+  WDTCTL = WDTPW + WDTHOLD;
+
+  if ( pass > max_passes )
+    pass = max_passes;
+  settle_passes = pass;
+
+  // learned += passes - learned/4, so it settles at 4x the typical count. A
+  // channel that never stopped moving counts as the whole wait.
+  for ( c = 0; c < n; c++ )
+    settle_learned[c] += (since[c] ? since[c] : pass) -
+                         (settle_learned[c] >> 2);
+
+  return still;
+}
+
+#pragma vector=WDT_VECTOR
+__interrupt void settle_wdt_ISR(void)
+{
+  LPM4_EXIT;
+}
+
+#endif // ADAPTIVE_SETTLE
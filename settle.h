@@ -0,0 +1,41 @@
+/* See license.txt for license information. */
+
+#ifndef SETTLE_H
+#define SETTLE_H
+
+/*
+ * Adaptive sensor settle time (ADAPTIVE_SETTLE in mywisp.h).
+ *
+ * After the sensor is powered, its outputs and filter caps take a while to
+ * come up. Rather than always sleep through the worst case, settle_sensor()
+ * wakes every watchdog interval (WDT_MDLY_0_5, in LPM1) and runs one cheap
+ * sequence over the sensor's channels: shortest sample-and-hold, results
+ * thrown away. Once two passes in a row agree within SETTLE_TOLERANCE on
+ * every channel, the sensor is taken to have settled and the caller takes the
+ * real sample.
+ *
+ * For each channel it remembers how many passes it took to stop moving
+ * (a running average). The next call sleeps through 3/4 of the slowest
+ * channel's average before it starts converting, so a sensor that settles
+ * the same way every time costs about two checking passes.
+ *
+ * The watchdog interrupt lives here while ADAPTIVE_SETTLE is on.
+ */
+
+#include "mywisp.h"
+
+#if ADAPTIVE_SETTLE
+
+#define SETTLE_MAX_CHANNELS       4
+
+// passes the last settle_sensor() call took, for tuning
+extern unsigned char settle_passes;
+
+// Wait for the n channels of the sequence in ctl1 (as for adc_seq_read()) to
+// settle, for at most max_passes watchdog intervals. Returns 1 if they did.
+unsigned char settle_sensor(unsigned char n, unsigned short ctl1,
+                            unsigned char max_passes);
+
+#endif // ADAPTIVE_SETTLE
+
+#endif // SETTLE_H
@@ -0,0 +1,121 @@
+/* See license.txt for license information. */
+
+#include "dlwisp41.h"
+#include "user_bank.h"
+
+#if ARCHIVE_SAMPLES
+
+// a line that holds nothing
+#define UB_NONE                   (-1)
+
+static unsigned char ub_line[2][USER_BANK_LINE_BYTES];
+static int ub_addr[2] = { UB_NONE, UB_NONE };   // EEPROM address of each
+static unsigned char ub_keep = 0;   // the line the last Read came out of
+static unsigned char ub_into = 0;   // the line ub_fetch fills
+static int ub_want = UB_NONE;       // the address it fills it from
+static int ub_next = UB_NONE;       // what to fetch after the reply
+static i2c_request ub_fetch;
+
+void user_bank_init()
+{
+  ub_addr[0] = UB_NONE;
+  ub_addr[1] = UB_NONE;
+  ub_want = UB_NONE;
+  ub_next = UB_NONE;
+  ub_fetch.status = I2C_IDLE;
+}
+
+// Take in a fetch that has finished. One that NACKed (the chip was busy
+// with a write cycle) is fetched again when a Read wants it.
+static void ub_settle()
+{
+  if ( ub_fetch.status == I2C_PENDING )
+    return;
+  if ( ub_want != UB_NONE && ub_fetch.status == I2C_DONE )
+    ub_addr[ub_into] = ub_want;
+  ub_want = UB_NONE;
+}
+
+// The cache line holding address line, or 2.
+static unsigned char ub_find(int line)
+{
+  if ( ub_addr[0] == line )
+    return 0;
+  if ( ub_addr[1] == line )
+    return 1;
+  return 2;
+}
+
+unsigned char user_bank_read(unsigned short ptr, unsigned char count,
+                             volatile unsigned char *reply)
+{
+  int at, end, line;
+  unsigned char i, n, k;
+
+  ub_settle();
+  ub_next = UB_NONE;
+  if ( count == 0 || count > USER_BANK_READ_MAX ||
+       ptr > USER_BANK_WORDS - count )
+    return 0;
+
+  // up to two lines' worth, if the Read isn't on a line
+  at = ptr * 2;
+  end = at + count * 2;
+  while ( at < end )
+  {
+    line = at & ~(USER_BANK_LINE_BYTES-1);
+    k = ub_find(line);
+    if ( k > 1 )
+    {
+      ub_next = line;
+      return 0;
+    }
+    n = USER_BANK_LINE_BYTES - (at - line);
+    if ( n > end - at )
+      n = end - at;
+    for ( i = at - line; n > 0; n-- )
+    {
+      *reply++ = ub_line[k][i++];
+      at++;
+    }
+    ub_keep = k;
+  }
+
+  // read ahead: the reader will most likely want the next line
+  line = at;
+  if ( line & (USER_BANK_LINE_BYTES-1) )
+    line = (line | (USER_BANK_LINE_BYTES-1)) + 1;
+  if ( line < EEPROM_BYTES && ub_find(line) > 1 )
+    ub_next = line;
+  return 1;
+}
+
+// The line the last Read came out of stays, in case the reader missed the
+// reply and asks again; the fetch goes into the other one.
+void user_bank_prefetch()
+{
+  if ( ub_next == UB_NONE || ub_fetch.status == I2C_PENDING )
+    return;
+
+  ub_into = ub_keep ^ 1;
+  ub_addr[ub_into] = UB_NONE;
+  ub_want = ub_next;
+  ub_next = UB_NONE;
+  eeprom_request(&ub_fetch, ub_want, ub_line[ub_into], USER_BANK_LINE_BYTES,
+                 1);
+  i2c_submit(&ub_fetch);
+}
+
+void user_bank_forget(int address)
+{
+  int line = address & ~(USER_BANK_LINE_BYTES-1);
+
+  if ( ub_addr[0] == line )
+    ub_addr[0] = UB_NONE;
+  if ( ub_addr[1] == line )
+    ub_addr[1] = UB_NONE;
+  if ( ub_want == line )
+    ub_want = UB_NONE;      // it may have read the old words
+}
+
+#endif // ARCHIVE_SAMPLES
@@ -0,0 +1,71 @@
+/* See license.txt for license information. */
+
+#ifndef USER_BANK_H
+#define USER_BANK_H
+
+/*
+ * The sample archive (archive.h) as the User memory bank, for the Read
+ * command (MemBank 3).
+ *
+ * User word w is EEPROM bytes 2w and 2w+1, MSB first: the bank is the chip
+ * as it is, USER_BANK_WORDS long, and archive slot s is the 8 words from
+ * 8s. A reader reads the slots it wants, 8 words at a time, and sorts the
+ * records out itself (host/wisp_archive.c).
+ *
+ * A Read has to be answered within T1, tens of microseconds, and fetching
+ * even one word over I2C takes longer than that. So Reads are answered out
+ * of a RAM cache of two lines, an EEPROM page each. A Read that falls in
+ * the cache is answered at once, and the line after it is fetched as soon
+ * as the reply is out, ready for the reader's next Read. One that doesn't
+ * fall in the cache gets no reply, which a reader takes as a miss and
+ * tries again; the line is fetched meanwhile.
+ *
+ * Notes:
+ *  - The fetch runs in the I2C engine's own time (i2c.h): while the tag
+ *    listens between commands, not while a command comes in or a reply
+ *    goes out. How many Reads miss depends on how long the reader leaves
+ *    between them.
+ *  - WordPtr is an EBV; from word 128 on it takes two bytes and the Read
+ *    comes 8 bits longer. Wait for USER_BANK_READ_BITS rather than
+ *    NUM_READ_BITS.
+ *  - Reads past the end, of more than USER_BANK_READ_MAX words, or of 0
+ *    (the whole bank) get no reply.
+ *  - archive_put() drops its page from the cache, so a Read never gets
+ *    words older than the chip's.
+ */
+
+#include "mywisp.h"
+#include "rfid.h"
+#include "eeprom.h"
+
+#if ARCHIVE_SAMPLES
+
+#define MEMBANK_USER              3
+
+#define USER_BANK_WORDS           (EEPROM_BYTES / 2)
+#define USER_BANK_LINE_BYTES      EEPROM_PAGE_BYTES
+#define USER_BANK_READ_MAX        (USER_BANK_LINE_BYTES / 2)
+
+#define USER_BANK_READ_BITS       (NUM_READ_BITS + ((cmd[1] & 0x20) ? 8 : 0))
+#define USER_BANK_MAX_READ_BITS   (MAX_NUM_READ_BITS + 8)
+
+// At every boot, after init_eeprom(): a fetch that was queued is gone.
+void user_bank_init();
+
+// Copy count words from ptr into reply, if they're in the cache. Returns 0
+// if they aren't, or if the Read is out of range.
+unsigned char user_bank_read(unsigned short ptr, unsigned char count,
+                             volatile unsigned char *reply);
+
+// After the reply (or instead of it): fetch what the last Read wants next.
+void user_bank_prefetch();
+
+// The page at address is being written.
+void user_bank_forget(int address);
+
+#else
+#define USER_BANK_READ_BITS       NUM_READ_BITS
+#define USER_BANK_MAX_READ_BITS   MAX_NUM_READ_BITS
+#endif // ARCHIVE_SAMPLES
+
+#endif // USER_BANK_H